@@ -20,56 +20,192 @@
 */
 
 #include "Sources/Containers/DataArray.h"
+#include "Sources/Containers/ScratchArena.h"
+#include "Sources/Containers/StridedView.h"
 #include "Sources/Fourier/FourierBasic.h"
 
 XRAD_BEGIN
 
 
-template<class T>
-void	FFT(DataArray<T> &f, ftDirection direction)
+namespace FFT1DAuxiliaries
+{
+
+/*!
+	\brief Применить transform(ptr, size) к данным представления f
+
+	Если данные f лежат с шагом, преобразование выполняется в непрерывном временном буфере
+	(память берется из ScratchArena). Арена открыта только на время выделения буфера:
+	преобразование при первом вызове размещает долговременные таблицы и буферы потока,
+	которые не должны попасть в арену.
+*/
+template<class T, class F>
+void	transform_contiguous(const StridedView1D<T> &f, const F &transform)
 {
 	if(f.step()==1)
 	{
-		FFTPrimitives::FFT_ptr(f.data(), f.size(), direction);
+		transform(f.data(), f.size());
 	}
 	else
 	{
-		DataArray<T>	buffer(f);
-		FFTPrimitives::FFT_ptr(buffer.data(), f.size(), direction);
-		f.CopyData(buffer);
+		DataArray<T>	buffer;
+		{
+			ScratchArenaScope	scratch;
+			buffer.realloc(f.size());
+		}
+		CopyView(MakeView(buffer), f);
+		transform(buffer.data(), buffer.size());
+		CopyView(f, MakeView(buffer));
 	}
 }
 
+} // namespace FFT1DAuxiliaries
+
+
+
+//! \name Преобразования представлений (см. StridedView.h)
+//! @{
+template<class T>
+void	FFT(const StridedView1D<T> &f, ftDirection direction)
+{
+	FFT1DAuxiliaries::transform_contiguous(f,
+			[direction](T *data, size_t size) { FFTPrimitives::FFT_ptr(data, size, direction); });
+}
+
+template<class T>
+void	FFTf(const StridedView1D<T> &f, ft_flags fftFlags)
+{
+	FFT1DAuxiliaries::transform_contiguous(f,
+			[fftFlags](T *data, size_t size) { FFTPrimitives::FFTf_ptr(data, size, fftFlags); });
+}
+
+template<class T>
+void	FT(const StridedView1D<T> &f, ftDirection direction)
+{
+	FFT1DAuxiliaries::transform_contiguous(f,
+			[direction](T *data, size_t size) { FFTPrimitives::FT_ptr(data, size, direction); });
+}
+//! @}
+
+
+
+template<class T>
+void	FFT(DataArray<T> &f, ftDirection direction)
+{
+	FFT(MakeView(f), direction);
+}
+
 
 template<class T>
 void FFTf(DataArray<T> &f, ft_flags fftFlags)
 {
-	if(f.step()==1)
+	FFTf(MakeView(f), fftFlags);
+}
+
+
+template<class T>
+void	FT(DataArray<T> &f, ftDirection direction)
+{
+	FT(MakeView(f), direction);
+}
+
+
+
+//--------------------------------------------------------------
+//
+//	Преобразования вещественных массивов (real-to-complex, complex-to-real).
+//	Спектр вещественного массива длины N эрмитов, поэтому хранится только его первая
+//	половина: N/2+1 отсчетов. Длина N должна быть четной.
+//
+
+
+
+/*!
+	\brief Фурье-преобразование вещественного массива в половину спектра, с флагами сдвигов
+
+	Результат совпадает с первыми real.size()/2+1 отсчетами FFTf() от комплексной копии real.
+	Если размер spectrum отличается от нужного, выполняется realloc.
+*/
+template<class RT, class CT>
+void	FFTf_r2c(const DataArray<RT> &real, DataArray<CT> &spectrum, ft_flags fftFlags)
+{
+	using part_type = typename CT::part_type;
+	const size_t	spectrum_size = real.size()/2 + 1;
+	if(spectrum.size() != spectrum_size)
+		spectrum.realloc(spectrum_size);
+
+	if constexpr (std::is_same<std::remove_const_t<RT>, part_type>::value)
 	{
-		FFTPrimitives::FFTf_ptr(f.data(), f.size(), fftFlags);
+		if(real.step()==1 && spectrum.step()==1)
+		{
+			FFTPrimitives::FFTf_r2c_ptr(real.data(), spectrum.data(), real.size(), fftFlags);
+			return;
+		}
 	}
-	else
+	DataArray<part_type>	real_buffer;
+	DataArray<CT>	spectrum_buffer;
 	{
-		DataArray<T> buffer(f);
-		FFTPrimitives::FFTf_ptr(buffer.data(), buffer.size(), fftFlags);
-		f.CopyData(buffer);
+		// Только буферы берутся из арены потока, см. transform_contiguous()
+		ScratchArenaScope	scratch;
+		real_buffer.MakeCopy(real);
+		spectrum_buffer.realloc(spectrum_size);
 	}
+	FFTPrimitives::FFTf_r2c_ptr(real_buffer.data(), spectrum_buffer.data(), real_buffer.size(), fftFlags);
+	spectrum.CopyData(spectrum_buffer);
 }
 
+/*!
+	\brief Фурье-преобразование половины эрмитова спектра в вещественный массив, с флагами сдвигов
 
-template<class T>
-void	FT(DataArray<T> &f, ftDirection direction)
+	Обратная операция к FFTf_r2c(). Длина результата 2*(spectrum.size()-1).
+	Если размер real отличается от нужного, выполняется realloc.
+*/
+template<class CT, class RT>
+void	FFTf_c2r(const DataArray<CT> &spectrum, DataArray<RT> &real, ft_flags fftFlags)
 {
-	if(f.step()==1)
+	using complex_type = std::remove_const_t<CT>;
+	using part_type = typename complex_type::part_type;
+	if(spectrum.size() < 2)
 	{
-		FFTPrimitives::FT_ptr(f.data(), f.size(), direction);
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("FFTf_c2r: invalid spectrum size = %zu",
+				EnsureType<size_t>(spectrum.size())));
 	}
-	else
+	const size_t	real_size = 2*(spectrum.size() - 1);
+	if(real.size() != real_size)
+		real.realloc(real_size);
+
+	if constexpr (std::is_same<RT, part_type>::value)
 	{
-		DataArray<T>	buffer(f);
-		FFTPrimitives::FT_ptr(buffer.data(), buffer.size(), direction);
-		f.CopyData(buffer);
+		if(spectrum.step()==1 && real.step()==1)
+		{
+			FFTPrimitives::FFTf_c2r_ptr(spectrum.data(), real.data(), real_size, fftFlags);
+			return;
+		}
 	}
+	DataArray<complex_type>	spectrum_buffer;
+	DataArray<part_type>	real_buffer;
+	{
+		// Только буферы берутся из арены потока, см. transform_contiguous()
+		ScratchArenaScope	scratch;
+		spectrum_buffer.MakeCopy(spectrum);
+		real_buffer.realloc(real_size);
+	}
+	FFTPrimitives::FFTf_c2r_ptr(spectrum_buffer.data(), real_buffer.data(), real_size, fftFlags);
+	real.CopyData(real_buffer);
+}
+
+//! \brief Фурье-преобразование вещественного массива в половину спектра, см. FFTf_r2c()
+template<class RT, class CT>
+void	FFT_r2c(const DataArray<RT> &real, DataArray<CT> &spectrum, ftDirection direction)
+{
+	FFTf_r2c(real, spectrum, direction==ftForward ? fftFwd : fftRev);
+}
+
+//! \brief Фурье-преобразование половины эрмитова спектра в вещественный массив, см. FFTf_c2r()
+template<class CT, class RT>
+void	FFT_c2r(const DataArray<CT> &spectrum, DataArray<RT> &real, ftDirection direction)
+{
+	FFTf_c2r(spectrum, real, direction==ftForward ? fftFwd : fftRev);
 }
 
 
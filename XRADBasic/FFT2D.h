@@ -20,96 +20,138 @@
 */
 
 #include "Sources/Containers/DataArray2D.h"
+#include "Sources/Containers/TransposeCopy.h"
 #include "FFT1D.h"
 
 
 XRAD_BEGIN
 
-template<class RT>
-void FFTf(DataArray2D<RT> &f, ft_flags rows_flags, ft_flags columns_flags, omp_usage_t omp = e_dont_use_omp)
+namespace FFT2DAuxiliaries
+{
+
+//! \brief Размер буфера для блока столбцов, байт. Блок должен помещаться в кэш L2
+constexpr size_t column_tile_bytes = 256*1024;
+
+//! \brief Минимальная ширина блока столбцов, байт: при переносе блока строки читаются целыми кэш-линиями
+constexpr size_t column_tile_min_row_bytes = 64;
+
+//! \brief Число столбцов в блоке
+template<class T>
+size_t	column_tile_width(size_t vsize, size_t hsize)
+{
+	size_t	width = max(column_tile_min_row_bytes/sizeof(T), column_tile_bytes/max(vsize*sizeof(T), size_t(1)));
+	return range(width, size_t(1), max(hsize, size_t(1)));
+}
+
+//! \brief Буфер блока столбцов, свой для каждого потока. Память выделяется только при увеличении размера
+//!
+//! Буфер живет до завершения потока, поэтому выделяется вне ScratchArena (см. GlobalDataAllocatorScope).
+template<class T>
+T	*column_tile_buffer(size_t size)
+{
+	thread_local DataArray<T>	buffer;
+	if(buffer.size() < size)
+	{
+		GlobalDataAllocatorScope	persistent;
+		buffer.realloc(size);
+	}
+	return buffer.data();
+}
+
+/*!
+	\brief Применить преобразование к столбцам first_column..first_column+n_columns-1
+
+	Столбцы блока переносятся в непрерывный буфер (транспонирование блока, см. transpose_copy()),
+	к каждому столбцу буфера применяется column_transform(ptr, vsize), затем данные
+	возвращаются на место.
+*/
+template<class T, class F>
+void	transform_column_tile(const StridedView2D<T> &f, size_t first_column, size_t n_columns, const F &column_transform)
 {
+	const size_t	vs = f.vsize();
+	T	*tile = column_tile_buffer<T>(vs*n_columns);
+	const StridedView2D<T>	tile_view = {tile, {n_columns, vs}, {ptrdiff_t(vs), 1}};
+	const StridedView2D<T>	columns = f.fragment(0, first_column, vs, first_column + n_columns);
+
+	transpose_copy(tile_view, columns);
+	for(size_t j = 0; j < n_columns; ++j)
+	{
+		column_transform(tile + j*vs, vs);
+	}
+	transpose_copy(columns, tile_view);
+}
+
+/*!
+	\brief Применить преобразование column_transform(ptr, vsize) ко всем столбцам массива
+
+	Столбцы обрабатываются блоками через непрерывный буфер (см. transform_column_tile()),
+	при omp == e_use_omp блоки распределяются между потоками.
+*/
+template<class T, class F>
+void	transform_columns(const StridedView2D<T> &f, const F &column_transform, omp_usage_t omp, const char *message)
+{
+	if(f.empty())
+		return;
+	const size_t	tile_width = column_tile_width<T>(f.vsize(), f.hsize());
+	const size_t	n_tiles = (f.hsize() + tile_width - 1)/tile_width;
+
 	if(omp==e_use_omp)
 	{
-		if(rows_flags)
+		ThreadErrorCollector ec(message);
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t t=0; t < ptrdiff_t(n_tiles); ++t)
 		{
-			ThreadErrorCollector ec("FFT 2D (rows)");
-			#pragma omp parallel for schedule (guided)
-			for(ptrdiff_t i=0; i < ptrdiff_t(f.vsize()); ++i)
+			if (ec.HasErrors())
 			{
-				if (ec.HasErrors())
-				{
 #ifdef XRAD_COMPILER_MSC
-					break;
+				break;
 #else
-					continue;
+				continue;
 #endif
-				}
-				ThreadSetup ts; (void)ts;
-				try
-				{
-					FFTf(f.row(i), rows_flags);
-				}
-				catch (...)
-				{
-					ec.CatchException();
-				}
 			}
-			ec.ThrowIfErrors();
-		}
-		if(columns_flags)
-		{
-			ThreadErrorCollector ec("FFT 2D (columns)");
-			#pragma omp parallel for schedule (guided)
-			for(ptrdiff_t i=0; i < ptrdiff_t(f.hsize()); ++i)
+			ThreadSetup ts; (void)ts;
+			try
 			{
-				if (ec.HasErrors())
-				{
-#ifdef XRAD_COMPILER_MSC
-					break;
-#else
-					continue;
-#endif
-				}
-				ThreadSetup ts; (void)ts;
-				try
-				{
-					FFTf(f.col(i), columns_flags);
-				}
-				catch (...)
-				{
-					ec.CatchException();
-				}
+				size_t	first_column = t*tile_width;
+				transform_column_tile(f, first_column, min(tile_width, f.hsize() - first_column), column_transform);
+			}
+			catch (...)
+			{
+				ec.CatchException();
 			}
-			ec.ThrowIfErrors();
 		}
+		ec.ThrowIfErrors();
 	}
 	else
 	{
-		if(rows_flags)
+		for(size_t first_column = 0; first_column < f.hsize(); first_column += tile_width)
 		{
-			for(size_t i=0; i<f.vsize(); ++i)
-			{
-				FFTf(f.row(i), rows_flags);
-			}
-		}
-		if(columns_flags)
-		{
-			for(size_t i=0; i<f.hsize(); ++i)
-			{
-				FFTf(f.col(i), columns_flags);
-			}
+			transform_column_tile(f, first_column, min(tile_width, f.hsize() - first_column), column_transform);
 		}
 	}
 }
 
-template<class RT>
-void FFT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
+//! \brief Число сигналов в порции пакетного преобразования, обрабатываемой одним потоком.
+//! Кратно числу комплексных отсчетов в векторном регистре
+constexpr size_t batch_chunk_size = 16;
+
+/*!
+	\brief Пакетное преобразование count сигналов (см. FFTPrimitives::FFTf_batch())
+
+	При omp == e_use_omp сигналы распределяются между потоками порциями по batch_chunk_size.
+*/
+template<class T>
+void	FFTf_batch(T *data, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ft_flags flags,
+		omp_usage_t omp, const char *message)
 {
+	if(!size || !count)
+		return;
 	if(omp==e_use_omp)
 	{
-		ThreadErrorCollector ec("FFT 2D (columns)");
+		const size_t	n_chunks = (count + batch_chunk_size - 1)/batch_chunk_size;
+		ThreadErrorCollector ec(message);
 		#pragma omp parallel for schedule (guided)
-		for(ptrdiff_t i=0; i<ptrdiff_t(f.hsize()); ++i)
+		for(ptrdiff_t c=0; c < ptrdiff_t(n_chunks); ++c)
 		{
 			if (ec.HasErrors())
 			{
@@ -122,7 +164,9 @@ void FFT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use
 			ThreadSetup ts; (void)ts;
 			try
 			{
-				FFT(f.col(i), direction);
+				size_t	first = c*batch_chunk_size;
+				FFTPrimitives::FFTf_batch(data + ptrdiff_t(first)*dist, size, min(batch_chunk_size, count - first),
+						stride, dist, flags);
 			}
 			catch (...)
 			{
@@ -130,8 +174,62 @@ void FFT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use
 			}
 		}
 		ec.ThrowIfErrors();
+	}
+	else
+	{
+		FFTPrimitives::FFTf_batch(data, size, count, stride, dist, flags);
+	}
+}
+
+//! \brief Преобразование строк двумерного массива (пакет из vsize() сигналов)
+template<class T>
+void	FFTf_rows(const StridedView2D<T> &f, ft_flags flags, omp_usage_t omp, const char *message)
+{
+	if(f.empty())
+		return;
+	FFTf_batch(f.data(), f.hsize(), f.vsize(), f.hstep(), f.vstep(), flags, omp, message);
+}
+
+//! \brief Преобразование столбцов двумерного массива (пакет из hsize() сигналов с шагом vstep())
+template<class T>
+void	FFTf_columns(const StridedView2D<T> &f, ft_flags flags, omp_usage_t omp, const char *message)
+{
+	FFTf_rows(f.transposed(), flags, omp, message);
+}
+
+} // namespace FFT2DAuxiliaries
 
-		ec.Reset("FFT 2D (rows)");
+//! \name Преобразования представлений (см. StridedView.h)
+//! Те же преобразования, что и для DataArray2D, без создания объектов-строк.
+//! Транспонированное представление (f.transposed()) меняет ролями строки и столбцы.
+//! @{
+template<class T>
+void FFTf(const StridedView2D<T> &f, ft_flags rows_flags, ft_flags columns_flags, omp_usage_t omp = e_dont_use_omp)
+{
+	if(rows_flags)
+		FFT2DAuxiliaries::FFTf_rows(f, rows_flags, omp, "FFT 2D (rows)");
+	if(columns_flags)
+		FFT2DAuxiliaries::FFTf_columns(f, columns_flags, omp, "FFT 2D (columns)");
+}
+
+template<class T>
+void FFT(const StridedView2D<T> &f, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
+{
+	ft_flags	flags = direction==ftForward ? fftFwd : fftRev;
+	FFT2DAuxiliaries::FFTf_columns(f, flags, omp, "FFT 2D (columns)");
+	FFT2DAuxiliaries::FFTf_rows(f, flags, omp, "FFT 2D (rows)");
+}
+
+template<class T>
+void FT(const StridedView2D<T> &f, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
+{
+	FFT2DAuxiliaries::transform_columns(f,
+			[direction](T *column, size_t size) { FFTPrimitives::FT_ptr(column, size, direction); },
+			omp, "FT 2D (columns)");
+
+	if(omp==e_use_omp)
+	{
+		ThreadErrorCollector ec("FT 2D (rows)");
 		#pragma omp parallel for schedule (guided)
 		for(ptrdiff_t i=0; i<ptrdiff_t(f.vsize()); ++i)
 		{
@@ -146,7 +244,7 @@ void FFT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use
 			ThreadSetup ts; (void)ts;
 			try
 			{
-				FFT(f.row(i), direction);
+				FT(f.row(i), direction);
 			}
 			catch (...)
 			{
@@ -157,27 +255,60 @@ void FFT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use
 	}
 	else
 	{
-		for(size_t i=0; i<f.hsize(); ++i)
-		{
-			FFT(f.col(i), direction);
-		}
-
 		for(size_t i=0; i<f.vsize(); ++i)
 		{
-			FFT(f.row(i), direction);
+			FT(f.row(i), direction);
 		}
 	}
+}
+//! @}
 
+template<class RT>
+void FFTf(DataArray2D<RT> &f, ft_flags rows_flags, ft_flags columns_flags, omp_usage_t omp = e_dont_use_omp)
+{
+	FFTf(MakeView(f), rows_flags, columns_flags, omp);
+}
+
+template<class RT>
+void FFT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
+{
+	FFT(MakeView(f), direction, omp);
 }
 
 template<class RT>
 void FT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
 {
+	FT(MakeView(f), direction, omp);
+}
+
+//--------------------------------------------------------------
+//
+//	Преобразования вещественных массивов (real-to-complex, complex-to-real).
+//	Вдоль строк хранится половина эрмитова спектра: hsize()/2+1 отсчетов, вдоль столбцов
+//	выполняется обычное комплексное преобразование.
+//
+
+
+
+/*!
+	\brief Двумерное фурье-преобразование вещественного массива, с флагами сдвигов
+
+	Результат совпадает со столбцами 0..real.hsize()/2 результата FFTf() от комплексной копии real.
+	Размеры spectrum: real.vsize() x (real.hsize()/2+1), при несовпадении выполняется realloc.
+	Флаг направления в rows_flags обязателен, в columns_flags может отсутствовать.
+*/
+template<class RT, class CRT>
+void FFTf_r2c(const DataArray2D<RT> &real, DataArray2D<CRT> &spectrum, ft_flags rows_flags, ft_flags columns_flags, omp_usage_t omp = e_dont_use_omp)
+{
+	const size_t	spectrum_hsize = real.hsize()/2 + 1;
+	if(spectrum.vsize() != real.vsize() || spectrum.hsize() != spectrum_hsize)
+		spectrum.realloc(real.vsize(), spectrum_hsize);
+
 	if(omp==e_use_omp)
 	{
-		ThreadErrorCollector ec("FT 2D (columns)");
+		ThreadErrorCollector ec("FFT 2D real-to-complex (rows)");
 		#pragma omp parallel for schedule (guided)
-		for(ptrdiff_t i=0; i<ptrdiff_t(f.hsize()); ++i)
+		for(ptrdiff_t i=0; i < ptrdiff_t(real.vsize()); ++i)
 		{
 			if (ec.HasErrors())
 			{
@@ -190,7 +321,7 @@ void FT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_
 			ThreadSetup ts; (void)ts;
 			try
 			{
-				FT(f.col(i), direction);
+				FFTf_r2c(real.row(i), spectrum.row(i), rows_flags);
 			}
 			catch (...)
 			{
@@ -198,10 +329,50 @@ void FT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_
 			}
 		}
 		ec.ThrowIfErrors();
+	}
+	else
+	{
+		for(size_t i=0; i<real.vsize(); ++i)
+		{
+			FFTf_r2c(real.row(i), spectrum.row(i), rows_flags);
+		}
+	}
+	if(columns_flags)
+		FFTf(spectrum, fftNone, columns_flags, omp);
+}
 
-		ec.Reset("FT 2D (rows)");
+/*!
+	\brief Двумерное фурье-преобразование половины эрмитова спектра в вещественный массив, с флагами сдвигов
+
+	Обратная операция к FFTf_r2c(). Размеры результата: spectrum.vsize() x 2*(spectrum.hsize()-1),
+	при несовпадении выполняется realloc. Аргумент spectrum не изменяется.
+*/
+template<class CRT, class RT>
+void FFTf_c2r(const DataArray2D<CRT> &spectrum, DataArray2D<RT> &real, ft_flags rows_flags, ft_flags columns_flags, omp_usage_t omp = e_dont_use_omp)
+{
+	if(spectrum.hsize() < 2)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("FFTf_c2r 2D: invalid spectrum hsize = %zu",
+				EnsureType<size_t>(spectrum.hsize())));
+	}
+	const size_t	real_hsize = 2*(spectrum.hsize() - 1);
+	if(real.vsize() != spectrum.vsize() || real.hsize() != real_hsize)
+		real.realloc(spectrum.vsize(), real_hsize);
+
+	using buffer_type = DataArray2D<DataArray<std::remove_const_t<typename CRT::value_type>>>;
+	buffer_type	buffer;
+	if(columns_flags)
+	{
+		buffer.MakeCopy(spectrum);
+		FFTf(buffer, fftNone, columns_flags, omp);
+	}
+
+	if(omp==e_use_omp)
+	{
+		ThreadErrorCollector ec("FFT 2D complex-to-real (rows)");
 		#pragma omp parallel for schedule (guided)
-		for(ptrdiff_t i=0; i<ptrdiff_t(f.vsize()); ++i)
+		for(ptrdiff_t i=0; i < ptrdiff_t(real.vsize()); ++i)
 		{
 			if (ec.HasErrors())
 			{
@@ -214,7 +385,10 @@ void FT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_
 			ThreadSetup ts; (void)ts;
 			try
 			{
-				FT(f.row(i), direction);
+				if(columns_flags)
+					FFTf_c2r(buffer.row(i), real.row(i), rows_flags);
+				else
+					FFTf_c2r(spectrum.row(i), real.row(i), rows_flags);
 			}
 			catch (...)
 			{
@@ -225,18 +399,32 @@ void FT(DataArray2D<RT> &f, ftDirection direction, omp_usage_t omp = e_dont_use_
 	}
 	else
 	{
-		for(size_t i=0; i<f.hsize(); ++i)
-		{
-			FT(f.col(i), direction);
-		}
-
-		for(size_t i=0; i<f.vsize(); ++i)
+		for(size_t i=0; i<real.vsize(); ++i)
 		{
-			FT(f.row(i), direction);
+			if(columns_flags)
+				FFTf_c2r(buffer.row(i), real.row(i), rows_flags);
+			else
+				FFTf_c2r(spectrum.row(i), real.row(i), rows_flags);
 		}
 	}
 }
 
+//! \brief Двумерное фурье-преобразование вещественного массива, см. FFTf_r2c()
+template<class RT, class CRT>
+void FFT_r2c(const DataArray2D<RT> &real, DataArray2D<CRT> &spectrum, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
+{
+	ft_flags	flags = direction==ftForward ? fftFwd : fftRev;
+	FFTf_r2c(real, spectrum, flags, flags, omp);
+}
+
+//! \brief Двумерное фурье-преобразование половины эрмитова спектра в вещественный массив, см. FFTf_c2r()
+template<class CRT, class RT>
+void FFT_c2r(const DataArray2D<CRT> &spectrum, DataArray2D<RT> &real, ftDirection direction, omp_usage_t omp = e_dont_use_omp)
+{
+	ft_flags	flags = direction==ftForward ? fftFwd : fftRev;
+	FFTf_c2r(spectrum, real, flags, flags, omp);
+}
+
 
 XRAD_END
 
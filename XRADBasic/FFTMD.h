@@ -28,24 +28,107 @@ XRAD_BEGIN
 
 
 
-//	быстрое преобразование Фурье, только три измерения.
-//TODO развить на много измерений, использовать наработки по roll().
-//TODO сделать версию FFTf (см. двумерную реализацию)
+//--------------------------------------------------------------
+
+namespace FFT3DAuxiliaries
+{
+
+//! \brief Объем буфера одного потока по умолчанию, байт (см. FFT_3D())
+constexpr size_t default_thread_buffer_size = size_t(1) << 19;
+
+//! \brief Число линий длины size в "карандаше", помещающемся в буфер потока
+template<class T>
+size_t	pencil_size(size_t size, size_t n_lines, size_t thread_buffer_size)
+{
+	// Группы по 8 сигналов заполняют векторные регистры без остатка (см. MixedRadixFFT::FFT_batch())
+	const size_t	granularity = 8;
+	size_t	result = thread_buffer_size/(size*sizeof(T) + 64);
+	if(result > granularity)
+		result -= result%granularity;
+	return range(result, size_t(1), n_lines);
+}
+
+/*!
+	\brief Преобразование всех линий трехмерного массива вдоль оси axis
+
+	Линии объединяются в "карандаши" -- пакеты линий, соседних по той поперечной оси,
+	шаг которой в памяти меньше; в пакете столько линий, сколько помещается в thread_buffer_size.
+	Пакет преобразуется одним вызовом FFTPrimitives::FFTf_batch():
+	- на месте, если линии имеют единичный шаг или если пакетное FFT векторизовано по сигналам
+	(FFTPrimitives::FFTf_batch_vectorized(): группы линий собираются в векторные регистры);
+	- иначе линии пакета копируются в буфер потока (исходные данные читаются отрезками
+	соседних отсчетов разных линий), преобразуются в нем и копируются обратно.
+
+	Все пакеты распределяются между потоками одним циклом. Каждый поток создает не больше
+	одного буфера объемом не больше thread_buffer_size (но не меньше одной линии) и использует
+	его для всех своих пакетов.
+*/
 template<class A2DT>
-void	FFT_3D(DataArrayMD<A2DT> &f, ftDirection dir, omp_usage_t omp = e_use_omp)
+void	FFTf_axis(DataArrayMD<A2DT> &f, size_t axis, ft_flags flags, omp_usage_t omp,
+		size_t thread_buffer_size, const char *message)
 {
-	size_t	n_threads = omp_get_max_threads();
-	size_t	n_slices = f.sizes(0);
-	size_t	n_stages = (n_slices + n_threads - 1) / n_threads;
+	using value_type = typename DataArrayMD<A2DT>::value_type;
+	size_t	pencil_axis = (axis + 1)%3, outer_axis = (axis + 2)%3;
+	if(std::abs(f.steps_raw(outer_axis)) < std::abs(f.steps_raw(pencil_axis)))
+		std::swap(pencil_axis, outer_axis);
+
+	const size_t	size = f.sizes(axis), n_lines = f.sizes(pencil_axis), n_outer = f.sizes(outer_axis);
+	if(!size || !n_lines || !n_outer)
+		return;
+	const ptrdiff_t	stride = f.steps_raw(axis);
+	const ptrdiff_t	line_step = f.steps_raw(pencil_axis);
+	const ptrdiff_t	outer_step = f.steps_raw(outer_axis);
+	value_type	*origin = &f.at({0, 0, 0});
+
+	const size_t	n_pencil_lines = pencil_size<value_type>(size, n_lines, thread_buffer_size);
+	const size_t	n_pencils = (n_lines + n_pencil_lines - 1)/n_pencil_lines;
+	const size_t	n_units = n_outer*n_pencils;
+
+	// Если пакетное FFT векторизовано по сигналам, оно само собирает группы линий в регистры,
+	// и линии преобразуются на месте. Иначе линии пакета копируются в буфер подряд
+	// (каждая линия непрерывна) и преобразуются в нем
+	const bool	in_place = stride == 1 || FFTPrimitives::FFTf_batch_vectorized(size);
+	// Линии в буфере разделены промежутком в одну строку кэша: при длинах 2^n без него запись
+	// отсчета i всех линий пакета попадает в один набор кэша
+	const size_t	line_distance = size + max(size_t(1), 64/sizeof(value_type));
+
+	auto	transform_pencil = [&](size_t unit, DataArray<value_type> &buffer)
+	{
+		const size_t	first_line = (unit%n_pencils)*n_pencil_lines;
+		const size_t	count = min(n_pencil_lines, n_lines - first_line);
+		value_type	*lines = origin + ptrdiff_t(unit/n_pencils)*outer_step + ptrdiff_t(first_line)*line_step;
+		if(in_place)
+		{
+			FFTPrimitives::FFTf_batch(lines, size, count, stride, line_step, flags);
+			return;
+		}
+		if(buffer.size() < line_distance*n_pencil_lines)
+			buffer.realloc(line_distance*n_pencil_lines);
+		value_type	*pencil = buffer.data();
+		// Исходные данные читаются отрезками по count отсчетов (при line_step == 1 непрерывными)
+		for(size_t i = 0; i < size; ++i)
+		{
+			const value_type	*src = lines + ptrdiff_t(i)*stride;
+			for(size_t j = 0; j < count; ++j)
+				pencil[j*line_distance + i] = src[ptrdiff_t(j)*line_step];
+		}
+		FFTPrimitives::FFTf_batch(pencil, size, count, 1, line_distance, flags);
+		for(size_t i = 0; i < size; ++i)
+		{
+			value_type	*dst = lines + ptrdiff_t(i)*stride;
+			for(size_t j = 0; j < count; ++j)
+				dst[ptrdiff_t(j)*line_step] = pencil[j*line_distance + i];
+		}
+	};
 
-	for(size_t i = 0; i < n_stages; ++i)
+	if(omp == e_use_omp)
 	{
-		size_t piece_size = min(n_threads, n_slices-i*n_threads);
-		if(omp == e_use_omp)
+		ThreadErrorCollector ec(message);
+		#pragma omp parallel
 		{
-			ThreadErrorCollector ec("FFT 3D (slices)");
-			#pragma omp parallel for schedule (guided)
-			for(ptrdiff_t j = 0; j < ptrdiff_t(piece_size); ++j)
+			DataArray<value_type>	buffer;
+			#pragma omp for schedule (guided)
+			for(ptrdiff_t u = 0; u < ptrdiff_t(n_units); ++u)
 			{
 				if (ec.HasErrors())
 				{
@@ -58,69 +141,335 @@ void	FFT_3D(DataArrayMD<A2DT> &f, ftDirection dir, omp_usage_t omp = e_use_omp)
 				ThreadSetup ts; (void)ts;
 				try
 				{
-					typename DataArrayMD<A2DT>::slice_type	slice;
-					size_t	slice_no = i*n_threads + j;
-					f.GetSlice(slice, {slice_no, slice_mask(0), slice_mask(1)});
-					FFT(slice, dir, e_dont_use_omp);
+					transform_pencil(u, buffer);
 				}
 				catch (...)
 				{
 					ec.CatchException();
 				}
 			}
-			ec.ThrowIfErrors();
 		}
-		else
+		ec.ThrowIfErrors();
+	}
+	else
+	{
+		DataArray<value_type>	buffer;
+		for(size_t u = 0; u < n_units; ++u)
+			transform_pencil(u, buffer);
+	}
+}
+
+/*!
+	\brief Двумерное преобразование всех срезов f[i, *, *] (оси 1 и 2)
+
+	Срез преобразуется целиком одним потоком, пока его данные находятся в кэше
+	(см. FFT(DataArray2D&, ...)). Все срезы распределяются между потоками одним циклом.
+*/
+template<class A2DT>
+void	FFT_slices(DataArrayMD<A2DT> &f, ftDirection dir, omp_usage_t omp, const char *message)
+{
+	auto	transform_slice = [&f, dir](size_t slice_no)
+	{
+		typename DataArrayMD<A2DT>::slice_type	slice;
+		f.GetSlice(slice, {slice_no, slice_mask(0), slice_mask(1)});
+		FFT(slice, dir, e_dont_use_omp);
+	};
+	if(omp == e_use_omp)
+	{
+		ThreadErrorCollector ec(message);
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t i = 0; i < ptrdiff_t(f.sizes(0)); ++i)
 		{
-			for(ptrdiff_t j = 0; j < ptrdiff_t(piece_size); ++j)
+			if (ec.HasErrors())
+			{
+#ifdef XRAD_COMPILER_MSC
+				break;
+#else
+				continue;
+#endif
+			}
+			ThreadSetup ts; (void)ts;
+			try
+			{
+				transform_slice(i);
+			}
+			catch (...)
 			{
-				typename DataArrayMD<A2DT>::slice_type	slice;
-				size_t	slice_no = i*n_threads + j;
-				f.GetSlice(slice, {slice_no, slice_mask(0), slice_mask(1)});
-				FFT(slice, dir, e_dont_use_omp);
+				ec.CatchException();
 			}
 		}
+		ec.ThrowIfErrors();
+	}
+	else
+	{
+		for(size_t i = 0; i < f.sizes(0); ++i)
+			transform_slice(i);
+	}
+}
+
+} // namespace FFT3DAuxiliaries
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Быстрое преобразование Фурье, только три измерения
+
+	Два прохода: двумерные преобразования срезов по осям 1 и 2 (FFT3DAuxiliaries::FFT_slices()),
+	затем преобразование вдоль оси 0 "карандашами" через буфер потока фиксированного размера
+	(FFT3DAuxiliaries::FFTf_axis()). Работа каждого прохода распределяется между потоками
+	по всему объему.
+
+	Дополнительная память, кроме таблиц и служебных буферов FFT, не превышает
+	(число потоков)*max(thread_buffer_size, размер одной линии вдоль оси 0).
+*/
+//TODO развить на много измерений, использовать наработки по roll().
+//TODO сделать версию FFTf (см. двумерную реализацию)
+template<class A2DT>
+void	FFT_3D(DataArrayMD<A2DT> &f, ftDirection dir, omp_usage_t omp = e_use_omp,
+		size_t thread_buffer_size = FFT3DAuxiliaries::default_thread_buffer_size)
+{
+	if(f.n_dimensions() != 3)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("FFT_3D: invalid number of dimensions = %zu",
+				EnsureType<size_t>(f.n_dimensions())));
+	}
+	FFT3DAuxiliaries::FFT_slices(f, dir, omp, "FFT 3D (slices)");
+	FFT3DAuxiliaries::FFTf_axis(f, 0, dir==ftForward ? fftFwd : fftRev, omp, thread_buffer_size, "FFT 3D (axis 0)");
+}
+
+
+
+
+//--------------------------------------------------------------
+//
+//	Преобразования вещественных массивов (real-to-complex, complex-to-real), три измерения.
+//	Вдоль последнего измерения (строки срезов) хранится половина эрмитова спектра:
+//	sizes(2)/2+1 отсчетов, вдоль остальных измерений выполняется комплексное преобразование.
+//
+
+
+
+/*!
+	\brief Трехмерное фурье-преобразование вещественного массива, с флагами сдвигов
+
+	Результат совпадает с отсчетами 0..real.sizes(2)/2 по последнему измерению результата
+	комплексного преобразования с теми же флагами по всем измерениям.
+	Размеры spectrum: {sizes(0), sizes(1), sizes(2)/2+1}, при несовпадении выполняется realloc.
+	Флаг направления в flags обязателен.
+*/
+template<class A2DT, class A2DT2>
+void	FFTf_3D_r2c(const DataArrayMD<A2DT> &real, DataArrayMD<A2DT2> &spectrum, ft_flags flags, omp_usage_t omp = e_use_omp)
+{
+	if(real.n_dimensions() != 3)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("FFTf_3D_r2c: invalid number of dimensions = %zu",
+				EnsureType<size_t>(real.n_dimensions())));
 	}
-	for(size_t i = 0; i < f.sizes(1); ++i)
+	index_vector	spectrum_sizes = {real.sizes(0), real.sizes(1), real.sizes(2)/2 + 1};
+	if(spectrum.sizes() != spectrum_sizes)
+		spectrum.realloc(spectrum_sizes);
+
+	if(omp == e_use_omp)
 	{
-		if(omp == e_use_omp)
+		ThreadErrorCollector ec("FFT 3D real-to-complex (slices)");
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t i = 0; i < ptrdiff_t(real.sizes(0)); ++i)
 		{
-			ThreadErrorCollector ec("FFT 3D (rows)");
-			#pragma omp parallel for schedule (guided)
-			for(ptrdiff_t j = 0; j < ptrdiff_t(f.sizes(2)); ++j)
+			if (ec.HasErrors())
 			{
-				if (ec.HasErrors())
-				{
 #ifdef XRAD_COMPILER_MSC
-					break;
+				break;
 #else
-					continue;
+				continue;
 #endif
-				}
-				ThreadSetup ts; (void)ts;
-				try
-				{
-					typename DataArrayMD<A2DT>::row_type	row;
-					f.GetRow(row, {slice_mask(0), i, size_t(j)});
-					FFT(row, dir);
-				}
-				catch (...)
-				{
-					ec.CatchException();
-				}
 			}
-			ec.ThrowIfErrors();
+			ThreadSetup ts; (void)ts;
+			try
+			{
+				typename DataArrayMD<A2DT>::slice_type::invariable	real_slice;
+				typename DataArrayMD<A2DT2>::slice_type	spectrum_slice;
+				real.GetSlice(real_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+				spectrum.GetSlice(spectrum_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+				FFTf_r2c(real_slice, spectrum_slice, flags, flags, e_dont_use_omp);
+			}
+			catch (...)
+			{
+				ec.CatchException();
+			}
+		}
+		ec.ThrowIfErrors();
+	}
+	else
+	{
+		for(ptrdiff_t i = 0; i < ptrdiff_t(real.sizes(0)); ++i)
+		{
+			typename DataArrayMD<A2DT>::slice_type::invariable	real_slice;
+			typename DataArrayMD<A2DT2>::slice_type	spectrum_slice;
+			real.GetSlice(real_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+			spectrum.GetSlice(spectrum_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+			FFTf_r2c(real_slice, spectrum_slice, flags, flags, e_dont_use_omp);
+		}
+	}
+
+	if(omp == e_use_omp)
+	{
+		ThreadErrorCollector ec("FFT 3D real-to-complex (rows)");
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t i = 0; i < ptrdiff_t(spectrum.sizes(1)*spectrum.sizes(2)); ++i)
+		{
+			if (ec.HasErrors())
+			{
+#ifdef XRAD_COMPILER_MSC
+				break;
+#else
+				continue;
+#endif
+			}
+			ThreadSetup ts; (void)ts;
+			try
+			{
+				typename DataArrayMD<A2DT2>::row_type	row;
+				spectrum.GetRow(row, {slice_mask(0), size_t(i)/spectrum.sizes(2), size_t(i)%spectrum.sizes(2)});
+				FFTf(row, flags);
+			}
+			catch (...)
+			{
+				ec.CatchException();
+			}
+		}
+		ec.ThrowIfErrors();
+	}
+	else
+	{
+		for(ptrdiff_t i = 0; i < ptrdiff_t(spectrum.sizes(1)*spectrum.sizes(2)); ++i)
+		{
+			typename DataArrayMD<A2DT2>::row_type	row;
+			spectrum.GetRow(row, {slice_mask(0), size_t(i)/spectrum.sizes(2), size_t(i)%spectrum.sizes(2)});
+			FFTf(row, flags);
+		}
+	}
+}
+
+/*!
+	\brief Трехмерное фурье-преобразование половины эрмитова спектра в вещественный массив, с флагами сдвигов
+
+	Обратная операция к FFTf_3D_r2c(). Размеры результата: {sizes(0), sizes(1), 2*(sizes(2)-1)},
+	при несовпадении выполняется realloc. Аргумент spectrum не изменяется.
+*/
+template<class A2DT2, class A2DT>
+void	FFTf_3D_c2r(const DataArrayMD<A2DT2> &spectrum, DataArrayMD<A2DT> &real, ft_flags flags, omp_usage_t omp = e_use_omp)
+{
+	if(spectrum.n_dimensions() != 3 || spectrum.sizes(2) < 2)
+	{
+		ForceDebugBreak();
+		throw invalid_argument("FFTf_3D_c2r: invalid spectrum sizes " +
+				MDAAuxiliaries::index_string(spectrum.sizes()));
+	}
+	index_vector	real_sizes = {spectrum.sizes(0), spectrum.sizes(1), 2*(spectrum.sizes(2) - 1)};
+	if(real.sizes() != real_sizes)
+		real.realloc(real_sizes);
+
+	using buffer_type = DataArrayMD<DataArray2D<DataArray<std::remove_const_t<typename A2DT2::value_type>>>>;
+	buffer_type	buffer;
+	buffer.MakeCopy(spectrum);
+
+	if(omp == e_use_omp)
+	{
+		ThreadErrorCollector ec("FFT 3D complex-to-real (rows)");
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t i = 0; i < ptrdiff_t(buffer.sizes(1)*buffer.sizes(2)); ++i)
+		{
+			if (ec.HasErrors())
+			{
+#ifdef XRAD_COMPILER_MSC
+				break;
+#else
+				continue;
+#endif
+			}
+			ThreadSetup ts; (void)ts;
+			try
+			{
+				typename buffer_type::row_type	row;
+				buffer.GetRow(row, {slice_mask(0), size_t(i)/buffer.sizes(2), size_t(i)%buffer.sizes(2)});
+				FFTf(row, flags);
+			}
+			catch (...)
+			{
+				ec.CatchException();
+			}
+		}
+		ec.ThrowIfErrors();
+	}
+	else
+	{
+		for(ptrdiff_t i = 0; i < ptrdiff_t(buffer.sizes(1)*buffer.sizes(2)); ++i)
+		{
+			typename buffer_type::row_type	row;
+			buffer.GetRow(row, {slice_mask(0), size_t(i)/buffer.sizes(2), size_t(i)%buffer.sizes(2)});
+			FFTf(row, flags);
 		}
-		else
+	}
+
+	if(omp == e_use_omp)
+	{
+		ThreadErrorCollector ec("FFT 3D complex-to-real (slices)");
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t i = 0; i < ptrdiff_t(buffer.sizes(0)); ++i)
 		{
-			for(ptrdiff_t j = 0; j < ptrdiff_t(f.sizes(2)); ++j)
+			if (ec.HasErrors())
+			{
+#ifdef XRAD_COMPILER_MSC
+				break;
+#else
+				continue;
+#endif
+			}
+			ThreadSetup ts; (void)ts;
+			try
+			{
+				typename buffer_type::slice_type	spectrum_slice;
+				typename DataArrayMD<A2DT>::slice_type	real_slice;
+				buffer.GetSlice(spectrum_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+				real.GetSlice(real_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+				FFTf(spectrum_slice, fftNone, flags, e_dont_use_omp);
+				FFTf_c2r(spectrum_slice, real_slice, flags, fftNone, e_dont_use_omp);
+			}
+			catch (...)
 			{
-				typename DataArrayMD<A2DT>::row_type	row;
-				f.GetRow(row, {slice_mask(0), i, size_t(j)});
-				FFT(row, dir);
+				ec.CatchException();
 			}
 		}
+		ec.ThrowIfErrors();
 	}
+	else
+	{
+		for(ptrdiff_t i = 0; i < ptrdiff_t(buffer.sizes(0)); ++i)
+		{
+			typename buffer_type::slice_type	spectrum_slice;
+			typename DataArrayMD<A2DT>::slice_type	real_slice;
+			buffer.GetSlice(spectrum_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+			real.GetSlice(real_slice, {size_t(i), slice_mask(0), slice_mask(1)});
+			FFTf(spectrum_slice, fftNone, flags, e_dont_use_omp);
+			FFTf_c2r(spectrum_slice, real_slice, flags, fftNone, e_dont_use_omp);
+		}
+	}
+}
+
+//! \brief Трехмерное фурье-преобразование вещественного массива, см. FFTf_3D_r2c()
+template<class A2DT, class A2DT2>
+void	FFT_3D_r2c(const DataArrayMD<A2DT> &real, DataArrayMD<A2DT2> &spectrum, ftDirection dir, omp_usage_t omp = e_use_omp)
+{
+	FFTf_3D_r2c(real, spectrum, dir==ftForward ? fftFwd : fftRev, omp);
+}
+
+//! \brief Трехмерное фурье-преобразование половины эрмитова спектра в вещественный массив, см. FFTf_3D_c2r()
+template<class A2DT2, class A2DT>
+void	FFT_3D_c2r(const DataArrayMD<A2DT2> &spectrum, DataArrayMD<A2DT> &real, ftDirection dir, omp_usage_t omp = e_use_omp)
+{
+	FFTf_3D_c2r(spectrum, real, dir==ftForward ? fftFwd : fftRev, omp);
 }
 
 
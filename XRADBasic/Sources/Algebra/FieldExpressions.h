@@ -0,0 +1,608 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FieldExpressions.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_FieldExpressions_h
+#define XRAD__File_FieldExpressions_h
+/*!
+	\addtogroup gr_Algebra
+	@{
+
+	\file
+	\brief Отложенные (ленивые) выражения над FieldElement без промежуточных массивов
+
+	Операторы FieldElement и AlgebraElement создают новый массив для каждого
+	промежуточного результата: выражение `a*b + c*d - e` создает четыре временных
+	массива и выполняет пять проходов по памяти. Здесь то же выражение строится как
+	дерево из ссылок на исходные массивы и функторов из Functors.h, а вычисляется
+	одним проходом при присваивании:
+
+	~~~~
+	using namespace FieldExpressions;
+	RealFunction2D_F32 result(vs, hs);
+	Assign(result, Lazy(a)*b + Lazy(c)*d - e);
+	auto result_2 = Evaluate(Lazy(a)*b + Lazy(c)*d - e);
+	Assign(result, Lazy(a)*2, Functors::plus_assign()); // result += a*2
+	~~~~
+
+	Механизм включается явно: обычные операторы FieldElement не меняются.
+	Выражение начинается с Lazy(x); далее операторы +, -, *, / с участием выражения
+	тоже дают выражение. Подвыражение без Lazy вычисляется обычным образом
+	(`Lazy(a)*b + c*d` создаст временный массив для c*d).
+
+	Произвольные функторы из Functors.h подключаются через Transform (функтор вида f(r, x),
+	например, Functors::assign_f1(f)) и Combine (функтор вида f(r, x, y), например,
+	Functors::create_assign_mix(a1, a2)).
+
+	Правила типов те же, что у обычных операторов: тип промежуточного значения
+	определяется первым (левым) аргументом-массивом; скаляр используется как есть.
+	Поэтому результаты совпадают с результатами обычных операторов (с точностью до
+	возможного объединения умножения и сложения в FMA компилятором).
+
+	Размерность (1D, 2D, MD) определяется по algorithms_type массива-результата;
+	все массивы выражения должны быть той же размерности и того же размера.
+	Массив-результат может входить в выражение сам (`Assign(a, Lazy(a)*b + c)`),
+	но не в виде другого подмножества тех же данных.
+
+	Проход по памяти такой же, как в BasicArrayInteractions: двумерные массивы
+	обрабатываются строками или столбцами в зависимости от шага результата,
+	многомерные -- одномерными сканами по измерению с наименьшим шагом.
+	Если у всех массивов в скане шаг 1, используется отдельный цикл, который компилятор
+	может векторизовать.
+*/
+//! @} <!-- ^group gr_Algebra -->
+//--------------------------------------------------------------
+
+#include "FieldElement.h"
+#include "AlgebraicAlgorithmsDataArray.h"
+#include "AlgebraicAlgorithms2D.h"
+#include "AlgebraicAlgorithmsMD.h"
+#include <algorithm>
+
+XRAD_BEGIN
+
+/*!
+	\addtogroup gr_Algebra
+	@{
+*/
+//! \brief Отложенные выражения над FieldElement, см. FieldExpressions.h
+namespace FieldExpressions
+{
+
+//--------------------------------------------------------------
+
+//! \brief Базовый класс всех узлов выражения (CRTP)
+template <class E>
+class expression
+{
+	public:
+		const E &self() const { return static_cast<const E&>(*this); }
+};
+
+//! \brief Положение одномерного скана в одномерном массиве (скан единственный)
+struct row_locator_1D {};
+
+//! \brief Положение одномерного скана в двумерном массиве: строка или столбец index
+struct row_locator_2D
+{
+	size_t index;
+	bool columns;
+};
+
+// Положение скана в многомерном массиве задается index_vector со slice_mask(0)
+// в измерении скана, см. DataArrayMD::GetRow().
+
+//--------------------------------------------------------------
+
+namespace FE_aux
+{
+
+//! \brief Указатель на начало скана и шаг
+template <class T>
+struct row_pointer
+{
+	T *data;
+	ptrdiff_t step;
+};
+
+template <class T>
+row_pointer<T> make_row_pointer(T &first, ptrdiff_t step)
+{
+	return row_pointer<T>{&first, step};
+}
+
+template <class A>
+auto get_row(A &array, const row_locator_1D &)
+{
+	return make_row_pointer(array.at(0), array.step());
+}
+
+template <class A>
+auto get_row(A &array, const row_locator_2D &locator)
+{
+	auto &row = locator.columns? array.col(locator.index): array.row(locator.index);
+	return make_row_pointer(row.at(0), row.step());
+}
+
+template <class A>
+auto get_row(A &array, const index_vector &locator)
+{
+	typename MDAT_aux::constness_types<A>::row_type row;
+	array.GetRow(row, locator);
+	return make_row_pointer(row.at(0), row.step());
+}
+
+//--------------------------------------------------------------
+
+template <class E>
+std::true_type is_expression_test(const expression<E> *);
+std::false_type is_expression_test(...);
+
+template <class CONTAINER_T, class CHILD_T, class VT, class ST, class ALG_T>
+std::true_type is_field_element_test(const AlgebraicStructures::GenericFieldElement<CONTAINER_T, CHILD_T, VT, ST, ALG_T> *);
+std::false_type is_field_element_test(...);
+
+} // namespace FE_aux
+
+template <class T>
+struct is_expression : decltype(FE_aux::is_expression_test(std::declval<T*>())) {};
+
+template <class T>
+struct is_field_element : decltype(FE_aux::is_field_element_test(std::declval<T*>())) {};
+
+//--------------------------------------------------------------
+//
+//	Сканы: значения узлов выражения вдоль одномерного скана.
+//	value(i) -- значение i-го элемента скана, value_unit_step(i) -- то же при шаге 1
+//	у всех массивов скана (проверяется через unit_step()).
+//
+//--------------------------------------------------------------
+
+template <class T>
+class array_row
+{
+	public:
+		array_row(const T *data, ptrdiff_t step): data(data), step(step) {}
+
+		const T &value(size_t i) const { return data[ptrdiff_t(i)*step]; }
+		const T &value_unit_step(size_t i) const { return data[i]; }
+		bool unit_step() const { return step == 1; }
+
+	private:
+		const T *data;
+		ptrdiff_t step;
+};
+
+template <class S>
+class scalar_row
+{
+	public:
+		scalar_row(const S &x): x(x) {}
+
+		const S &value(size_t) const { return x; }
+		const S &value_unit_step(size_t) const { return x; }
+		bool unit_step() const { return true; }
+
+	private:
+		S x;
+};
+
+template <class VT, class OP, class R>
+class unary_row
+{
+	public:
+		unary_row(const OP &op, const R &arg): op(op), arg(arg) {}
+
+		VT value(size_t i) const
+		{
+			VT result;
+			op(result, arg.value(i));
+			return result;
+		}
+		VT value_unit_step(size_t i) const
+		{
+			VT result;
+			op(result, arg.value_unit_step(i));
+			return result;
+		}
+		bool unit_step() const { return arg.unit_step(); }
+
+	private:
+		OP op;
+		R arg;
+};
+
+template <class VT, class OP, class R1, class R2>
+class binary_row
+{
+	public:
+		binary_row(const OP &op, const R1 &arg_1, const R2 &arg_2): op(op), arg_1(arg_1), arg_2(arg_2) {}
+
+		VT value(size_t i) const
+		{
+			VT result;
+			op(result, arg_1.value(i), arg_2.value(i));
+			return result;
+		}
+		VT value_unit_step(size_t i) const
+		{
+			VT result;
+			op(result, arg_1.value_unit_step(i), arg_2.value_unit_step(i));
+			return result;
+		}
+		bool unit_step() const { return arg_1.unit_step() && arg_2.unit_step(); }
+
+	private:
+		OP op;
+		R1 arg_1;
+		R2 arg_2;
+};
+
+//--------------------------------------------------------------
+//
+//	Узлы выражения. Каждый узел предоставляет:
+//	- value_type -- тип значения узла;
+//	- is_scalar -- true для скаляра;
+//	- first_array() -- крайний левый массив (определяет тип результата Evaluate());
+//	- eq_sizes(result) -- проверка размеров всех массивов;
+//	- row(locator) -- скан узла.
+//
+//--------------------------------------------------------------
+
+//! \brief Лист выражения: ссылка на массив (FieldElement)
+template <class A>
+class array_terminal : public expression<array_terminal<A>>
+{
+	public:
+		using array_type = A;
+		using value_type = std::remove_cv_t<typename A::value_type>;
+		static constexpr bool is_scalar = false;
+
+		explicit array_terminal(const A &array): array(array) {}
+
+		const A &first_array() const { return array; }
+
+		template <class RT>
+		bool eq_sizes(const RT &result) const
+		{
+			return RT::algorithms_type::AA_EqSize(result, array);
+		}
+
+		template <class L>
+		array_row<value_type> row(const L &locator) const
+		{
+			auto r = FE_aux::get_row(array, locator);
+			return array_row<value_type>(r.data, r.step);
+		}
+
+	private:
+		const A &array;
+};
+
+//! \brief Лист выражения: скаляр (хранится по значению)
+template <class S>
+class scalar_terminal : public expression<scalar_terminal<S>>
+{
+	public:
+		using value_type = S;
+		static constexpr bool is_scalar = true;
+
+		explicit scalar_terminal(const S &x): x(x) {}
+
+		template <class RT>
+		bool eq_sizes(const RT &) const { return true; }
+
+		template <class L>
+		scalar_row<S> row(const L &) const { return scalar_row<S>(x); }
+
+	private:
+		S x;
+};
+
+//! \brief Узел выражения: функтор вида op(result, x), например, Functors::assign_f1(f)
+template <class OP, class E>
+class unary_expression : public expression<unary_expression<OP, E>>
+{
+	public:
+		using value_type = typename E::value_type;
+		static constexpr bool is_scalar = false;
+		static_assert(!E::is_scalar, "FieldExpressions: unary operation on a scalar.");
+
+		unary_expression(const OP &op, const E &arg): op(op), arg(arg) {}
+
+		decltype(auto) first_array() const { return arg.first_array(); }
+
+		template <class RT>
+		bool eq_sizes(const RT &result) const { return arg.eq_sizes(result); }
+
+		template <class L>
+		auto row(const L &locator) const
+		{
+			return unary_row<value_type, OP, decltype(arg.row(locator))>(op, arg.row(locator));
+		}
+
+	private:
+		OP op;
+		E arg;
+};
+
+//! \brief Узел выражения: функтор вида op(result, x, y), например, Functors::assign_plus()
+template <class OP, class E1, class E2>
+class binary_expression : public expression<binary_expression<OP, E1, E2>>
+{
+	public:
+		//! \brief Тип значения определяется левым аргументом-массивом, как у операторов FieldElement
+		using value_type = std::conditional_t<E1::is_scalar, typename E2::value_type, typename E1::value_type>;
+		static constexpr bool is_scalar = false;
+		static_assert(!(E1::is_scalar && E2::is_scalar), "FieldExpressions: binary operation on two scalars.");
+
+		binary_expression(const OP &op, const E1 &arg_1, const E2 &arg_2): op(op), arg_1(arg_1), arg_2(arg_2) {}
+
+		decltype(auto) first_array() const { return first_array(std::integral_constant<bool, E1::is_scalar>()); }
+
+		template <class RT>
+		bool eq_sizes(const RT &result) const { return arg_1.eq_sizes(result) && arg_2.eq_sizes(result); }
+
+		template <class L>
+		auto row(const L &locator) const
+		{
+			return binary_row<value_type, OP, decltype(arg_1.row(locator)), decltype(arg_2.row(locator))>(
+					op, arg_1.row(locator), arg_2.row(locator));
+		}
+
+	private:
+		decltype(auto) first_array(std::false_type) const { return arg_1.first_array(); }
+		decltype(auto) first_array(std::true_type) const { return arg_2.first_array(); }
+
+	private:
+		OP op;
+		E1 arg_1;
+		E2 arg_2;
+};
+
+//--------------------------------------------------------------
+
+//! \brief Начало отложенного выражения: лист со ссылкой на массив
+template <class CONTAINER_T, class CHILD_T, class VT, class ST, class ALG_T>
+array_terminal<CHILD_T> Lazy(const AlgebraicStructures::GenericFieldElement<CONTAINER_T, CHILD_T, VT, ST, ALG_T> &x)
+{
+	return array_terminal<CHILD_T>(x.child_ref());
+}
+
+//--------------------------------------------------------------
+//
+//	Преобразование аргументов операторов в узлы выражения
+//
+//--------------------------------------------------------------
+
+namespace FE_aux
+{
+
+template <class T>
+const T &make_operand(const T &x, std::true_type /*is_expression*/, std::false_type)
+{
+	return x;
+}
+
+template <class T>
+auto make_operand(const T &x, std::false_type, std::true_type /*is_field_element*/)
+{
+	return Lazy(x);
+}
+
+template <class T>
+scalar_terminal<T> make_operand(const T &x, std::false_type, std::false_type)
+{
+	return scalar_terminal<T>(x);
+}
+
+template <class T>
+auto make_operand(const T &x)
+{
+	return make_operand(x, is_expression<T>(), is_field_element<T>());
+}
+
+template <class T>
+using operand_t = std::remove_cv_t<std::remove_reference_t<decltype(make_operand(std::declval<const T&>()))>>;
+
+template <class T1, class T2>
+using enable_if_expression_operands_t = std::enable_if_t<is_expression<T1>::value || is_expression<T2>::value>;
+
+} // namespace FE_aux
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Узел с произвольным функтором вида op(result, x)
+
+	Пример: `Transform(Functors::assign_f1([](double x){ return sqrt(x); }), Lazy(a))`.
+	Аргумент -- выражение или массив.
+*/
+template <class OP, class T>
+unary_expression<OP, FE_aux::operand_t<T>> Transform(const OP &op, const T &x)
+{
+	return unary_expression<OP, FE_aux::operand_t<T>>(op, FE_aux::make_operand(x));
+}
+
+/*!
+	\brief Узел с произвольным функтором вида op(result, x, y)
+
+	Пример: `Combine(Functors::create_assign_mix(0.25, 0.75), Lazy(a), b)`.
+	Аргументы -- выражения, массивы или скаляры (хотя бы один не скаляр).
+*/
+template <class OP, class T1, class T2>
+binary_expression<OP, FE_aux::operand_t<T1>, FE_aux::operand_t<T2>> Combine(const OP &op, const T1 &x, const T2 &y)
+{
+	return binary_expression<OP, FE_aux::operand_t<T1>, FE_aux::operand_t<T2>>(op,
+			FE_aux::make_operand(x), FE_aux::make_operand(y));
+}
+
+template <class T1, class T2, class = FE_aux::enable_if_expression_operands_t<T1, T2>>
+auto operator + (const T1 &x, const T2 &y) { return Combine(Functors::assign_plus(), x, y); }
+
+template <class T1, class T2, class = FE_aux::enable_if_expression_operands_t<T1, T2>>
+auto operator - (const T1 &x, const T2 &y) { return Combine(Functors::assign_minus(), x, y); }
+
+template <class T1, class T2, class = FE_aux::enable_if_expression_operands_t<T1, T2>>
+auto operator * (const T1 &x, const T2 &y) { return Combine(Functors::assign_multiply(), x, y); }
+
+template <class T1, class T2, class = FE_aux::enable_if_expression_operands_t<T1, T2>>
+auto operator / (const T1 &x, const T2 &y) { return Combine(Functors::assign_divide(), x, y); }
+
+template <class E>
+auto operator - (const expression<E> &x) { return Transform(Functors::assign_unary_minus(), x.self()); }
+
+//--------------------------------------------------------------
+
+namespace FE_aux
+{
+
+template <class RT, class R, class OP>
+void assign_row(row_pointer<RT> result, size_t size, const R &row, const OP &assign_action)
+{
+	if(result.step == 1 && row.unit_step())
+	{
+		for(size_t i = 0; i < size; ++i)
+			assign_action(result.data[i], row.value_unit_step(i));
+	}
+	else
+	{
+		for(size_t i = 0; i < size; ++i)
+			assign_action(result.data[ptrdiff_t(i)*result.step], row.value(i));
+	}
+}
+
+template <class RT, class E, class OP>
+void evaluate(RT &result, const E &e, const OP &assign_action, AlgebraicStructures::AlgebraicAlgorithmsDataArray *)
+{
+	row_locator_1D locator;
+	assign_row(get_row(result, locator), result.size(), e.row(locator), assign_action);
+}
+
+template <class RT, class E, class OP>
+void evaluate(RT &result, const E &e, const OP &assign_action, AlgebraicStructures::AlgebraicAlgorithmsDataArray2D *)
+{
+	// Порядок обхода как в Apply_A_2D_F1()
+	row_locator_2D locator{0, !(result.steps(1) < result.steps(0))};
+	size_t n_rows = locator.columns? result.hsize(): result.vsize();
+	size_t row_size = locator.columns? result.vsize(): result.hsize();
+	for(; locator.index < n_rows; ++locator.index)
+	{
+		assign_row(get_row(result, locator), row_size, e.row(locator), assign_action);
+	}
+}
+
+template <class RT, class E, class OP>
+void evaluate(RT &result, const E &e, const OP &assign_action, AlgebraicStructures::AlgebraicAlgorithmsDataArrayMD *)
+{
+	// Сканы идут по измерению с наименьшим шагом, остальные измерения перебираются
+	// в порядке убывания шага
+	size_t n_dimensions = result.n_dimensions();
+	vector<pair<size_t, size_t>> sort_index(n_dimensions);
+	for(size_t i = 0; i < n_dimensions; ++i)
+		sort_index[i] = make_pair(size_t(std::abs(result.steps()[i])), i);
+	sort(sort_index.begin(), sort_index.end());
+	size_t run_dimension = sort_index[0].second;
+	size_t row_size = result.sizes(run_dimension);
+
+	index_vector locator(n_dimensions, 0);
+	locator[run_dimension] = slice_mask(0);
+	for(;;)
+	{
+		assign_row(get_row(result, locator), row_size, e.row(locator), assign_action);
+
+		size_t k = 1;
+		for(; k < n_dimensions; ++k)
+		{
+			size_t dimension = sort_index[k].second;
+			if(++locator[dimension] < result.sizes(dimension))
+				break;
+			locator[dimension] = 0;
+		}
+		if(k == n_dimensions)
+			break;
+	}
+}
+
+template <class AT>
+AT create_result(const AT &array, AlgebraicStructures::AlgebraicAlgorithmsDataArray *)
+{
+	return AT(array.sizes(0));
+}
+
+template <class AT>
+AT create_result(const AT &array, AlgebraicStructures::AlgebraicAlgorithmsDataArray2D *)
+{
+	return AT(array.vsize(), array.hsize());
+}
+
+template <class AT>
+AT create_result(const AT &array, AlgebraicStructures::AlgebraicAlgorithmsDataArrayMD *)
+{
+	return AT(array.sizes());
+}
+
+} // namespace FE_aux
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Вычисляет выражение одним проходом: assign_action(result[i], e[i]) для всех элементов
+
+	assign_action -- функтор вида f(r, x) из Functors.h: Functors::assign() (по умолчанию),
+	Functors::plus_assign(), Functors::multiply_assign() и т.п.
+
+	Размеры всех массивов выражения должны совпадать с размерами result.
+
+	\return result
+*/
+template <class RT, class E, class OP>
+RT &Assign(RT &result, const expression<E> &e, const OP &assign_action)
+{
+	if(!e.self().eq_sizes(result))
+	{
+		ForceDebugBreak();
+		throw runtime_error("FieldExpressions::Assign: array sizes do not match.");
+	}
+	if(result.empty())
+		return result;
+	FE_aux::evaluate(result, e.self(), assign_action, (typename RT::algorithms_type *)nullptr);
+	return result;
+}
+
+//! \brief Вычисляет выражение одним проходом: result[i] = e[i]
+template <class RT, class E>
+RT &Assign(RT &result, const expression<E> &e)
+{
+	return Assign(result, e, Functors::assign());
+}
+
+/*!
+	\brief Вычисляет выражение в новый массив
+
+	Тип и размер результата берутся от крайнего левого массива выражения
+	(как у результата обычных операторов FieldElement).
+*/
+template <class E>
+auto Evaluate(const expression<E> &e)
+{
+	using array_type = std::remove_cv_t<std::remove_reference_t<decltype(e.self().first_array())>>;
+	const array_type &first = e.self().first_array();
+	array_type result = FE_aux::create_result(first, (typename array_type::algorithms_type *)nullptr);
+	Assign(result, e);
+	return result;
+}
+
+//--------------------------------------------------------------
+
+} // namespace FieldExpressions
+
+//! @} <!-- ^group gr_Algebra -->
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_FieldExpressions_h
@@ -98,6 +98,18 @@ class absolute_value
 		}
 };
 
+//! \brief r = |x|. Для непрерывных массивов float, double, int16_t, complexF32 (результат float)
+//! Apply_AA_1D_F2 использует векторизованное ядро, см. BasicArrayInteractionsSIMD.h
+class assign_absolute_value
+{
+	public:
+		template <class T1, class T2>
+		void operator() (T1 &r, const T2 &x) const
+		{
+			r = absolute_value()(x);
+		}
+};
+
 //--------------------------------------------------------------
 
 class pow_value
@@ -0,0 +1,119 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ArrayInteractionsSIMD.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_ArrayInteractionsSIMD_h
+#define XRAD__File_ArrayInteractionsSIMD_h
+/*!
+	\file
+	\brief Векторизованные (AVX2) поэлементные операции над непрерывными массивами
+
+	Внутренний файл библиотеки. Используется в BasicArrayInteractionsSIMD.h для ускорения
+	Apply_AA_1D_F2(), Apply_AS_1D_F2(), Apply_AAA_1D_F3(), Apply_AAS_1D_F3() для массивов
+	с шагом 1 и известных функторов.
+
+	Типы данных: float, double, int16_t, complexF32 (пары float re, im).
+	Результат совпадает с результатом скалярного кода: ядра компилируются без FMA,
+	порядок операций тот же, что в операторах ComplexSample; операции над int16_t выполняются
+	с переполнением по модулю 2^16, как при присваивании результата int в short.
+
+	Реализация находится в отдельной единице трансляции ArrayInteractionsSIMD_AVX2.cpp,
+	которая компилируется с ключами AVX2. Выбор выполняется во время выполнения
+	по ActiveSIMDInstructionSet().
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Sources/Core/CPUFeatures.h>
+#include <cstddef>
+#include <cstdint>
+
+XRAD_BEGIN
+
+namespace ArrayInteractionsSIMD
+{
+
+//--------------------------------------------------------------
+
+//! \brief Поэлементная операция out[i] = a[i] op b[i]
+enum binary_operation
+{
+	e_add,
+	e_subtract,
+	e_multiply,
+	//! \brief Только float, double
+	e_divide,
+	//! \brief a*conj(b), только complexF32 (оператор % ComplexSample)
+	e_multiply_conj
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Набор ядер для одного набора инструкций
+
+	Все ядра допускают совпадение out с a (и с b); частичное перекрытие массивов не допускается.
+	Размеры указываются в элементах (для complexF32 -- в комплексных отсчетах).
+	Ядра, возвращающие bool, возвращают false и не меняют данные, если операция не поддерживается.
+*/
+struct Kernels
+{
+	//! \brief Набор инструкций, для которого скомпилированы ядра
+	simd_instruction_set_t	instruction_set;
+
+	//! \name out[i] = a[i] op b[i]
+	//! @{
+	bool	(*binary_f32)(binary_operation op, const float *a, const float *b, float *out, size_t size);
+	bool	(*binary_f64)(binary_operation op, const double *a, const double *b, double *out, size_t size);
+	bool	(*binary_i16)(binary_operation op, const int16_t *a, const int16_t *b, int16_t *out, size_t size);
+	bool	(*binary_cf32)(binary_operation op, const float *a, const float *b, float *out, size_t size);
+	//! @}
+
+	//! \name out[i] = a[i] op x
+	//! @{
+	bool	(*scalar_f32)(binary_operation op, const float *a, float x, float *out, size_t size);
+	//! \brief Вычисление в double: out[i] = float(double(a[i]) op x)
+	bool	(*scalar_f32_f64)(binary_operation op, const float *a, double x, float *out, size_t size);
+	bool	(*scalar_f64)(binary_operation op, const double *a, double x, double *out, size_t size);
+	bool	(*scalar_i16)(binary_operation op, const int16_t *a, int16_t x, int16_t *out, size_t size);
+	//! \brief x -- комплексное число (re, im)
+	bool	(*scalar_cf32)(binary_operation op, const float *a, const float *x, float *out, size_t size);
+	//! @}
+
+	//! \name out[i] = |a[i]|. Для complexF32 модуль вычисляется в double
+	//! @{
+	void	(*abs_f32)(const float *a, float *out, size_t size);
+	void	(*abs_f64)(const double *a, double *out, size_t size);
+	void	(*abs_i16)(const int16_t *a, int16_t *out, size_t size);
+	void	(*abs_cf32)(const float *a, float *out, size_t size);
+	//! @}
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Ядра для текущего набора инструкций ActiveSIMDInstructionSet()
+
+	\return nullptr, если векторизованные ядра недоступны (используется скалярный код)
+*/
+const Kernels *ActiveKernels();
+
+//--------------------------------------------------------------
+
+#ifdef XRAD_CPU_X86
+
+//! \brief Реализация AVX2. Вызывать только при DetectedSIMDInstructionSet() >= e_simd_avx2
+const Kernels &Kernels_AVX2();
+
+#endif // XRAD_CPU_X86
+
+//--------------------------------------------------------------
+
+} // namespace ArrayInteractionsSIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_ArrayInteractionsSIMD_h
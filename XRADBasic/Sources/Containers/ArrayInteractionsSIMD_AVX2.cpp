@@ -0,0 +1,338 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ArrayInteractionsSIMD_AVX2.cpp
+//--------------------------------------------------------------
+// Файл компилируется с ключами AVX2 без FMA (см. CMakeLists.txt, XRADBasic.vcxproj)
+// без предкомпилированного заголовка: код из других файлов не должен компилироваться с этими ключами.
+// FMA не используется, чтобы результат совпадал с результатом скалярного кода.
+// Функции этого файла вызываются только при DetectedSIMDInstructionSet() >= e_simd_avx2.
+#include "ArrayInteractionsSIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <immintrin.h>
+#include <cstring>
+
+XRAD_BEGIN
+
+namespace ArrayInteractionsSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+struct avx2_f32
+{
+	using value = float;
+	using reg = __m256;
+	static constexpr size_t	lanes = 8;
+
+	static reg load(const value *p) { return _mm256_loadu_ps(p); }
+	static void store(value *p, reg x) { _mm256_storeu_ps(p, x); }
+};
+
+struct avx2_f64
+{
+	using value = double;
+	using reg = __m256d;
+	static constexpr size_t	lanes = 4;
+
+	static reg load(const value *p) { return _mm256_loadu_pd(p); }
+	static void store(value *p, reg x) { _mm256_storeu_pd(p, x); }
+};
+
+struct avx2_i16
+{
+	using value = int16_t;
+	using reg = __m256i;
+	static constexpr size_t	lanes = 16;
+
+	static reg load(const value *p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(value *p, reg x) { _mm256_storeu_si256((__m256i*)p, x); }
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Заполнить буфер регистра первыми rest элементами source
+
+	Лишние элементы заполняются копиями последнего: они повторяют операцию, которую выполняет
+	и скалярный код, и не поднимают новых флагов исключений с плавающей точкой
+	(нули дали бы 0/0 при делении).
+*/
+template<class value>
+void fill_tail(value *buffer, const value *source, size_t rest, size_t lanes)
+{
+	memcpy(buffer, source, rest*sizeof(value));
+	for(size_t j = rest; j < lanes; ++j)
+		buffer[j] = source[rest - 1];
+}
+
+/*!
+	\brief out[i] = op(a[i], b[i]) для регистров V
+
+	Неполный последний регистр обрабатывается через временный буфер (см. fill_tail()), чтобы и хвост
+	вычислялся теми же векторными инструкциями.
+*/
+template<class V, class Op>
+void binary_loop(const typename V::value *a, const typename V::value *b, typename V::value *out, size_t size, Op op)
+{
+	using value = typename V::value;
+	size_t	i = 0;
+	for(; i + V::lanes <= size; i += V::lanes)
+		V::store(out + i, op(V::load(a + i), V::load(b + i)));
+	if(i < size)
+	{
+		size_t	rest = size - i;
+		value	ta[V::lanes], tb[V::lanes], tr[V::lanes];
+		fill_tail(ta, a + i, rest, V::lanes);
+		fill_tail(tb, b + i, rest, V::lanes);
+		V::store(tr, op(V::load(ta), V::load(tb)));
+		memcpy(out + i, tr, rest*sizeof(value));
+	}
+}
+
+//! \brief out[i] = op(a[i]) для регистров V
+template<class V, class Op>
+void unary_loop(const typename V::value *a, typename V::value *out, size_t size, Op op)
+{
+	using value = typename V::value;
+	size_t	i = 0;
+	for(; i + V::lanes <= size; i += V::lanes)
+		V::store(out + i, op(V::load(a + i)));
+	if(i < size)
+	{
+		size_t	rest = size - i;
+		value	ta[V::lanes], tr[V::lanes];
+		fill_tail(ta, a + i, rest, V::lanes);
+		V::store(tr, op(V::load(ta)));
+		memcpy(out + i, tr, rest*sizeof(value));
+	}
+}
+
+//--------------------------------------------------------------
+//
+//	Вещественные операции
+//
+//--------------------------------------------------------------
+
+bool binary_f32(binary_operation op, const float *a, const float *b, float *out, size_t size)
+{
+	switch(op)
+	{
+		case e_add: binary_loop<avx2_f32>(a, b, out, size, [](__m256 x, __m256 y) { return _mm256_add_ps(x, y); }); return true;
+		case e_subtract: binary_loop<avx2_f32>(a, b, out, size, [](__m256 x, __m256 y) { return _mm256_sub_ps(x, y); }); return true;
+		case e_multiply: binary_loop<avx2_f32>(a, b, out, size, [](__m256 x, __m256 y) { return _mm256_mul_ps(x, y); }); return true;
+		case e_divide: binary_loop<avx2_f32>(a, b, out, size, [](__m256 x, __m256 y) { return _mm256_div_ps(x, y); }); return true;
+		default: return false;
+	}
+}
+
+bool binary_f64(binary_operation op, const double *a, const double *b, double *out, size_t size)
+{
+	switch(op)
+	{
+		case e_add: binary_loop<avx2_f64>(a, b, out, size, [](__m256d x, __m256d y) { return _mm256_add_pd(x, y); }); return true;
+		case e_subtract: binary_loop<avx2_f64>(a, b, out, size, [](__m256d x, __m256d y) { return _mm256_sub_pd(x, y); }); return true;
+		case e_multiply: binary_loop<avx2_f64>(a, b, out, size, [](__m256d x, __m256d y) { return _mm256_mul_pd(x, y); }); return true;
+		case e_divide: binary_loop<avx2_f64>(a, b, out, size, [](__m256d x, __m256d y) { return _mm256_div_pd(x, y); }); return true;
+		default: return false;
+	}
+}
+
+bool binary_i16(binary_operation op, const int16_t *a, const int16_t *b, int16_t *out, size_t size)
+{
+	switch(op)
+	{
+		case e_add: binary_loop<avx2_i16>(a, b, out, size, [](__m256i x, __m256i y) { return _mm256_add_epi16(x, y); }); return true;
+		case e_subtract: binary_loop<avx2_i16>(a, b, out, size, [](__m256i x, __m256i y) { return _mm256_sub_epi16(x, y); }); return true;
+		case e_multiply: binary_loop<avx2_i16>(a, b, out, size, [](__m256i x, __m256i y) { return _mm256_mullo_epi16(x, y); }); return true;
+		default: return false;
+	}
+}
+
+//--------------------------------------------------------------
+
+bool scalar_f32(binary_operation op, const float *a, float x, float *out, size_t size)
+{
+	__m256	y = _mm256_set1_ps(x);
+	switch(op)
+	{
+		case e_add: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return _mm256_add_ps(v, y); }); return true;
+		case e_subtract: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return _mm256_sub_ps(v, y); }); return true;
+		case e_multiply: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return _mm256_mul_ps(v, y); }); return true;
+		case e_divide: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return _mm256_div_ps(v, y); }); return true;
+		default: return false;
+	}
+}
+
+//! \brief Применить op к 8 числам float в точности double
+template<class Op>
+__m256 apply_f64(__m256 v, Op op)
+{
+	__m128	lo = _mm256_cvtpd_ps(op(_mm256_cvtps_pd(_mm256_castps256_ps128(v))));
+	__m128	hi = _mm256_cvtpd_ps(op(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1))));
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+bool scalar_f32_f64(binary_operation op, const float *a, double x, float *out, size_t size)
+{
+	__m256d	y = _mm256_set1_pd(x);
+	switch(op)
+	{
+		case e_add: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return apply_f64(v, [y](__m256d w) { return _mm256_add_pd(w, y); }); }); return true;
+		case e_subtract: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return apply_f64(v, [y](__m256d w) { return _mm256_sub_pd(w, y); }); }); return true;
+		case e_multiply: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return apply_f64(v, [y](__m256d w) { return _mm256_mul_pd(w, y); }); }); return true;
+		case e_divide: unary_loop<avx2_f32>(a, out, size, [y](__m256 v) { return apply_f64(v, [y](__m256d w) { return _mm256_div_pd(w, y); }); }); return true;
+		default: return false;
+	}
+}
+
+bool scalar_f64(binary_operation op, const double *a, double x, double *out, size_t size)
+{
+	__m256d	y = _mm256_set1_pd(x);
+	switch(op)
+	{
+		case e_add: unary_loop<avx2_f64>(a, out, size, [y](__m256d v) { return _mm256_add_pd(v, y); }); return true;
+		case e_subtract: unary_loop<avx2_f64>(a, out, size, [y](__m256d v) { return _mm256_sub_pd(v, y); }); return true;
+		case e_multiply: unary_loop<avx2_f64>(a, out, size, [y](__m256d v) { return _mm256_mul_pd(v, y); }); return true;
+		case e_divide: unary_loop<avx2_f64>(a, out, size, [y](__m256d v) { return _mm256_div_pd(v, y); }); return true;
+		default: return false;
+	}
+}
+
+bool scalar_i16(binary_operation op, const int16_t *a, int16_t x, int16_t *out, size_t size)
+{
+	__m256i	y = _mm256_set1_epi16(x);
+	switch(op)
+	{
+		case e_add: unary_loop<avx2_i16>(a, out, size, [y](__m256i v) { return _mm256_add_epi16(v, y); }); return true;
+		case e_subtract: unary_loop<avx2_i16>(a, out, size, [y](__m256i v) { return _mm256_sub_epi16(v, y); }); return true;
+		case e_multiply: unary_loop<avx2_i16>(a, out, size, [y](__m256i v) { return _mm256_mullo_epi16(v, y); }); return true;
+		default: return false;
+	}
+}
+
+//--------------------------------------------------------------
+//
+//	Комплексные операции. Регистр содержит 4 отсчета (re0, im0, re1, im1, ...).
+//	Порядок действий как в ComplexSample::operator*=, operator%=:
+//	re = a.re*b.re - a.im*b.im, im = a.re*b.im + a.im*b.re;
+//	re = a.re*b.re + a.im*b.im, im = a.im*b.re - a.re*b.im.
+//
+//--------------------------------------------------------------
+
+inline __m256 complex_multiply(__m256 a, __m256 b)
+{
+	__m256	t1 = _mm256_mul_ps(a, _mm256_moveldup_ps(b)); // a.re*b.re, a.im*b.re
+	__m256	t2 = _mm256_mul_ps(_mm256_permute_ps(a, 0xB1), _mm256_movehdup_ps(b)); // a.im*b.im, a.re*b.im
+	return _mm256_addsub_ps(t1, t2);
+}
+
+inline __m256 complex_multiply_conj(__m256 a, __m256 b)
+{
+	__m256	t1 = _mm256_mul_ps(a, _mm256_moveldup_ps(b));
+	__m256	t2 = _mm256_mul_ps(_mm256_permute_ps(a, 0xB1), _mm256_movehdup_ps(b));
+	// x + (-y) == x - y точно, поэтому результат совпадает со скалярным
+	return _mm256_addsub_ps(t1, _mm256_xor_ps(t2, _mm256_set1_ps(-0.f)));
+}
+
+bool binary_cf32(binary_operation op, const float *a, const float *b, float *out, size_t size)
+{
+	switch(op)
+	{
+		case e_add:
+		case e_subtract:
+			return binary_f32(op, a, b, out, 2*size);
+		case e_multiply: binary_loop<avx2_f32>(a, b, out, 2*size, complex_multiply); return true;
+		case e_multiply_conj: binary_loop<avx2_f32>(a, b, out, 2*size, complex_multiply_conj); return true;
+		default: return false;
+	}
+}
+
+bool scalar_cf32(binary_operation op, const float *a, const float *x, float *out, size_t size)
+{
+	__m256	y = _mm256_setr_ps(x[0], x[1], x[0], x[1], x[0], x[1], x[0], x[1]);
+	switch(op)
+	{
+		case e_add: unary_loop<avx2_f32>(a, out, 2*size, [y](__m256 v) { return _mm256_add_ps(v, y); }); return true;
+		case e_subtract: unary_loop<avx2_f32>(a, out, 2*size, [y](__m256 v) { return _mm256_sub_ps(v, y); }); return true;
+		case e_multiply: unary_loop<avx2_f32>(a, out, 2*size, [y](__m256 v) { return complex_multiply(v, y); }); return true;
+		case e_multiply_conj: unary_loop<avx2_f32>(a, out, 2*size, [y](__m256 v) { return complex_multiply_conj(v, y); }); return true;
+		default: return false;
+	}
+}
+
+//--------------------------------------------------------------
+
+void abs_f32(const float *a, float *out, size_t size)
+{
+	__m256	mask = _mm256_set1_ps(-0.f);
+	unary_loop<avx2_f32>(a, out, size, [mask](__m256 v) { return _mm256_andnot_ps(mask, v); });
+}
+
+void abs_f64(const double *a, double *out, size_t size)
+{
+	__m256d	mask = _mm256_set1_pd(-0.);
+	unary_loop<avx2_f64>(a, out, size, [mask](__m256d v) { return _mm256_andnot_pd(mask, v); });
+}
+
+void abs_i16(const int16_t *a, int16_t *out, size_t size)
+{
+	unary_loop<avx2_i16>(a, out, size, [](__m256i v) { return _mm256_abs_epi16(v); });
+}
+
+//! \brief Модуль 4 комплексных отсчетов, вычисление в double
+inline __m128 complex_abs4(const float *a)
+{
+	__m256d	x0 = _mm256_cvtps_pd(_mm_loadu_ps(a));
+	__m256d	x1 = _mm256_cvtps_pd(_mm_loadu_ps(a + 4));
+	// hadd дает |c0|^2, |c2|^2, |c1|^2, |c3|^2
+	__m256d	s = _mm256_hadd_pd(_mm256_mul_pd(x0, x0), _mm256_mul_pd(x1, x1));
+	s = _mm256_permute4x64_pd(_mm256_sqrt_pd(s), _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm256_cvtpd_ps(s);
+}
+
+void abs_cf32(const float *a, float *out, size_t size)
+{
+	size_t	i = 0;
+	for(; i + 4 <= size; i += 4)
+		_mm_storeu_ps(out + i, complex_abs4(a + 2*i));
+	if(i < size)
+	{
+		size_t	rest = size - i;
+		float	ta[8] = {}, tr[4];
+		memcpy(ta, a + 2*i, 2*rest*sizeof(float));
+		_mm_storeu_ps(tr, complex_abs4(ta));
+		memcpy(out + i, tr, rest*sizeof(float));
+	}
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels &Kernels_AVX2()
+{
+	static const Kernels	kernels =
+	{
+		e_simd_avx2,
+		binary_f32, binary_f64, binary_i16, binary_cf32,
+		scalar_f32, scalar_f32_f64, scalar_f64, scalar_i16, scalar_cf32,
+		abs_f32, abs_f64, abs_i16, abs_cf32
+	};
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace ArrayInteractionsSIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
@@ -17,6 +17,10 @@
 	Некоторые функции могут иметь специализации для конкретных типов.
 	Такие специализации должны быть реализованы в файлах этих типов, а не здесь.
 
+	Apply_AS_1D_F2(), Apply_AA_1D_F2(), Apply_AAA_1D_F3(), Apply_AAS_1D_F3() для массивов
+	с шагом 1 и арифметических функторов из Functors.h выполняются векторизованными ядрами,
+	см. BasicArrayInteractionsSIMD.h.
+
 	В функциях ниже используются шаблоны с универальными ссылками вида:
 
 	~~~~
@@ -37,6 +41,7 @@
 
 #include <XRADBasic/Core.h>
 #include "ContainersBasic.h"
+#include "BasicArrayInteractionsSIMD.h"
 
 XRAD_BEGIN
 
@@ -198,6 +203,9 @@ void Apply_IA_1D_F2(Array &&array, Functor functor)
 template <class Array, class Scalar, class Functor>
 void Apply_AS_1D_F2(Array &&array, Scalar &&scalar, Functor functor)
 {
+	if(ArrayInteractionsSIMD::AS_F2(array, scalar, functor))
+		return;
+
 	auto it = array.begin();
 	auto ie = array.end();
 
@@ -215,6 +223,8 @@ template <class Array1, class Array2, class Functor>
 void Apply_AA_1D_F2(Array1 &&array_1, Array2 &&array_2, Functor functor)
 {
 	ECheckSizes_AA_1D<Apply_AA_1D_F2_name>(array_1, array_2);
+	if(ArrayInteractionsSIMD::AA_F2(array_1, array_2, functor))
+		return;
 
 	auto it1 = array_1.begin();
 	auto ie1 = array_1.end();
@@ -325,6 +335,8 @@ void Apply_AAA_1D_F3(Array1 &&array_1, Array2 &&array_2, Array3 &&array_3, Funct
 {
 	ECheckSizes_AA_1D<Apply_AAA_1D_F3_name>(array_1, array_2);
 	ECheckSizes_AA_1D<Apply_AAA_1D_F3_name>(array_2, array_3);
+	if(ArrayInteractionsSIMD::AAA_F3(array_1, array_2, array_3, functor))
+		return;
 
 	auto it1 = array_1.begin();
 	auto ie1 = array_1.end();
@@ -345,6 +357,8 @@ template <class Array1, class Array2, class Scalar, class Functor>
 void Apply_AAS_1D_F3(Array1 &&array_1, Array2 &&array_2, Scalar &&scalar, Functor functor)
 {
 	ECheckSizes_AA_1D<Apply_AAS_1D_F3_name>(array_1, array_2);
+	if(ArrayInteractionsSIMD::AAS_F3(array_1, array_2, scalar, functor))
+		return;
 
 	auto it1 = array_1.begin();
 	auto ie1 = array_1.end();
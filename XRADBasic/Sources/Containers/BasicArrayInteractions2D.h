@@ -17,6 +17,9 @@
 	Некоторые функции могут иметь специализации для конкретных типов.
 	Такие специализации должны быть реализованы в файлах этих типов, а не здесь.
 
+	Apply_A_2D_F1(), Apply_AS_2D_F2(), Apply_AA_2D_F2(), Apply_AAA_2D_F3(), Apply_AAS_2D_F3()
+	могут обрабатывать строки в нескольких потоках, см. BasicArrayInteractionsOMP.h.
+
 	В функциях ниже используются шаблоны с универальными ссылками вида:
 
 	~~~~
@@ -37,6 +40,7 @@
 
 #include <XRADBasic/Core.h>
 #include "BasicArrayInteractions1D.h"
+#include "BasicArrayInteractionsOMP.h"
 
 XRAD_BEGIN
 
@@ -81,24 +85,30 @@ void ECheckSizes_AA_2D(const Array1 &array_1, const Array2 &array_2)
 //--------------------------------------------------------------
 
 template <class Array, class Functor>
-void Apply_A_2D_F1(Array &&array, Functor functor)
+void Apply_A_2D_F1(Array &&array, Functor functor, omp_usage_t omp)
 {
 	if(array.steps(1) < array.steps(0))
 	{
-		for (size_t i = 0; i < array.sizes(0); ++i)
+		BAI_OMP_aux::for_each_index(array.sizes(0), omp, "Apply_A_2D_F1", [&](size_t i)
 		{
 			Apply_A_1D_F1(array.row(i), functor);
-		}
+		});
 	}
 	else
 	{
-		for (size_t i = 0; i < array.sizes(1); ++i)
+		BAI_OMP_aux::for_each_index(array.sizes(1), omp, "Apply_A_2D_F1", [&](size_t i)
 		{
 			Apply_A_1D_F1(array.col(i), functor);
-		}
+		});
 	}
 }
 
+template <class Array, class Functor>
+void Apply_A_2D_F1(Array &&array, Functor functor)
+{
+	Apply_A_2D_F1(array, functor, AutoOMPUsage(functor, array.sizes(0)*array.sizes(1)));
+}
+
 //--------------------------------------------------------------
 
 namespace Functors
@@ -183,49 +193,61 @@ void Apply_A_2D_RF1(Array &&array, Functor functor)
 //--------------------------------------------------------------
 
 template <class Array, class Scalar, class Functor>
-void Apply_AS_2D_F2(Array &&array, Scalar &&scalar, Functor functor)
+void Apply_AS_2D_F2(Array &&array, Scalar &&scalar, Functor functor, omp_usage_t omp)
 {
 	if(array.steps(1) < array.steps(0))
 	{
-		for (size_t i = 0; i < array.sizes(0); ++i)
+		BAI_OMP_aux::for_each_index(array.sizes(0), omp, "Apply_AS_2D_F2", [&](size_t i)
 		{
 			Apply_AS_1D_F2(array.row(i), scalar, functor);
-		}
+		});
 	}
 	else
 	{
-		for (size_t i = 0; i < array.sizes(1); ++i)
+		BAI_OMP_aux::for_each_index(array.sizes(1), omp, "Apply_AS_2D_F2", [&](size_t i)
 		{
 			Apply_AS_1D_F2(array.col(i), scalar, functor);
-		}
+		});
 	}
 }
 
+template <class Array, class Scalar, class Functor>
+void Apply_AS_2D_F2(Array &&array, Scalar &&scalar, Functor functor)
+{
+	Apply_AS_2D_F2(array, scalar, functor, AutoOMPUsage(functor, array.sizes(0)*array.sizes(1)));
+}
+
 //--------------------------------------------------------------
 
 struct Apply_AA_2D_F2_name { static const char *name() { return "Apply_AA_2D_F2"; } };
 
 template <class Array1, class Array2, class Functor>
-void Apply_AA_2D_F2(Array1 &&array_1, Array2 &&array_2, Functor functor)
+void Apply_AA_2D_F2(Array1 &&array_1, Array2 &&array_2, Functor functor, omp_usage_t omp)
 {
 	ECheckSizes_AA_2D<Apply_AA_2D_F2_name>(array_1, array_2);
 
 	if(array_1.steps(1) < array_1.steps(0))
 	{
-		for (size_t i = 0; i < array_1.sizes(0); ++i)
+		BAI_OMP_aux::for_each_index(array_1.sizes(0), omp, Apply_AA_2D_F2_name::name(), [&](size_t i)
 		{
 			Apply_AA_1D_F2(array_1.row(i), array_2.row(i), functor);
-		}
+		});
 	}
 	else
 	{
-		for (size_t i = 0; i < array_1.sizes(1); ++i)
+		BAI_OMP_aux::for_each_index(array_1.sizes(1), omp, Apply_AA_2D_F2_name::name(), [&](size_t i)
 		{
 			Apply_AA_1D_F2(array_1.col(i), array_2.col(i), functor);
-		}
+		});
 	}
 }
 
+template <class Array1, class Array2, class Functor>
+void Apply_AA_2D_F2(Array1 &&array_1, Array2 &&array_2, Functor functor)
+{
+	Apply_AA_2D_F2(array_1, array_2, functor, AutoOMPUsage(functor, array_1.sizes(0)*array_1.sizes(1)));
+}
+
 //--------------------------------------------------------------
 
 template <class Array1, class Array2, class Functor>
@@ -335,52 +357,64 @@ bool Apply_Any_AA_2D_RF2(Array1 &&array_1, Array2 &&array_2, Functor functor)
 struct Apply_AAA_2D_F3_name { static const char *name() { return "Apply_AAA_2D_F3"; } };
 
 template <class Array1, class Array2, class Array3, class Functor>
-void Apply_AAA_2D_F3(Array1 &&array_1, Array2 &&array_2, Array3 &&array_3, Functor functor)
+void Apply_AAA_2D_F3(Array1 &&array_1, Array2 &&array_2, Array3 &&array_3, Functor functor, omp_usage_t omp)
 {
 	ECheckSizes_AA_2D<Apply_AAA_2D_F3_name>(array_1, array_2);
 	ECheckSizes_AA_2D<Apply_AAA_2D_F3_name>(array_2, array_3);
 
 	if(array_1.steps(1) < array_1.steps(0))
 	{
-		for (size_t i = 0; i < array_1.sizes(0); ++i)
+		BAI_OMP_aux::for_each_index(array_1.sizes(0), omp, Apply_AAA_2D_F3_name::name(), [&](size_t i)
 		{
 			Apply_AAA_1D_F3(array_1.row(i), array_2.row(i), array_3.row(i), functor);
-		}
+		});
 	}
 	else
 	{
-		for (size_t i = 0; i < array_1.sizes(1); ++i)
+		BAI_OMP_aux::for_each_index(array_1.sizes(1), omp, Apply_AAA_2D_F3_name::name(), [&](size_t i)
 		{
 			Apply_AAA_1D_F3(array_1.col(i), array_2.col(i), array_3.col(i), functor);
-		}
+		});
 	}
 }
 
+template <class Array1, class Array2, class Array3, class Functor>
+void Apply_AAA_2D_F3(Array1 &&array_1, Array2 &&array_2, Array3 &&array_3, Functor functor)
+{
+	Apply_AAA_2D_F3(array_1, array_2, array_3, functor, AutoOMPUsage(functor, array_1.sizes(0)*array_1.sizes(1)));
+}
+
 //--------------------------------------------------------------
 
 struct Apply_AAS_2D_F3_name { static const char *name() { return "Apply_AAS_2D_F3"; } };
 
 template <class Array1, class Array2, class Scalar, class Functor>
-void Apply_AAS_2D_F3(Array1 &&array_1, Array2 &&array_2, Scalar &&scalar, Functor functor)
+void Apply_AAS_2D_F3(Array1 &&array_1, Array2 &&array_2, Scalar &&scalar, Functor functor, omp_usage_t omp)
 {
 	ECheckSizes_AA_2D<Apply_AAS_2D_F3_name>(array_1, array_2);
 
 	if(array_1.steps(1) < array_1.steps(0))
 	{
-		for (size_t i = 0; i < array_1.sizes(0); ++i)
+		BAI_OMP_aux::for_each_index(array_1.sizes(0), omp, Apply_AAS_2D_F3_name::name(), [&](size_t i)
 		{
 			Apply_AAS_1D_F3(array_1.row(i), array_2.row(i), scalar, functor);
-		}
+		});
 	}
 	else
 	{
-		for (size_t i = 0; i < array_1.sizes(1); ++i)
+		BAI_OMP_aux::for_each_index(array_1.sizes(1), omp, Apply_AAS_2D_F3_name::name(), [&](size_t i)
 		{
 			Apply_AAS_1D_F3(array_1.col(i), array_2.col(i), scalar, functor);
-		}
+		});
 	}
 }
 
+template <class Array1, class Array2, class Scalar, class Functor>
+void Apply_AAS_2D_F3(Array1 &&array_1, Array2 &&array_2, Scalar &&scalar, Functor functor)
+{
+	Apply_AAS_2D_F3(array_1, array_2, scalar, functor, AutoOMPUsage(functor, array_1.sizes(0)*array_1.sizes(1)));
+}
+
 //--------------------------------------------------------------
 
 XRAD_END
@@ -14,6 +14,9 @@
 	Данный файл не должен зависеть от DataArrayMD. Он зависит только от соглашения
 	об _интерфейсе_ класса.
 
+	Apply_A_MD_F1(), Apply_AS_MD_F2(), Apply_AA_MD_F2(), Apply_AAA_MD_F3(), Apply_AAS_MD_F3()
+	могут обрабатывать срезы в нескольких потоках, см. BasicArrayInteractionsOMP.h.
+
 	В функциях ниже используются шаблоны с универальными ссылками вида:
 
 	~~~~
@@ -144,7 +147,7 @@ struct constness_types<const Array>
 struct Apply_A_MD_F1_name { static const char *name() { return "Apply_A_MD_F1"; } };
 
 template <class Array, class Functor>
-void Apply_A_MD_F1(Array &array, Functor functor)
+void Apply_A_MD_F1(Array &array, Functor functor, omp_usage_t omp)
 {
 	if(array.empty())
 	{
@@ -159,7 +162,7 @@ void Apply_A_MD_F1(Array &array, Functor functor)
 	MaxValue(array.steps(), &scan_dimension);
 	const size_t	scan_size = array.sizes(scan_dimension);
 	size_t	n_dimensions = array.n_dimensions();
-	for(size_t i = 0; i < scan_size; ++i)
+	BAI_OMP_aux::for_each_index(scan_size, omp, Apply_A_MD_F1_name::name(), [&](size_t i)
 	{
 		index_vector	subset_mask = MDAT_aux::GetSubsetMask(array, scan_dimension, i);
 		if(n_dimensions > 3)
@@ -167,16 +170,22 @@ void Apply_A_MD_F1(Array &array, Functor functor)
 			typename MDAT_aux::constness_types<Array>::array_type subset;
 			array.GetSubset(subset, subset_mask);
 			// рекурсия
-			Apply_A_MD_F1(subset, functor);
+			Apply_A_MD_F1(subset, functor, e_dont_use_omp);
 		}
 		else
 		{
 			typename MDAT_aux::constness_types<Array>::slice_type slice;
 			array.GetSlice(slice, subset_mask);
 			// конец рекурсии, обработка двумерного среза
-			Apply_A_2D_F1(slice, functor);
+			Apply_A_2D_F1(slice, functor, e_dont_use_omp);
 		}
-	}
+	});
+}
+
+template <class Array, class Functor>
+void Apply_A_MD_F1(Array &array, Functor functor)
+{
+	Apply_A_MD_F1(array, functor, AutoOMPUsage(functor, array.element_count()));
 }
 
 //--------------------------------------------------------------
@@ -299,7 +308,7 @@ void Apply_A_MD_RF1(Array &array, Functor functor)
 struct Apply_AS_MD_F2_name { static const char *name() { return "Apply_AS_MD_F2"; } };
 
 template <class Array, class Scalar, class Functor>
-void Apply_AS_MD_F2(Array &array, Scalar &scalar, Functor functor)
+void Apply_AS_MD_F2(Array &array, Scalar &scalar, Functor functor, omp_usage_t omp)
 {
 	if(array.empty())
 	{
@@ -314,7 +323,7 @@ void Apply_AS_MD_F2(Array &array, Scalar &scalar, Functor functor)
 	MaxValue(array.steps(), &scan_dimension);
 	const size_t	scan_size = array.sizes(scan_dimension);
 	size_t	n_dimensions = array.n_dimensions();
-	for(size_t i = 0; i < scan_size; ++i)
+	BAI_OMP_aux::for_each_index(scan_size, omp, Apply_AS_MD_F2_name::name(), [&](size_t i)
 	{
 		index_vector	subset_mask = MDAT_aux::GetSubsetMask(array, scan_dimension, i);
 		if(n_dimensions > 3)
@@ -322,16 +331,22 @@ void Apply_AS_MD_F2(Array &array, Scalar &scalar, Functor functor)
 			typename MDAT_aux::constness_types<Array>::array_type subset;
 			array.GetSubset(subset, subset_mask);
 			// рекурсия
-			Apply_AS_MD_F2(subset, scalar, functor);
+			Apply_AS_MD_F2(subset, scalar, functor, e_dont_use_omp);
 		}
 		else
 		{
 			typename MDAT_aux::constness_types<Array>::slice_type slice;
 			array.GetSlice(slice, subset_mask);
 			// конец рекурсии, обработка двумерного среза
-			Apply_AS_2D_F2(slice, scalar, functor);
+			Apply_AS_2D_F2(slice, scalar, functor, e_dont_use_omp);
 		}
-	}
+	});
+}
+
+template <class Array, class Scalar, class Functor>
+void Apply_AS_MD_F2(Array &array, Scalar &scalar, Functor functor)
+{
+	Apply_AS_MD_F2(array, scalar, functor, AutoOMPUsage(functor, array.element_count()));
 }
 
 //--------------------------------------------------------------
@@ -339,7 +354,7 @@ void Apply_AS_MD_F2(Array &array, Scalar &scalar, Functor functor)
 struct Apply_AA_MD_F2_name { static const char *name() { return "Apply_AA_MD_F2"; } };
 
 template <class Array1, class Array2, class Functor>
-void Apply_AA_MD_F2(Array1 &array_1, Array2 &array_2, Functor functor)
+void Apply_AA_MD_F2(Array1 &array_1, Array2 &array_2, Functor functor, omp_usage_t omp)
 {
 	if(array_1.empty() && array_2.empty())
 	{
@@ -356,7 +371,7 @@ void Apply_AA_MD_F2(Array1 &array_1, Array2 &array_2, Functor functor)
 
 	size_t	n_dimensions = array_1.n_dimensions();
 
-	for(size_t i = 0; i < scan_size; ++i)
+	BAI_OMP_aux::for_each_index(scan_size, omp, Apply_AA_MD_F2_name::name(), [&](size_t i)
 	{
 		index_vector	subset_mask = MDAT_aux::GetSubsetMask(array_1, scan_dimension, i);
 
@@ -369,7 +384,7 @@ void Apply_AA_MD_F2(Array1 &array_1, Array2 &array_2, Functor functor)
 			array_2.GetSubset(subset_2, subset_mask);
 
 			// рекурсия
-			Apply_AA_MD_F2(subset_1, subset_2, functor);
+			Apply_AA_MD_F2(subset_1, subset_2, functor, e_dont_use_omp);
 		}
 		else
 		{
@@ -380,9 +395,15 @@ void Apply_AA_MD_F2(Array1 &array_1, Array2 &array_2, Functor functor)
 			array_2.GetSlice(slice_2, subset_mask);
 
 			// конец рекурсии, обработка двумерного среза
-			Apply_AA_2D_F2(slice_1, slice_2, functor);
+			Apply_AA_2D_F2(slice_1, slice_2, functor, e_dont_use_omp);
 		}
-	}
+	});
+}
+
+template <class Array1, class Array2, class Functor>
+void Apply_AA_MD_F2(Array1 &array_1, Array2 &array_2, Functor functor)
+{
+	Apply_AA_MD_F2(array_1, array_2, functor, AutoOMPUsage(functor, array_1.element_count()));
 }
 
 //--------------------------------------------------------------
@@ -550,7 +571,7 @@ bool Apply_Any_AA_MD_RF2(Array1 &&array_1, Array2 &&array_2, Functor functor)
 struct Apply_AAA_MD_F3_name { static const char *name() { return "Apply_AAA_MD_F3"; } };
 
 template <class Array1, class Array2, class Array3, class Functor>
-void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor functor)
+void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor functor, omp_usage_t omp)
 {
 	if(array_1.empty() && array_2.empty() && array_3.empty())
 	{
@@ -568,7 +589,7 @@ void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor
 
 	size_t	n_dimensions = array_1.n_dimensions();
 
-	for(size_t i = 0; i < scan_size; ++i)
+	BAI_OMP_aux::for_each_index(scan_size, omp, Apply_AAA_MD_F3_name::name(), [&](size_t i)
 	{
 		index_vector	subset_mask = MDAT_aux::GetSubsetMask(array_1, scan_dimension, i);
 
@@ -583,7 +604,7 @@ void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor
 			array_3.GetSubset(subset_3, subset_mask);
 
 			// рекурсия
-			Apply_AAA_MD_F3(subset_1, subset_2, subset_3, functor);
+			Apply_AAA_MD_F3(subset_1, subset_2, subset_3, functor, e_dont_use_omp);
 		}
 		else
 		{
@@ -596,9 +617,15 @@ void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor
 			array_3.GetSlice(slice_3, subset_mask);
 
 			// конец рекурсии, обработка двумерного среза
-			Apply_AAA_2D_F3(slice_1, slice_2, slice_3, functor);
+			Apply_AAA_2D_F3(slice_1, slice_2, slice_3, functor, e_dont_use_omp);
 		}
-	}
+	});
+}
+
+template <class Array1, class Array2, class Array3, class Functor>
+void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor functor)
+{
+	Apply_AAA_MD_F3(array_1, array_2, array_3, functor, AutoOMPUsage(functor, array_1.element_count()));
 }
 
 //--------------------------------------------------------------
@@ -606,7 +633,7 @@ void Apply_AAA_MD_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, Functor
 struct Apply_AAS_MD_F3_name { static const char *name() { return "Apply_AAS_MD_F3"; } };
 
 template <class Array1, class Array2, class Scalar, class Functor>
-void Apply_AAS_MD_F3(Array1 &array_1, Array2 &array_2, Scalar &scalar, Functor functor)
+void Apply_AAS_MD_F3(Array1 &array_1, Array2 &array_2, Scalar &scalar, Functor functor, omp_usage_t omp)
 {
 	if(array_1.empty() && array_2.empty())
 	{
@@ -623,7 +650,7 @@ void Apply_AAS_MD_F3(Array1 &array_1, Array2 &array_2, Scalar &scalar, Functor f
 
 	size_t	n_dimensions = array_1.n_dimensions();
 
-	for(size_t i = 0; i < scan_size; ++i)
+	BAI_OMP_aux::for_each_index(scan_size, omp, Apply_AAS_MD_F3_name::name(), [&](size_t i)
 	{
 		index_vector	subset_mask = MDAT_aux::GetSubsetMask(array_1, scan_dimension, i);
 
@@ -636,7 +663,7 @@ void Apply_AAS_MD_F3(Array1 &array_1, Array2 &array_2, Scalar &scalar, Functor f
 			array_2.GetSubset(subset_2, subset_mask);
 
 			// рекурсия
-			Apply_AAS_MD_F3(subset_1, subset_2, scalar, functor);
+			Apply_AAS_MD_F3(subset_1, subset_2, scalar, functor, e_dont_use_omp);
 		}
 		else
 		{
@@ -647,9 +674,15 @@ void Apply_AAS_MD_F3(Array1 &array_1, Array2 &array_2, Scalar &scalar, Functor f
 			array_2.GetSlice(slice_2, subset_mask);
 
 			// конец рекурсии, обработка двумерного среза
-			Apply_AAS_2D_F3(slice_1, slice_2, scalar, functor);
+			Apply_AAS_2D_F3(slice_1, slice_2, scalar, functor, e_dont_use_omp);
 		}
-	}
+	});
+}
+
+template <class Array1, class Array2, class Scalar, class Functor>
+void Apply_AAS_MD_F3(Array1 &array_1, Array2 &array_2, Scalar &scalar, Functor functor)
+{
+	Apply_AAS_MD_F3(array_1, array_2, scalar, functor, AutoOMPUsage(functor, array_1.element_count()));
 }
 
 //--------------------------------------------------------------
@@ -0,0 +1,176 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file BasicArrayInteractionsOMP.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_BasicArrayInteractionsOMP_h
+#define XRAD__File_BasicArrayInteractionsOMP_h
+/*!
+	\file
+	\brief Многопоточное выполнение операций над двумерными и многомерными массивами
+
+	Внутренний файл библиотеки, включается из BasicArrayInteractions2D.h.
+
+	Функции Apply_*_2D_* и Apply_*_MD_* (F1, F2, F3) имеют перегрузки с последним параметром
+	omp_usage_t. При e_use_omp строки (столбцы) двумерного массива или срезы многомерного массива
+	по измерению с наибольшим шагом распределяются между потоками OpenMP. Исключения, выброшенные
+	функтором, собираются ThreadErrorCollector и передаются вызывающему коду после завершения цикла.
+
+	Перегрузки без параметра omp_usage_t выбирают режим автоматически (AutoOMPUsage()):
+	многопоточно выполняются только операции с функторами, для которых
+	is_parallel_functor<Functor>::value == true, над массивами из не менее чем
+	parallel_interactions_min_size элементов. Это арифметические функторы из Functors.h,
+	которые используются в операторах алгебры массивов, MakeCopy() и CopyData().
+
+	Пользовательский функтор, не имеющий изменяемого состояния, можно отметить специализацией
+	is_parallel_functor или передать e_use_omp явно:
+
+	~~~~
+	Apply_AA_MD_F2(volume, original, my_functor(), e_use_omp);
+	~~~~
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Core.h>
+#include <XRADBasic/Sources/Core/Functors.h>
+#include <type_traits>
+
+XRAD_BEGIN
+
+namespace Functors
+{
+class assign_absolute_value;
+} // namespace Functors
+
+//--------------------------------------------------------------
+
+//! \brief Минимальное число элементов массива, начиная с которого AutoOMPUsage() выбирает e_use_omp
+const size_t parallel_interactions_min_size = 1 << 18;
+
+/*!
+	\brief Признак функтора, который можно вызывать одновременно из нескольких потоков
+	для разных элементов
+
+	Такой функтор не должен иметь изменяемого состояния (счетчиков, сумм и т.п.)
+	и не должен зависеть от порядка обхода элементов.
+*/
+template <class Functor>
+struct is_parallel_functor: std::false_type {};
+
+template <> struct is_parallel_functor<Functors::increment>: std::true_type {};
+template <> struct is_parallel_functor<Functors::decrement>: std::true_type {};
+template <> struct is_parallel_functor<Functors::unary_minus_inplace>: std::true_type {};
+template <> struct is_parallel_functor<Functors::bitwise_not_inplace>: std::true_type {};
+
+template <> struct is_parallel_functor<Functors::assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_unary_minus>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_logical_not>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_bitwise_not>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_absolute_value>: std::true_type {};
+
+template <> struct is_parallel_functor<Functors::plus_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::minus_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::multiply_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::divide_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::percent_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::bitwise_and_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::bitwise_or_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::bitwise_xor_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::logical_and_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::logical_or_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::logical_xor_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::shl_assign>: std::true_type {};
+template <> struct is_parallel_functor<Functors::shr_assign>: std::true_type {};
+
+template <> struct is_parallel_functor<Functors::assign_plus>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_minus>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_multiply>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_divide>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_percent>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_logical_and>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_logical_or>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_logical_xor>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_bitwise_and>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_bitwise_or>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_bitwise_xor>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_shl>: std::true_type {};
+template <> struct is_parallel_functor<Functors::assign_shr>: std::true_type {};
+
+template <> struct is_parallel_functor<Functors::plus_assign_multiply>: std::true_type {};
+template <> struct is_parallel_functor<Functors::plus_assign_divide>: std::true_type {};
+template <> struct is_parallel_functor<Functors::minus_assign_multiply>: std::true_type {};
+template <> struct is_parallel_functor<Functors::minus_assign_divide>: std::true_type {};
+
+template <class TA, class TB>
+struct is_parallel_functor<Functors::assign_mix<TA, TB>>: std::true_type {};
+
+//--------------------------------------------------------------
+
+//! \brief Режим выполнения по умолчанию для операции над массивом из n_elements элементов
+template <class Functor>
+omp_usage_t AutoOMPUsage(const Functor &, size_t n_elements)
+{
+	return is_parallel_functor<Functor>::value && n_elements >= parallel_interactions_min_size ?
+			e_use_omp: e_dont_use_omp;
+}
+
+//--------------------------------------------------------------
+
+namespace BAI_OMP_aux
+{
+
+/*!
+	\brief Вызов f(i) для i = 0, ..., n-1
+
+	При omp == e_use_omp итерации распределяются между потоками. Первое же исключение
+	прекращает выдачу новых итераций; после завершения цикла исключение выбрасывается
+	через ThreadErrorCollector::ThrowIfErrors().
+*/
+template <class F>
+void	for_each_index(size_t n, omp_usage_t omp, const char *name, const F &f)
+{
+	if(omp == e_use_omp && n > 1)
+	{
+		ThreadErrorCollector ec(name);
+		#pragma omp parallel for schedule (guided)
+		for(ptrdiff_t i = 0; i < ptrdiff_t(n); ++i)
+		{
+			if (ec.HasErrors())
+			{
+#ifdef XRAD_COMPILER_MSC
+				break;
+#else
+				continue;
+#endif
+			}
+			ThreadSetup ts; (void)ts;
+			try
+			{
+				f(size_t(i));
+			}
+			catch (...)
+			{
+				ec.CatchException();
+			}
+		}
+		ec.ThrowIfErrors();
+	}
+	else
+	{
+		for(size_t i = 0; i < n; ++i)
+		{
+			f(i);
+		}
+	}
+}
+
+} // namespace BAI_OMP_aux
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_BasicArrayInteractionsOMP_h
@@ -0,0 +1,435 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file BasicArrayInteractionsSIMD.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_BasicArrayInteractionsSIMD_h
+#define XRAD__File_BasicArrayInteractionsSIMD_h
+/*!
+	\file
+	\brief Выбор векторизованных ядер для Apply_AA_1D_F2(), Apply_AS_1D_F2(), Apply_AAA_1D_F3(),
+	Apply_AAS_1D_F3()
+
+	Внутренний файл библиотеки, включается из BasicArrayInteractions1D.h.
+
+	Функции AA_F2(), AS_F2(), AAA_F3(), AAS_F3() выполняют операцию ядром из ArrayInteractionsSIMD.h
+	и возвращают true, если:
+	- функтор известен: Functors::plus_assign, minus_assign, multiply_assign, divide_assign,
+		percent_assign, assign_plus, assign_minus, assign_multiply, assign_divide, assign_percent,
+		assign_absolute_value (только AA_F2);
+	- все массивы имеют метод step(), шаг равен 1, тип элементов float, double, int16_t
+		или complexF32, одинаковый у всех массивов (для assign_absolute_value: complexF32 и float);
+	- тип скаляра не меняет точность вычислений (см. element_kernels);
+	- размер не меньше simd_min_size, массивы не перекрываются частично;
+	- ActiveSIMDInstructionSet() >= e_simd_avx2.
+
+	Иначе возвращается false, и вызывающая функция выполняет обычный цикл по итераторам.
+	Результат в обоих случаях одинаковый, кроме assign_absolute_value для complexF32:
+	модуль вычисляется через double и может отличаться от скалярного пути на 1 ulp.
+*/
+//--------------------------------------------------------------
+
+#include "ArrayInteractionsSIMD.h"
+#include <XRADBasic/Sources/Core/Functors.h>
+#include <type_traits>
+#include <cstdint>
+
+XRAD_BEGIN
+
+template <class PT, class ST>
+class ComplexSample;
+
+namespace Functors
+{
+class assign_absolute_value;
+} // namespace Functors
+
+namespace ArrayInteractionsSIMD
+{
+
+//--------------------------------------------------------------
+
+//! \brief Минимальный размер массива, для которого используются векторизованные ядра
+const size_t simd_min_size = 16;
+
+enum
+{
+	//! \brief Функтор не имеет векторизованной реализации
+	e_no_operation = -1,
+	//! \brief Functors::assign_absolute_value
+	e_absolute_value = -2
+};
+
+//! \brief Операция функтора вида f(r, x): r op= x
+template <class Functor> struct compound_operation: std::integral_constant<int, e_no_operation> {};
+template <> struct compound_operation<Functors::plus_assign>: std::integral_constant<int, e_add> {};
+template <> struct compound_operation<Functors::minus_assign>: std::integral_constant<int, e_subtract> {};
+template <> struct compound_operation<Functors::multiply_assign>: std::integral_constant<int, e_multiply> {};
+template <> struct compound_operation<Functors::divide_assign>: std::integral_constant<int, e_divide> {};
+template <> struct compound_operation<Functors::percent_assign>: std::integral_constant<int, e_multiply_conj> {};
+template <> struct compound_operation<Functors::assign_absolute_value>: std::integral_constant<int, e_absolute_value> {};
+
+//! \brief Операция функтора вида f(r, x, y): r = x op y
+template <class Functor> struct assign_operation: std::integral_constant<int, e_no_operation> {};
+template <> struct assign_operation<Functors::assign_plus>: std::integral_constant<int, e_add> {};
+template <> struct assign_operation<Functors::assign_minus>: std::integral_constant<int, e_subtract> {};
+template <> struct assign_operation<Functors::assign_multiply>: std::integral_constant<int, e_multiply> {};
+template <> struct assign_operation<Functors::assign_divide>: std::integral_constant<int, e_divide> {};
+template <> struct assign_operation<Functors::assign_percent>: std::integral_constant<int, e_multiply_conj> {};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Вызов ядер для типа элементов T
+
+	Общий шаблон: тип не поддерживается. Специализации задают binary(), scalar(), abs().
+	Перегрузки scalar() принимают только такие типы скаляра, для которых скалярный код
+	выполняет вычисления в той же точности, что и ядро; для прочих возвращается false.
+*/
+template <class T>
+struct element_kernels
+{
+	static constexpr bool supported = false;
+};
+
+template <>
+struct element_kernels<float>
+{
+	static constexpr bool supported = true;
+
+	static bool binary(const Kernels *k, binary_operation op, const float *a, const float *b, float *out, size_t size)
+	{
+		return k->binary_f32(op, a, b, out, size);
+	}
+	static bool scalar(const Kernels *k, binary_operation op, const float *a, float x, float *out, size_t size)
+	{
+		return k->scalar_f32(op, a, x, out, size);
+	}
+	// float op double вычисляется в double
+	static bool scalar(const Kernels *k, binary_operation op, const float *a, double x, float *out, size_t size)
+	{
+		return k->scalar_f32_f64(op, a, x, out, size);
+	}
+	// float op int вычисляется во float
+	template <class S>
+	static bool scalar(const Kernels *k, binary_operation op, const float *a, const S &x, float *out, size_t size)
+	{
+		if constexpr (std::is_integral<S>::value)
+			return k->scalar_f32(op, a, float(x), out, size);
+		else
+			return false;
+	}
+	static bool abs(const Kernels *k, const float *a, float *out, size_t size)
+	{
+		k->abs_f32(a, out, size);
+		return true;
+	}
+	template <class R>
+	static bool abs(const Kernels *, const float *, R *, size_t) { return false; }
+};
+
+template <>
+struct element_kernels<double>
+{
+	static constexpr bool supported = true;
+
+	static bool binary(const Kernels *k, binary_operation op, const double *a, const double *b, double *out, size_t size)
+	{
+		return k->binary_f64(op, a, b, out, size);
+	}
+	template <class S>
+	static bool scalar(const Kernels *k, binary_operation op, const double *a, const S &x, double *out, size_t size)
+	{
+		if constexpr (std::is_arithmetic<S>::value && !std::is_same<S, long double>::value)
+			return k->scalar_f64(op, a, double(x), out, size);
+		else
+			return false;
+	}
+	static bool abs(const Kernels *k, const double *a, double *out, size_t size)
+	{
+		k->abs_f64(a, out, size);
+		return true;
+	}
+	template <class R>
+	static bool abs(const Kernels *, const double *, R *, size_t) { return false; }
+};
+
+template <>
+struct element_kernels<int16_t>
+{
+	static constexpr bool supported = true;
+
+	static bool binary(const Kernels *k, binary_operation op, const int16_t *a, const int16_t *b, int16_t *out, size_t size)
+	{
+		return k->binary_i16(op, a, b, out, size);
+	}
+	// short op int с присваиванием в short дает результат по модулю 2^16
+	template <class S>
+	static bool scalar(const Kernels *k, binary_operation op, const int16_t *a, const S &x, int16_t *out, size_t size)
+	{
+		if constexpr (std::is_integral<S>::value)
+			return k->scalar_i16(op, a, int16_t(x), out, size);
+		else
+			return false;
+	}
+	static bool abs(const Kernels *k, const int16_t *a, int16_t *out, size_t size)
+	{
+		k->abs_i16(a, out, size);
+		return true;
+	}
+	template <class R>
+	static bool abs(const Kernels *, const int16_t *, R *, size_t) { return false; }
+};
+
+template <>
+struct element_kernels<ComplexSample<float, double>>
+{
+	static constexpr bool supported = true;
+	using complex_type = ComplexSample<float, double>;
+
+	static bool binary(const Kernels *k, binary_operation op, const complex_type *a, const complex_type *b, complex_type *out, size_t size)
+	{
+		return k->binary_cf32(op, reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b),
+				reinterpret_cast<float*>(out), size);
+	}
+	template <class ST>
+	static bool scalar(const Kernels *k, binary_operation op, const complex_type *a, const ComplexSample<float, ST> &x, complex_type *out, size_t size)
+	{
+		float	xf[2] = {x.re, x.im};
+		return k->scalar_cf32(op, reinterpret_cast<const float*>(a), xf, reinterpret_cast<float*>(out), size);
+	}
+	// Умножение и деление на вещественное число: каждая компонента, вычисление в double (ComplexSample::operator*=(ST))
+	template <class S>
+	static bool scalar(const Kernels *k, binary_operation op, const complex_type *a, const S &x, complex_type *out, size_t size)
+	{
+		if constexpr (std::is_arithmetic<S>::value && !std::is_same<S, long double>::value)
+			return (op == e_multiply || op == e_divide) &&
+					k->scalar_f32_f64(op, reinterpret_cast<const float*>(a), double(x), reinterpret_cast<float*>(out), 2*size);
+		else
+			return false;
+	}
+	static bool abs(const Kernels *k, const complex_type *a, float *out, size_t size)
+	{
+		k->abs_cf32(reinterpret_cast<const float*>(a), out, size);
+		return true;
+	}
+	template <class R>
+	static bool abs(const Kernels *, const complex_type *, R *, size_t) { return false; }
+};
+
+//--------------------------------------------------------------
+
+//! \brief Тип элементов массива (без const)
+template <class Array>
+using element_t = std::remove_cv_t<std::remove_reference_t<decltype(std::declval<Array&>()[0])>>;
+
+//! \brief Массив с методом step() и поддерживаемым типом элементов
+template <class Array, class = void>
+struct is_simd_array: std::false_type {};
+
+template <class Array>
+struct is_simd_array<Array, void_t<decltype(std::declval<Array&>().step())>>:
+	std::integral_constant<bool, element_kernels<element_t<Array>>::supported>
+{
+};
+
+//! \brief Массив, допускающий запись
+template <class Array>
+struct is_simd_output_array: std::integral_constant<bool,
+		is_simd_array<Array>::value &&
+		!std::is_const<std::remove_reference_t<decltype(std::declval<Array&>()[0])>>::value>
+{
+};
+
+//! \brief Проверка, что выход совпадает со входом или не пересекается с ним
+inline bool separate_or_same(const void *out, size_t out_bytes, const void *in, size_t in_bytes)
+{
+	uintptr_t	o = reinterpret_cast<uintptr_t>(out), i = reinterpret_cast<uintptr_t>(in);
+	return o == i || o + out_bytes <= i || i + in_bytes <= o;
+}
+
+template <class Array>
+bool is_contiguous(const Array &array)
+{
+	return array.step() == 1;
+}
+
+//--------------------------------------------------------------
+
+namespace BAI_SIMD_aux
+{
+
+template <class Out, class In, int op>
+bool unary_kernel(Out &, In &, std::integral_constant<int, op>, std::false_type)
+{
+	return false;
+}
+
+// out_array op= in_array
+template <class Out, class In, int op>
+bool unary_kernel(Out &out_array, In &in_array, std::integral_constant<int, op>, std::true_type)
+{
+	using T = element_t<Out>;
+	size_t	size = out_array.size();
+	if(size < simd_min_size || !is_contiguous(out_array) || !is_contiguous(in_array))
+		return false;
+	const Kernels	*k = ActiveKernels();
+	if(!k)
+		return false;
+	T	*out = &out_array[0];
+	const T	*in = &in_array[0];
+	if(!separate_or_same(out, size*sizeof(T), in, size*sizeof(T)))
+		return false;
+	return element_kernels<T>::binary(k, binary_operation(op), out, in, out, size);
+}
+
+// out_array = |in_array|
+template <class Out, class In>
+bool unary_kernel(Out &out_array, In &in_array, std::integral_constant<int, e_absolute_value>, std::true_type)
+{
+	using T = element_t<In>;
+	using R = element_t<Out>;
+	size_t	size = out_array.size();
+	if(size < simd_min_size || !is_contiguous(out_array) || !is_contiguous(in_array))
+		return false;
+	const Kernels	*k = ActiveKernels();
+	if(!k)
+		return false;
+	R	*out = &out_array[0];
+	const T	*in = &in_array[0];
+	if(!separate_or_same(out, size*sizeof(R), in, size*sizeof(T)))
+		return false;
+	return element_kernels<T>::abs(k, in, out, size);
+}
+
+template <class Out, class In1, class In2, int op>
+bool binary_kernel(Out &, In1 &, In2 &, std::integral_constant<int, op>, std::false_type)
+{
+	return false;
+}
+
+// out_array = in_array_1 op in_array_2
+template <class Out, class In1, class In2, int op>
+bool binary_kernel(Out &out_array, In1 &in_array_1, In2 &in_array_2, std::integral_constant<int, op>, std::true_type)
+{
+	using T = element_t<Out>;
+	size_t	size = out_array.size();
+	if(size < simd_min_size || !is_contiguous(out_array) || !is_contiguous(in_array_1) || !is_contiguous(in_array_2))
+		return false;
+	const Kernels	*k = ActiveKernels();
+	if(!k)
+		return false;
+	T	*out = &out_array[0];
+	const T	*in_1 = &in_array_1[0];
+	const T	*in_2 = &in_array_2[0];
+	if(!separate_or_same(out, size*sizeof(T), in_1, size*sizeof(T)) ||
+			!separate_or_same(out, size*sizeof(T), in_2, size*sizeof(T)))
+	{
+		return false;
+	}
+	return element_kernels<T>::binary(k, binary_operation(op), in_1, in_2, out, size);
+}
+
+template <class Out, class In, class S, int op>
+bool scalar_kernel(Out &, In &, const S &, std::integral_constant<int, op>, std::false_type)
+{
+	return false;
+}
+
+// out_array = in_array op x
+template <class Out, class In, class S, int op>
+bool scalar_kernel(Out &out_array, In &in_array, const S &x, std::integral_constant<int, op>, std::true_type)
+{
+	using T = element_t<Out>;
+	size_t	size = out_array.size();
+	if(size < simd_min_size || !is_contiguous(out_array) || !is_contiguous(in_array))
+		return false;
+	const Kernels	*k = ActiveKernels();
+	if(!k)
+		return false;
+	T	*out = &out_array[0];
+	const T	*in = &in_array[0];
+	if(!separate_or_same(out, size*sizeof(T), in, size*sizeof(T)))
+		return false;
+	return element_kernels<T>::scalar(k, binary_operation(op), in, x, out, size);
+}
+
+//! \brief Условие применимости ядра для массивов одного типа
+template <int op, class Out, class... In>
+struct same_type_applicable;
+
+template <int op, class Out>
+struct same_type_applicable<op, Out>:
+	std::integral_constant<bool, op >= 0 && is_simd_output_array<Out>::value>
+{
+};
+
+template <int op, class Out, class In, class... Rest>
+struct same_type_applicable<op, Out, In, Rest...>:
+	std::integral_constant<bool, same_type_applicable<op, Out, Rest...>::value &&
+			is_simd_array<In>::value && std::is_same<element_t<Out>, element_t<In>>::value>
+{
+};
+
+//! \brief Условие применимости ядра для Apply_AA_1D_F2
+template <int op, class Out, class In>
+struct unary_applicable: same_type_applicable<op, Out, In>
+{
+};
+
+template <class Out, class In>
+struct unary_applicable<e_absolute_value, Out, In>:
+	std::integral_constant<bool, is_simd_output_array<Out>::value && is_simd_array<In>::value>
+{
+};
+
+} // namespace BAI_SIMD_aux
+
+//--------------------------------------------------------------
+
+//! \brief Векторизованное выполнение Apply_AA_1D_F2(array_1, array_2, functor): array_1 op= array_2
+template <class Array1, class Array2, class Functor>
+bool AA_F2(Array1 &array_1, Array2 &array_2, const Functor &)
+{
+	constexpr int op = compound_operation<Functor>::value;
+	return BAI_SIMD_aux::unary_kernel(array_1, array_2, std::integral_constant<int, op>(),
+			BAI_SIMD_aux::unary_applicable<op, Array1, Array2>());
+}
+
+//! \brief Векторизованное выполнение Apply_AS_1D_F2(array, scalar, functor): array op= scalar
+template <class Array, class Scalar, class Functor>
+bool AS_F2(Array &array, const Scalar &scalar, const Functor &)
+{
+	constexpr int op = compound_operation<Functor>::value;
+	return BAI_SIMD_aux::scalar_kernel(array, array, scalar, std::integral_constant<int, op>(),
+			BAI_SIMD_aux::same_type_applicable<op, Array>());
+}
+
+//! \brief Векторизованное выполнение Apply_AAA_1D_F3(array_1, array_2, array_3, functor): array_1 = array_2 op array_3
+template <class Array1, class Array2, class Array3, class Functor>
+bool AAA_F3(Array1 &array_1, Array2 &array_2, Array3 &array_3, const Functor &)
+{
+	constexpr int op = assign_operation<Functor>::value;
+	return BAI_SIMD_aux::binary_kernel(array_1, array_2, array_3, std::integral_constant<int, op>(),
+			BAI_SIMD_aux::same_type_applicable<op, Array1, Array2, Array3>());
+}
+
+//! \brief Векторизованное выполнение Apply_AAS_1D_F3(array_1, array_2, scalar, functor): array_1 = array_2 op scalar
+template <class Array1, class Array2, class Scalar, class Functor>
+bool AAS_F3(Array1 &array_1, Array2 &array_2, const Scalar &scalar, const Functor &)
+{
+	constexpr int op = assign_operation<Functor>::value;
+	return BAI_SIMD_aux::scalar_kernel(array_1, array_2, scalar, std::integral_constant<int, op>(),
+			BAI_SIMD_aux::same_type_applicable<op, Array1, Array2>());
+}
+
+//--------------------------------------------------------------
+
+} // namespace ArrayInteractionsSIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_BasicArrayInteractionsSIMD_h
@@ -0,0 +1,161 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file BrickedDataArray3D.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_BrickedDataArray3D_h
+#define XRAD__File_BrickedDataArray3D_h
+/*!
+	\file
+	\brief Трехмерный массив с блочным (bricked) размещением данных
+
+	DataArrayMD хранит данные построчно: соседние по последнему индексу элементы соседствуют в памяти,
+	а соседние по первому индексу отстоят на целый срез. Выделение сагиттальных и корональных
+	срезов и фильтрация вдоль первого индекса (оси z) обращаются к памяти с шагом в срез,
+	и почти каждое обращение -- промах кэша и TLB.
+
+	BrickedDataArray3D хранит объем кубическими блоками brick_size^3 (по умолчанию 8x8x8).
+	Блоки идут построчно, внутри блока элементы также построчны. Любой ортогональный срез
+	и любая линия читаются блоками по несколько килобайт, поэтому скорость выделения
+	срезов и обработки линий почти не зависит от направления.
+
+	Блочное размещение нельзя описать шагами, поэтому срезы и линии не ссылаются на данные
+	массива (как DataArrayMD::GetSlice()), а копируются:
+
+	~~~~
+	BrickedDataArray3D<RealFunction2D_F32>	bricked(volume); // volume: DataArrayMD, 3 измерения
+	RealFunction2D_F32	sagittal;
+	bricked.CopySlice(sagittal, {slice_mask(0), slice_mask(1), x});
+	bricked.ProcessLines(0, [](RealFunctionF32 &line){ line.FilterGauss(2, 0.1); }, e_use_omp);
+	bricked.CopyTo(volume);
+	~~~~
+*/
+//--------------------------------------------------------------
+
+#include "DataArrayMD.h"
+#include "ScratchArena.h"
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Трехмерный массив с блочным размещением данных
+
+	\tparam A2DT Тип двумерного среза (как у DataArrayMD), определяет типы срезов и линий.
+	\tparam BRICK_LOG2 Двоичный логарифм размера ребра блока.
+*/
+template<class A2DT, size_t BRICK_LOG2 = 3>
+class BrickedDataArray3D
+{
+	public:
+		typedef BrickedDataArray3D<A2DT, BRICK_LOG2> self;
+		typedef A2DT slice_type;
+		typedef typename A2DT::row_type row_type;
+		typedef typename A2DT::value_type value_type;
+
+		static constexpr size_t brick_log2 = BRICK_LOG2;
+		//! \brief Размер ребра блока
+		static constexpr size_t brick_size = size_t(1) << BRICK_LOG2;
+		//! \brief Число элементов в блоке
+		static constexpr size_t brick_volume = brick_size*brick_size*brick_size;
+
+	public:
+		//! \name Конструкторы
+		//! @{
+		BrickedDataArray3D();
+		explicit BrickedDataArray3D(const index_vector &in_sizes);
+		BrickedDataArray3D(const index_vector &in_sizes, const value_type &default_value);
+		template<class A2DT2>
+		explicit BrickedDataArray3D(const DataArrayMD<A2DT2> &original);
+		//! @}
+
+		void	realloc(const index_vector &in_sizes);
+		void	realloc(const index_vector &in_sizes, const value_type &default_value);
+
+		const index_vector	&sizes() const { return m_sizes; }
+		size_t	sizes(size_t dimension) const { return m_sizes[dimension]; }
+		bool	empty() const { return m_data.empty(); }
+
+		//! \name Доступ к элементам
+		//! @{
+		value_type	&at(size_t i0, size_t i1, size_t i2) { return m_data.data()[ElementOffset(i0, i1, i2)]; }
+		const value_type	&at(size_t i0, size_t i1, size_t i2) const { return m_data.data()[ElementOffset(i0, i1, i2)]; }
+		value_type	&at(const index_vector &iv) { return at(iv[0], iv[1], iv[2]); }
+		const value_type	&at(const index_vector &iv) const { return at(iv[0], iv[1], iv[2]); }
+		//! @}
+
+		//! \name Преобразование в построчное размещение и обратно
+		//! @{
+
+		//! \brief Скопировать трехмерный массив original, изменив размеры при необходимости
+		template<class A2DT2>
+		void	MakeCopy(const DataArrayMD<A2DT2> &original);
+		//! \brief Скопировать трехмерный массив original, размеры должны совпадать
+		template<class A2DT2>
+		void	CopyData(const DataArrayMD<A2DT2> &original);
+		//! \brief Скопировать данные в result, изменив его размеры при необходимости
+		template<class A2DT2>
+		void	CopyTo(DataArrayMD<A2DT2> &result) const;
+		//! @}
+
+		//! \name Срезы и линии
+		//! Задаются так же, как в DataArrayMD::GetSlice() и DataArrayMD::GetRow(),
+		//! но данные копируются. Размер приемника при необходимости изменяется.
+		//! @{
+		template<class RT2>
+		void	CopySlice(DataArray2D<RT2> &slice, const index_vector &iv) const;
+		template<class RT2>
+		void	PutSlice(const DataArray2D<RT2> &slice, const index_vector &iv);
+		template<class T2>
+		void	CopyRow(DataArray<T2> &row, const index_vector &iv) const;
+		template<class T2>
+		void	PutRow(const DataArray<T2> &row, const index_vector &iv);
+		//! @}
+
+		/*!
+			\brief Вызвать f(row_type &line) для каждой линии вдоль измерения dimension
+			и записать измененные линии обратно
+
+			Линии обрабатываются пачками по brick_size^2 (все линии одного столбца блоков),
+			поэтому каждый блок читается и записывается один раз. При omp == e_use_omp столбцы
+			блоков распределяются между потоками, и f должен допускать одновременный вызов.
+		*/
+		template<class F>
+		void	ProcessLines(size_t dimension, const F &f, omp_usage_t omp = e_dont_use_omp);
+
+	private:
+		static constexpr size_t brick_mask = brick_size - 1;
+
+		size_t	ElementOffset(size_t i0, size_t i1, size_t i2) const;
+		//! \brief Шаг (в элементах) внутри блока по измерению dimension
+		static size_t	brick_step(size_t dimension) { return size_t(1) << (brick_log2*(2 - dimension)); }
+		//! \brief Указатель на блок с номерами (b0, b1, b2)
+		value_type	*brick_data(size_t b0, size_t b1, size_t b2) const;
+		void	GetSliceDimensions(size_t &fixed_dimension, size_t &slice_dimension_0, size_t &slice_dimension_1,
+				const index_vector &iv) const;
+		size_t	GetRowDimension(const index_vector &iv) const;
+		static omp_usage_t	AutoOMP(size_t n_elements);
+
+		template<class F>
+		void	ForEachSliceRun(const index_vector &iv, size_t vsize, size_t hsize, const F &f) const;
+		template<class F>
+		void	ForEachRowRun(const index_vector &iv, const F &f) const;
+
+	private:
+		DataArray<value_type>	m_data;
+		index_vector	m_sizes;
+		//! \brief Число блоков по каждому измерению
+		size_t	m_n_bricks[3];
+};
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+#include "BrickedDataArray3D.hh"
+
+//--------------------------------------------------------------
+#endif // XRAD__File_BrickedDataArray3D_h
@@ -0,0 +1,483 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file BrickedDataArray3D.hh
+//--------------------------------------------------------------
+#ifndef XRAD__File_BrickedDataArray3D_hh
+#define XRAD__File_BrickedDataArray3D_hh
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+//
+//	конструкторы, размеры
+//
+//--------------------------------------------------------------
+
+template<class A2DT, size_t BRICK_LOG2>
+BrickedDataArray3D<A2DT, BRICK_LOG2>::BrickedDataArray3D():
+	m_sizes(3, 0)
+{
+	std::fill(m_n_bricks, m_n_bricks + 3, 0);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+BrickedDataArray3D<A2DT, BRICK_LOG2>::BrickedDataArray3D(const index_vector &in_sizes)
+{
+	realloc(in_sizes);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+BrickedDataArray3D<A2DT, BRICK_LOG2>::BrickedDataArray3D(const index_vector &in_sizes, const value_type &default_value)
+{
+	realloc(in_sizes, default_value);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class A2DT2>
+BrickedDataArray3D<A2DT, BRICK_LOG2>::BrickedDataArray3D(const DataArrayMD<A2DT2> &original)
+{
+	MakeCopy(original);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::realloc(const index_vector &in_sizes)
+{
+	if(in_sizes.size() != 3)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("BrickedDataArray3D::realloc: invalid number of dimensions = %zu.",
+				EnsureType<size_t>(in_sizes.size())));
+	}
+	size_t	n_bricks = 1;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		m_n_bricks[i] = (in_sizes[i] + brick_mask) >> brick_log2;
+		n_bricks *= m_n_bricks[i];
+	}
+	m_sizes.MakeCopy(in_sizes);
+	m_data.realloc(n_bricks*brick_volume);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::realloc(const index_vector &in_sizes, const value_type &default_value)
+{
+	realloc(in_sizes);
+	m_data.fill(default_value);
+}
+
+//--------------------------------------------------------------
+//
+//	адресация
+//
+//--------------------------------------------------------------
+
+template<class A2DT, size_t BRICK_LOG2>
+inline size_t	BrickedDataArray3D<A2DT, BRICK_LOG2>::ElementOffset(size_t i0, size_t i1, size_t i2) const
+{
+#if XRAD_CHECK_ARRAY_BOUNDARIES
+	if(i0 >= m_sizes[0] || i1 >= m_sizes[1] || i2 >= m_sizes[2])
+	{
+		ForceDebugBreak();
+		throw out_of_range(ssprintf("BrickedDataArray3D::at(%zu, %zu, %zu): index out of range (%zu, %zu, %zu).",
+				EnsureType<size_t>(i0), EnsureType<size_t>(i1), EnsureType<size_t>(i2),
+				EnsureType<size_t>(m_sizes[0]), EnsureType<size_t>(m_sizes[1]), EnsureType<size_t>(m_sizes[2])));
+	}
+#endif
+	size_t	brick = ((i0 >> brick_log2)*m_n_bricks[1] + (i1 >> brick_log2))*m_n_bricks[2] + (i2 >> brick_log2);
+	return (brick << (3*brick_log2)) |
+			((i0 & brick_mask) << (2*brick_log2)) | ((i1 & brick_mask) << brick_log2) | (i2 & brick_mask);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+inline auto	BrickedDataArray3D<A2DT, BRICK_LOG2>::brick_data(size_t b0, size_t b1, size_t b2) const -> value_type *
+{
+	return const_cast<value_type*>(m_data.data()) + ((b0*m_n_bricks[1] + b1)*m_n_bricks[2] + b2)*brick_volume;
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+omp_usage_t	BrickedDataArray3D<A2DT, BRICK_LOG2>::AutoOMP(size_t n_elements)
+{
+	return n_elements >= parallel_interactions_min_size ? e_use_omp: e_dont_use_omp;
+}
+
+//--------------------------------------------------------------
+//
+//	преобразование в построчное размещение и обратно
+//
+//--------------------------------------------------------------
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class A2DT2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::MakeCopy(const DataArrayMD<A2DT2> &original)
+{
+	if(m_sizes != original.sizes())
+		realloc(original.sizes());
+	CopyData(original);
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class A2DT2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::CopyData(const DataArrayMD<A2DT2> &original)
+{
+	if(original.sizes() != m_sizes)
+	{
+		ForceDebugBreak();
+		throw invalid_argument("BrickedDataArray3D::CopyData: array sizes differ.");
+	}
+	if(empty())
+		return;
+	const auto	*base = &original.at(index_vector{0, 0, 0});
+	const ptrdiff_t	s0 = original.steps_raw(0), s1 = original.steps_raw(1), s2 = original.steps_raw(2);
+
+	// Каждый слой блоков заполняется независимо
+	BAI_OMP_aux::for_each_index(m_n_bricks[0], AutoOMP(m_data.size()), "BrickedDataArray3D::CopyData",
+			[&](size_t b0)
+	{
+		const size_t	i0_end = min(m_sizes[0], (b0 + 1) << brick_log2);
+		for(size_t i0 = b0 << brick_log2; i0 < i0_end; ++i0)
+		{
+			for(size_t i1 = 0; i1 < m_sizes[1]; ++i1)
+			{
+				const auto	*src = base + ptrdiff_t(i0)*s0 + ptrdiff_t(i1)*s1;
+				for(size_t b2 = 0; b2 < m_n_bricks[2]; ++b2)
+				{
+					value_type	*dst = brick_data(b0, i1 >> brick_log2, b2) +
+							((i0 & brick_mask) << (2*brick_log2)) + ((i1 & brick_mask) << brick_log2);
+					const size_t	count = min(brick_size, m_sizes[2] - (b2 << brick_log2));
+					if(s2 == 1)
+					{
+						std::copy(src, src + count, dst);
+						src += count;
+					}
+					else
+					{
+						for(size_t k = 0; k < count; ++k, src += s2)
+							dst[k] = *src;
+					}
+				}
+			}
+		}
+	});
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class A2DT2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::CopyTo(DataArrayMD<A2DT2> &result) const
+{
+	if(result.sizes() != m_sizes)
+		result.realloc(m_sizes);
+	if(empty())
+		return;
+	auto	*base = &result.at(index_vector{0, 0, 0});
+	const ptrdiff_t	s0 = result.steps_raw(0), s1 = result.steps_raw(1), s2 = result.steps_raw(2);
+
+	BAI_OMP_aux::for_each_index(m_n_bricks[0], AutoOMP(m_data.size()), "BrickedDataArray3D::CopyTo",
+			[&](size_t b0)
+	{
+		const size_t	i0_end = min(m_sizes[0], (b0 + 1) << brick_log2);
+		for(size_t i0 = b0 << brick_log2; i0 < i0_end; ++i0)
+		{
+			for(size_t i1 = 0; i1 < m_sizes[1]; ++i1)
+			{
+				auto	*dst = base + ptrdiff_t(i0)*s0 + ptrdiff_t(i1)*s1;
+				for(size_t b2 = 0; b2 < m_n_bricks[2]; ++b2)
+				{
+					const value_type	*src = brick_data(b0, i1 >> brick_log2, b2) +
+							((i0 & brick_mask) << (2*brick_log2)) + ((i1 & brick_mask) << brick_log2);
+					const size_t	count = min(brick_size, m_sizes[2] - (b2 << brick_log2));
+					if(s2 == 1)
+					{
+						std::copy(src, src + count, dst);
+						dst += count;
+					}
+					else
+					{
+						for(size_t k = 0; k < count; ++k, dst += s2)
+							*dst = src[k];
+					}
+				}
+			}
+		}
+	});
+}
+
+//--------------------------------------------------------------
+//
+//	срезы и линии
+//
+//--------------------------------------------------------------
+
+template<class A2DT, size_t BRICK_LOG2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::GetSliceDimensions(size_t &fixed_dimension,
+		size_t &slice_dimension_0, size_t &slice_dimension_1, const index_vector &iv) const
+{
+	size_t	n_masks = 0, n_fixed = 0;
+	fixed_dimension = slice_dimension_0 = slice_dimension_1 = 3;
+	if(iv.size() == 3)
+	{
+		for(size_t i = 0; i < 3; ++i)
+		{
+			if(!is_slice_mask(iv[i]))
+			{
+				if(iv[i] < m_sizes[i])
+					fixed_dimension = i;
+				++n_fixed;
+			}
+			else if(dimension_no(iv[i]) == 0)
+			{
+				slice_dimension_0 = i;
+				++n_masks;
+			}
+			else if(dimension_no(iv[i]) == 1)
+			{
+				slice_dimension_1 = i;
+				++n_masks;
+			}
+		}
+	}
+	if(n_fixed != 1 || n_masks != 2 || fixed_dimension == 3 || slice_dimension_0 == 3 || slice_dimension_1 == 3)
+	{
+		ForceDebugBreak();
+		throw invalid_argument("BrickedDataArray3D: invalid slice specification.");
+	}
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+size_t	BrickedDataArray3D<A2DT, BRICK_LOG2>::GetRowDimension(const index_vector &iv) const
+{
+	size_t	row_dimension = 3, n_fixed = 0;
+	if(iv.size() == 3)
+	{
+		for(size_t i = 0; i < 3; ++i)
+		{
+			if(is_slice_mask(iv[i]))
+			{
+				if(dimension_no(iv[i]) == 0)
+					row_dimension = i;
+			}
+			else if(iv[i] < m_sizes[i])
+			{
+				++n_fixed;
+			}
+		}
+	}
+	if(n_fixed != 2 || row_dimension == 3)
+	{
+		ForceDebugBreak();
+		throw invalid_argument("BrickedDataArray3D: invalid row specification.");
+	}
+	return row_dimension;
+}
+
+/*!
+	\brief Перебор участков среза, лежащих в одном блоке
+
+	Для каждой строки v среза и каждого блока вызывается f(v, h, src, src_step, count):
+	элементы среза (v, h), ..., (v, h+count-1) находятся по адресам src, src+src_step, ...
+*/
+template<class A2DT, size_t BRICK_LOG2>
+template<class F>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::ForEachSliceRun(const index_vector &iv,
+		size_t vsize, size_t hsize, const F &f) const
+{
+	size_t	fd, d0, d1;
+	GetSliceDimensions(fd, d0, d1, iv);
+	if(vsize != m_sizes[d0] || hsize != m_sizes[d1])
+	{
+		ForceDebugBreak();
+		throw invalid_argument("BrickedDataArray3D: slice sizes do not match the array.");
+	}
+	const size_t	fixed_index = iv[fd];
+	size_t	b[3];
+	b[fd] = fixed_index >> brick_log2;
+	const size_t	fixed_offset = (fixed_index & brick_mask)*brick_step(fd);
+	const ptrdiff_t	step0 = brick_step(d0), step1 = brick_step(d1);
+
+	for(b[d0] = 0; b[d0] < m_n_bricks[d0]; ++b[d0])
+	{
+		const size_t	v0 = b[d0] << brick_log2;
+		const size_t	nv = min(brick_size, vsize - v0);
+		for(b[d1] = 0; b[d1] < m_n_bricks[d1]; ++b[d1])
+		{
+			const size_t	h0 = b[d1] << brick_log2;
+			const size_t	nh = min(brick_size, hsize - h0);
+			value_type	*brick = brick_data(b[0], b[1], b[2]) + fixed_offset;
+			for(size_t v = 0; v < nv; ++v)
+				f(v0 + v, h0, brick + v*step0, step1, nh);
+		}
+	}
+}
+
+/*!
+	\brief Перебор участков линии, лежащих в одном блоке: f(i, src, src_step, count)
+*/
+template<class A2DT, size_t BRICK_LOG2>
+template<class F>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::ForEachRowRun(const index_vector &iv, const F &f) const
+{
+	const size_t	d = GetRowDimension(iv);
+	size_t	b[3];
+	size_t	offset = 0;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		if(i != d)
+		{
+			b[i] = iv[i] >> brick_log2;
+			offset += (iv[i] & brick_mask)*brick_step(i);
+		}
+	}
+	for(b[d] = 0; b[d] < m_n_bricks[d]; ++b[d])
+	{
+		const size_t	i0 = b[d] << brick_log2;
+		f(i0, brick_data(b[0], b[1], b[2]) + offset, ptrdiff_t(brick_step(d)), min(brick_size, m_sizes[d] - i0));
+	}
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class RT2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::CopySlice(DataArray2D<RT2> &slice, const index_vector &iv) const
+{
+	size_t	fd, d0, d1;
+	GetSliceDimensions(fd, d0, d1, iv);
+	if(slice.vsize() != m_sizes[d0] || slice.hsize() != m_sizes[d1])
+		slice.realloc(m_sizes[d0], m_sizes[d1]);
+	const ptrdiff_t	hstep = slice.hstep_raw();
+	ForEachSliceRun(iv, slice.vsize(), slice.hsize(),
+			[&slice, hstep](size_t v, size_t h, const value_type *src, ptrdiff_t src_step, size_t count)
+	{
+		auto	*dst = &slice.at(v, h);
+		for(size_t k = 0; k < count; ++k, dst += hstep, src += src_step)
+			*dst = *src;
+	});
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class RT2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::PutSlice(const DataArray2D<RT2> &slice, const index_vector &iv)
+{
+	const ptrdiff_t	hstep = slice.hstep_raw();
+	ForEachSliceRun(iv, slice.vsize(), slice.hsize(),
+			[&slice, hstep](size_t v, size_t h, value_type *dst, ptrdiff_t dst_step, size_t count)
+	{
+		const auto	*src = &slice.at(v, h);
+		for(size_t k = 0; k < count; ++k, src += hstep, dst += dst_step)
+			*dst = *src;
+	});
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class T2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::CopyRow(DataArray<T2> &row, const index_vector &iv) const
+{
+	const size_t	d = GetRowDimension(iv);
+	if(row.size() != m_sizes[d])
+		row.realloc(m_sizes[d]);
+	ForEachRowRun(iv, [&row](size_t i, const value_type *src, ptrdiff_t src_step, size_t count)
+	{
+		auto	it = row.begin() + i;
+		for(size_t k = 0; k < count; ++k, ++it, src += src_step)
+			*it = *src;
+	});
+}
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class T2>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::PutRow(const DataArray<T2> &row, const index_vector &iv)
+{
+	if(row.size() != m_sizes[GetRowDimension(iv)])
+	{
+		ForceDebugBreak();
+		throw invalid_argument("BrickedDataArray3D::PutRow: row size does not match the array.");
+	}
+	ForEachRowRun(iv, [&row](size_t i, value_type *dst, ptrdiff_t dst_step, size_t count)
+	{
+		auto	it = row.begin() + i;
+		for(size_t k = 0; k < count; ++k, ++it, dst += dst_step)
+			*dst = *it;
+	});
+}
+
+//--------------------------------------------------------------
+
+template<class A2DT, size_t BRICK_LOG2>
+template<class F>
+void	BrickedDataArray3D<A2DT, BRICK_LOG2>::ProcessLines(size_t dimension, const F &f, omp_usage_t omp)
+{
+	if(dimension > 2)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("BrickedDataArray3D::ProcessLines: invalid dimension = %zu.",
+				EnsureType<size_t>(dimension)));
+	}
+	if(empty())
+		return;
+	const size_t	d = dimension, da = d == 0 ? 1: 0, db = d == 2 ? 1: 2;
+	const ptrdiff_t	step_d = brick_step(d), step_a = brick_step(da), step_b = brick_step(db);
+	const size_t	line_size = m_sizes[d];
+
+	BAI_OMP_aux::for_each_index(m_n_bricks[da]*m_n_bricks[db], omp, "BrickedDataArray3D::ProcessLines",
+			[&](size_t column)
+	{
+		size_t	b[3];
+		b[da] = column/m_n_bricks[db];
+		b[db] = column%m_n_bricks[db];
+		const size_t	na = min(brick_size, m_sizes[da] - (b[da] << brick_log2));
+		const size_t	nb = min(brick_size, m_sizes[db] - (b[db] << brick_log2));
+
+		// Линии столбца блоков: строки двумерного буфера. Из арены потока берется только
+		// сам буфер: f может размещать долговременные данные (таблицы, буферы потока)
+		slice_type	lines;
+		{
+			ScratchArenaScope	scratch;
+			lines.realloc(na*nb, line_size);
+		}
+		const ptrdiff_t	hstep = lines.hstep_raw();
+
+		for(b[d] = 0; b[d] < m_n_bricks[d]; ++b[d])
+		{
+			const value_type	*brick = brick_data(b[0], b[1], b[2]);
+			const size_t	i0 = b[d] << brick_log2;
+			const size_t	count = min(brick_size, line_size - i0);
+			for(size_t la = 0; la < na; ++la)
+			{
+				for(size_t lb = 0; lb < nb; ++lb)
+				{
+					const value_type	*src = brick + la*step_a + lb*step_b;
+					value_type	*dst = &lines.at(la*nb + lb, i0);
+					for(size_t k = 0; k < count; ++k, src += step_d, dst += hstep)
+						*dst = *src;
+				}
+			}
+		}
+
+		for(size_t i = 0; i < lines.vsize(); ++i)
+			f(lines.row(i));
+
+		for(b[d] = 0; b[d] < m_n_bricks[d]; ++b[d])
+		{
+			value_type	*brick = brick_data(b[0], b[1], b[2]);
+			const size_t	i0 = b[d] << brick_log2;
+			const size_t	count = min(brick_size, line_size - i0);
+			for(size_t la = 0; la < na; ++la)
+			{
+				for(size_t lb = 0; lb < nb; ++lb)
+				{
+					value_type	*dst = brick + la*step_a + lb*step_b;
+					const value_type	*src = &lines.at(la*nb + lb, i0);
+					for(size_t k = 0; k < count; ++k, src += hstep, dst += step_d)
+						*dst = *src;
+				}
+			}
+		}
+	});
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_BrickedDataArray3D_hh
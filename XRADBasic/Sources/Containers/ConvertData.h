@@ -0,0 +1,81 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ConvertData.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_ConvertData_h
+#define XRAD__File_ConvertData_h
+/*!
+	\file
+	\brief Копирование непрерывных буферов с преобразованием целых чисел в float, double
+
+	Исходные данные изображений (пиксели DICOM, срезы томограмм) обычно хранятся как
+	int8, uint8, int16, uint16, int32, uint32 и при загрузке копируются в массивы float или double.
+	ConvertData() выполняет такое копирование векторизованными ядрами (см. ConvertSIMD.h),
+	при необходимости с линейным преобразованием y = x*scale + offset в том же проходе,
+	большие буферы обрабатываются в нескольких потоках.
+
+	CopyData() массивов DataArray, DataArray2D, DataArrayMD используют ConvertData() сами,
+	если источник и приемник (или их строки) непрерывны и пара типов поддерживается.
+	Линейное преобразование передается в CopyData() функтором linear_conversion:
+
+	~~~~
+	RealFunction2D_F32	image(rows, columns);
+	image.CopyData(pixels_int16, 1, linear_conversion(rescale_slope, rescale_intercept));
+	~~~~
+*/
+//--------------------------------------------------------------
+
+#include "ConvertSIMD.h"
+#include "BasicArrayInteractionsOMP.h"
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Функтор y = x*scale + offset для CopyData()
+
+	Вычисления выполняются в double, результат приводится к типу приемника. Векторизованные
+	ядра (см. ConvertSIMD::convert_function) вычисляют то же самое, поэтому результат
+	не зависит от того, непрерывны ли данные источника и приемника.
+*/
+struct linear_conversion
+{
+	double	scale;
+	double	offset;
+
+	linear_conversion(double in_scale = 1, double in_offset = 0): scale(in_scale), offset(in_offset) {}
+
+	//! \brief Форма для CopyData() из указателя
+	template<class T2>
+	auto	operator()(const T2 &x) const { return x*scale + offset; }
+
+	//! \brief Форма для CopyData() из массива
+	template<class T, class T2>
+	void	operator()(T &y, const T2 &x) const { y = x*scale + offset; }
+};
+
+/*!
+	\brief destination[i] = f(source[i]), i < n
+
+	Для пар типов ConvertSIMD::is_convertible_pair используются векторизованные ядра,
+	для остальных -- скалярный цикл. Области не должны перекрываться.
+*/
+template<class T, class T2>
+void	ConvertData(T *destination, const T2 *source, size_t n, const linear_conversion &f, omp_usage_t omp);
+
+//! \brief То же; несколько потоков используются для n >= parallel_interactions_min_size
+template<class T, class T2>
+void	ConvertData(T *destination, const T2 *source, size_t n, const linear_conversion &f = linear_conversion());
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+#include "ConvertData.hh"
+
+//--------------------------------------------------------------
+#endif // XRAD__File_ConvertData_h
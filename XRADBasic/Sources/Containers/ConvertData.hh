@@ -0,0 +1,123 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ConvertData.hh
+//--------------------------------------------------------------
+#ifndef XRAD__File_ConvertData_hh
+#define XRAD__File_ConvertData_hh
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace ConvertDataAux
+{
+
+//! \brief Число элементов, которое получает один поток за раз
+constexpr size_t	parallel_block_size = 1 << 16;
+
+template<class T, class T2>
+void	convert_block(T *destination, const T2 *source, size_t n, const linear_conversion &f)
+{
+	if constexpr (ConvertSIMD::is_convertible_pair<T, T2>::value)
+	{
+		if(const ConvertSIMD::Kernels *kernels = ConvertSIMD::ActiveKernels())
+		{
+			kernels->convert<T, T2>()(source, destination, n, f.scale, f.offset);
+			return;
+		}
+	}
+	for(size_t i = 0; i < n; ++i)
+		f(destination[i], source[i]);
+}
+
+/*!
+	\brief Копирование непрерывного буфера для CopyData()
+
+	\return false, если для пары типов или функтора F векторизованного ядра нет:
+	тогда копирование выполняет обычный код CopyData()
+*/
+template<class T, class T2, class F>
+bool	copy_contiguous(T *destination, const T2 *source, size_t n, const F &f)
+{
+	if constexpr (ConvertSIMD::is_convertible_pair<T, T2>::value && std::is_same<F, linear_conversion>::value)
+	{
+		ConvertData(destination, source, n, f);
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+/*!
+	\brief Копирование vsize строк по hsize элементов с шагом 1 внутри строки.
+	Шаги между строками в элементах. Возвращаемое значение -- как у copy_contiguous()
+*/
+template<class T, class T2, class F>
+bool	copy_rows(T *destination, ptrdiff_t destination_vstep, const T2 *source, ptrdiff_t source_vstep,
+		size_t vsize, size_t hsize, const F &f)
+{
+	if constexpr (ConvertSIMD::is_convertible_pair<T, T2>::value && std::is_same<F, linear_conversion>::value)
+	{
+		if(destination_vstep == ptrdiff_t(hsize) && source_vstep == ptrdiff_t(hsize))
+			return copy_contiguous(destination, source, vsize*hsize, f);
+		omp_usage_t	omp = vsize > 1 && vsize*hsize >= parallel_interactions_min_size? e_use_omp: e_dont_use_omp;
+		BAI_OMP_aux::for_each_index(vsize, omp, "ConvertData", [&](size_t i)
+		{
+			convert_block(destination + ptrdiff_t(i)*destination_vstep, source + ptrdiff_t(i)*source_vstep,
+					hsize, f);
+		});
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+//! \brief Данные многомерного массива занимают непрерывный участок памяти в построчном порядке
+template<class MDA>
+bool	is_dense(const MDA &array)
+{
+	ptrdiff_t	step = 1;
+	for(size_t d = array.n_dimensions(); d-- > 0;)
+	{
+		if(array.steps_raw(d) != step)
+			return false;
+		step *= ptrdiff_t(array.sizes(d));
+	}
+	return true;
+}
+
+} // namespace ConvertDataAux
+
+//--------------------------------------------------------------
+
+template<class T, class T2>
+void	ConvertData(T *destination, const T2 *source, size_t n, const linear_conversion &f, omp_usage_t omp)
+{
+	using namespace ConvertDataAux;
+	const size_t	n_blocks = (n + parallel_block_size - 1)/parallel_block_size;
+	BAI_OMP_aux::for_each_index(n_blocks, omp, "ConvertData", [&](size_t i)
+	{
+		const size_t	begin = i*parallel_block_size;
+		convert_block(destination + begin, source + begin, min(parallel_block_size, n - begin), f);
+	});
+}
+
+template<class T, class T2>
+void	ConvertData(T *destination, const T2 *source, size_t n, const linear_conversion &f)
+{
+	ConvertData(destination, source, n, f, n >= parallel_interactions_min_size? e_use_omp: e_dont_use_omp);
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_ConvertData_hh
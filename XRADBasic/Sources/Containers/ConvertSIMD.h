@@ -0,0 +1,116 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ConvertSIMD.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_ConvertSIMD_h
+#define XRAD__File_ConvertSIMD_h
+/*!
+	\file
+	\brief Векторизованное преобразование целых чисел в числа с плавающей точкой
+
+	Внутренний файл библиотеки. Используется в ConvertData.hh для непрерывных буферов:
+	int8, uint8, int16, uint16, int32, uint32 -> float, double с необязательным
+	линейным преобразованием y = x*scale + offset.
+
+	Реализация находится в отдельной единице трансляции ConvertSIMD_AVX2.cpp,
+	которая компилируется с ключами AVX2. Выбор выполняется во время выполнения
+	по ActiveSIMDInstructionSet().
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Sources/Core/CPUFeatures.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+XRAD_BEGIN
+
+namespace ConvertSIMD
+{
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Преобразование n элементов: destination[i] = T(double(source[i])*scale + offset)
+
+	T -- тип приемника (float или double). Вычисления выполняются в double без FMA
+	и округляются до T один раз, поэтому результат совпадает с linear_conversion::operator()
+	(см. ConvertData.h), а при scale == 1, offset == 0 -- со static_cast<T>.
+	Области источника и приемника не должны перекрываться.
+*/
+typedef void (*convert_function)(const void *source, void *destination, size_t n, double scale, double offset);
+
+//! \brief Число поддерживаемых типов источника
+constexpr size_t	n_source_types = 6;
+
+//! \brief Номер типа источника в массивах Kernels::to_float, Kernels::to_double
+//! или n_source_types, если тип не поддерживается
+template<class T2>
+constexpr size_t	source_type_index()
+{
+	return std::is_same<T2, int8_t>::value? 0:
+			std::is_same<T2, uint8_t>::value? 1:
+			std::is_same<T2, int16_t>::value? 2:
+			std::is_same<T2, uint16_t>::value? 3:
+			std::is_same<T2, int32_t>::value? 4:
+			std::is_same<T2, uint32_t>::value? 5:
+			n_source_types;
+}
+
+//! \brief Признак пары типов (приемник T, источник T2), для которой есть ядра
+template<class T, class T2>
+struct is_convertible_pair: std::integral_constant<bool,
+		(std::is_same<T, float>::value || std::is_same<T, double>::value) &&
+		source_type_index<std::remove_const_t<T2>>() < n_source_types> {};
+
+//! \brief Набор ядер для одного набора инструкций
+struct Kernels
+{
+	//! \brief Набор инструкций, для которого скомпилированы ядра
+	simd_instruction_set_t	instruction_set;
+
+	//! \name Ядра для типов источника в порядке source_type_index()
+	//! @{
+	convert_function	to_float[n_source_types];
+	convert_function	to_double[n_source_types];
+	//! @}
+
+	//! \brief Ядро для пары типов, удовлетворяющей is_convertible_pair
+	template<class T, class T2>
+	convert_function	convert() const
+	{
+		static_assert(is_convertible_pair<T, T2>::value, "Unsupported conversion.");
+		constexpr size_t	index = source_type_index<std::remove_const_t<T2>>();
+		return std::is_same<T, float>::value? to_float[index]: to_double[index];
+	}
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Ядра для текущего набора инструкций ActiveSIMDInstructionSet()
+
+	\return nullptr, если векторизованные ядра недоступны (используется скалярный код)
+*/
+const Kernels *ActiveKernels();
+
+//--------------------------------------------------------------
+
+#ifdef XRAD_CPU_X86
+
+//! \brief Реализация AVX2. Вызывать только при DetectedSIMDInstructionSet() >= e_simd_avx2
+const Kernels &Kernels_AVX2();
+
+#endif // XRAD_CPU_X86
+
+//--------------------------------------------------------------
+
+} // namespace ConvertSIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_ConvertSIMD_h
@@ -0,0 +1,165 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ConvertSIMD_AVX2.cpp
+//--------------------------------------------------------------
+// Файл компилируется с ключами AVX2 без FMA (см. CMakeLists.txt, XRADBasic.vcxproj)
+// без предкомпилированного заголовка: код из других файлов не должен компилироваться с этими ключами.
+// Функции этого файла вызываются только при DetectedSIMDInstructionSet() >= e_simd_avx2.
+#include "ConvertSIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <immintrin.h>
+
+XRAD_BEGIN
+
+namespace ConvertSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Загрузка 8 элементов источника, расширенных до int32 (uint32 -- побитово)
+template<class T2>
+__m256i	load_8(const T2 *s);
+
+template<>
+__m256i	load_8<int8_t>(const int8_t *s)
+{
+	return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)s));
+}
+
+template<>
+__m256i	load_8<uint8_t>(const uint8_t *s)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)s));
+}
+
+template<>
+__m256i	load_8<int16_t>(const int16_t *s)
+{
+	return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)s));
+}
+
+template<>
+__m256i	load_8<uint16_t>(const uint16_t *s)
+{
+	return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)s));
+}
+
+template<>
+__m256i	load_8<int32_t>(const int32_t *s)
+{
+	return _mm256_loadu_si256((const __m256i*)s);
+}
+
+template<>
+__m256i	load_8<uint32_t>(const uint32_t *s)
+{
+	return _mm256_loadu_si256((const __m256i*)s);
+}
+
+//! \brief Преобразование 4 значений int32 в double (точное)
+template<class T2>
+__m256d	to_double_4(__m128i v)
+{
+	return _mm256_cvtepi32_pd(v);
+}
+
+//! \brief uint32: x - 2^31 помещается в int32, прибавление 2^31 в double точно
+template<>
+__m256d	to_double_4<uint32_t>(__m128i v)
+{
+	__m256d	shifted = _mm256_cvtepi32_pd(_mm_xor_si128(v, _mm_set1_epi32(int(0x80000000u))));
+	return _mm256_add_pd(shifted, _mm256_set1_pd(2147483648.));
+}
+
+//! \brief Линейное преобразование 8 значений в double: результат в lo (0..3), hi (4..7)
+template<class T2>
+void	transform_8(const T2 *s, __m256d vs, __m256d vo, __m256d &lo, __m256d &hi)
+{
+	__m256i	v = load_8(s);
+	lo = _mm256_add_pd(_mm256_mul_pd(to_double_4<T2>(_mm256_castsi256_si128(v)), vs), vo);
+	hi = _mm256_add_pd(_mm256_mul_pd(to_double_4<T2>(_mm256_extracti128_si256(v, 1)), vs), vo);
+}
+
+//! \brief Вычисления в double с одним округлением до float, как в linear_conversion::operator()
+template<class T2>
+void	convert_to_float(const void *source, void *destination, size_t n, double scale, double offset)
+{
+	const T2	*s = static_cast<const T2*>(source);
+	float	*d = static_cast<float*>(destination);
+	size_t	i = 0;
+	if constexpr (!std::is_same<T2, uint32_t>::value)
+	{
+		// Без преобразования: int32 -> float округляется один раз, как и через double
+		if(scale == 1 && offset == 0)
+		{
+			for(; i + 8 <= n; i += 8)
+				_mm256_storeu_ps(d + i, _mm256_cvtepi32_ps(load_8(s + i)));
+		}
+	}
+	const __m256d	vs = _mm256_set1_pd(scale), vo = _mm256_set1_pd(offset);
+	for(; i + 8 <= n; i += 8)
+	{
+		__m256d	lo, hi;
+		transform_8(s + i, vs, vo, lo, hi);
+		_mm256_storeu_ps(d + i, _mm256_set_m128(_mm256_cvtpd_ps(hi), _mm256_cvtpd_ps(lo)));
+	}
+	for(; i < n; ++i)
+		d[i] = float(double(s[i])*scale + offset);
+}
+
+template<class T2>
+void	convert_to_double(const void *source, void *destination, size_t n, double scale, double offset)
+{
+	const T2	*s = static_cast<const T2*>(source);
+	double	*d = static_cast<double*>(destination);
+	const __m256d	vs = _mm256_set1_pd(scale), vo = _mm256_set1_pd(offset);
+	size_t	i = 0;
+	for(; i + 8 <= n; i += 8)
+	{
+		__m256d	lo, hi;
+		transform_8(s + i, vs, vo, lo, hi);
+		_mm256_storeu_pd(d + i, lo);
+		_mm256_storeu_pd(d + i + 4, hi);
+	}
+	for(; i < n; ++i)
+		d[i] = double(s[i])*scale + offset;
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels &Kernels_AVX2()
+{
+	static const Kernels	kernels =
+	{
+		e_simd_avx2,
+		{
+			convert_to_float<int8_t>, convert_to_float<uint8_t>,
+			convert_to_float<int16_t>, convert_to_float<uint16_t>,
+			convert_to_float<int32_t>, convert_to_float<uint32_t>
+		},
+		{
+			convert_to_double<int8_t>, convert_to_double<uint8_t>,
+			convert_to_double<int16_t>, convert_to_double<uint16_t>,
+			convert_to_double<int32_t>, convert_to_double<uint32_t>
+		}
+	};
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace ConvertSIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
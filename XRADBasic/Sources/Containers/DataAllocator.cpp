@@ -0,0 +1,249 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file DataAllocator.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "DataAllocator.h"
+#include <atomic>
+#include <new>
+#include <limits>
+#include <cstdlib>
+#include <omp.h>
+
+#if defined(XRAD_COMPILER_MSC)
+	#include <malloc.h>
+#elif defined(__linux__)
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Размер большой страницы и выравнивание буферов, для которых они используются
+const size_t huge_page_size = 2*1024*1024;
+
+//! \brief Шаг, с которым FirstTouchData() затрагивает память (не больше размера страницы)
+const size_t touch_page_size = 4096;
+
+std::atomic<size_t>	huge_page_threshold(0);
+
+std::atomic<data_placement>	placement(data_placement::parallel_first_touch);
+std::atomic<size_t>	placement_threshold(default_data_placement_threshold);
+
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+
+#define XRAD_USE_MBIND
+
+// Значения из linux/mempolicy.h (заголовок есть не во всех сборочных окружениях)
+const int	mpol_interleave = 3;
+const unsigned long	mpol_f_mems_allowed = 1 << 2;
+
+//! \brief Маска узлов NUMA, доступных процессу
+struct numa_node_mask
+{
+	static const size_t	max_nodes = 1024;
+	static const size_t	bits_per_word = 8*sizeof(unsigned long);
+	unsigned long	words[max_nodes/bits_per_word] = {};
+	size_t	n_nodes = 0;
+
+	numa_node_mask()
+	{
+		if(syscall(SYS_get_mempolicy, nullptr, words, max_nodes, nullptr, mpol_f_mems_allowed))
+			return;
+		for(auto w: words)
+			n_nodes += size_t(__builtin_popcountl(w));
+	}
+};
+
+//! \brief Распределить страницы [p, p + size) по узлам NUMA поочередно.
+//! Страницы должны быть еще не затронуты. При одном узле ничего не делает
+void	interleave_pages(void *p, size_t size)
+{
+	static const numa_node_mask	nodes;
+	if(nodes.n_nodes < 2)
+		return;
+	// Ошибка mbind не мешает использовать память, страницы будут размещены по первому касанию
+	syscall(SYS_mbind, p, size, mpol_interleave, nodes.words, numa_node_mask::max_nodes, 0);
+}
+
+#endif // __linux__
+
+//! \brief Разместить страницы только что выделенного буфера (size не меньше порога) по узлам NUMA
+void	place_pages(void *p, size_t size, data_placement policy)
+{
+	switch(policy)
+	{
+		case data_placement::on_first_use:
+			break;
+		case data_placement::interleave:
+#ifdef XRAD_USE_MBIND
+			interleave_pages(p, size);
+			// После mbind размещение не зависит от того, какой поток затронет страницу
+			break;
+#endif
+			// на других платформах -- как parallel_first_touch
+		case data_placement::parallel_first_touch:
+			FirstTouchData(p, size);
+			break;
+	}
+}
+
+void	*default_allocate(size_t size, size_t alignment, void *)
+{
+	size_t	threshold = placement_threshold.load(std::memory_order_relaxed);
+	data_placement	policy = threshold && size >= threshold?
+			placement.load(std::memory_order_relaxed): data_placement::on_first_use;
+#if defined(XRAD_COMPILER_MSC)
+	void	*p = _aligned_malloc(size, alignment);
+	if(p)
+		place_pages(p, size, policy);
+	return p;
+#else
+	threshold = huge_page_threshold.load(std::memory_order_relaxed);
+	bool	huge = threshold && size >= threshold;
+	if(huge && alignment < huge_page_size)
+		alignment = huge_page_size;
+	// mbind применяется к целым страницам
+	if(policy != data_placement::on_first_use && alignment < touch_page_size)
+		alignment = touch_page_size;
+	void	*p = nullptr;
+	if(posix_memalign(&p, alignment, size))
+		return nullptr;
+	#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if(huge)
+	{
+		// Ошибка (например, ядро без поддержки THP) не мешает использовать память
+		madvise(p, size, MADV_HUGEPAGE);
+	}
+	#endif
+	place_pages(p, size, policy);
+	return p;
+#endif
+}
+
+void	default_deallocate(void *p, size_t, size_t, void *)
+{
+#if defined(XRAD_COMPILER_MSC)
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+const data_allocator	default_allocator = {default_allocate, default_deallocate, nullptr};
+
+std::atomic<const data_allocator*>	current_allocator(&default_allocator);
+
+thread_local const data_allocator	*thread_allocator = nullptr;
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const data_allocator *DefaultDataAllocator()
+{
+	return &default_allocator;
+}
+
+const data_allocator *GetDataAllocator()
+{
+	if(thread_allocator)
+		return thread_allocator;
+	return current_allocator.load(std::memory_order_acquire);
+}
+
+void SetDataAllocator(const data_allocator *allocator)
+{
+	current_allocator.store(allocator? allocator: &default_allocator, std::memory_order_release);
+}
+
+const data_allocator *SetThreadDataAllocator(const data_allocator *allocator)
+{
+	const data_allocator	*previous = thread_allocator;
+	thread_allocator = allocator;
+	return previous;
+}
+
+void SetHugePageThreshold(size_t size)
+{
+	huge_page_threshold.store(size, std::memory_order_relaxed);
+}
+
+size_t HugePageThreshold()
+{
+	return huge_page_threshold.load(std::memory_order_relaxed);
+}
+
+void SetDataPlacement(data_placement in_placement)
+{
+	placement.store(in_placement, std::memory_order_relaxed);
+}
+
+data_placement DataPlacement()
+{
+	return placement.load(std::memory_order_relaxed);
+}
+
+void SetDataPlacementThreshold(size_t size)
+{
+	placement_threshold.store(size, std::memory_order_relaxed);
+}
+
+size_t DataPlacementThreshold()
+{
+	return placement_threshold.load(std::memory_order_relaxed);
+}
+
+void FirstTouchData(void *p, size_t size)
+{
+	if(!size || omp_in_parallel() || omp_get_max_threads() < 2)
+		return;
+	char	*data = static_cast<char*>(p);
+	#pragma omp parallel
+	{
+		// Блочное распределение, как ParallelProcessor::block_bounds()
+		size_t	n_threads = omp_get_num_threads();
+		size_t	thread_no = omp_get_thread_num();
+		// Границы блоков кратны touch_page_size, чтобы каждую страницу затрагивал один поток
+		size_t	n_pages = (size + touch_page_size - 1)/touch_page_size;
+		size_t	block_size = (n_pages + n_threads - 1)/n_threads*touch_page_size;
+		size_t	begin = min(thread_no*block_size, size);
+		size_t	end = min(begin + block_size, size);
+		volatile char	*touch = data;
+		for(size_t i = begin; i < end; i += touch_page_size)
+			touch[i] = 0;
+		// Если p не выровнен на страницу, последняя страница буфера может остаться не затронутой
+		if(begin < end && end == size)
+			touch[size - 1] = 0;
+	}
+}
+
+//--------------------------------------------------------------
+
+void *AllocateData(const data_allocator *allocator, size_t count, size_t element_size, size_t alignment)
+{
+	if(element_size && count > std::numeric_limits<size_t>::max()/element_size)
+		throw std::bad_alloc();
+	void	*p = allocator->allocate(count*element_size, alignment, allocator->context);
+	if(!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void DeallocateData(const data_allocator *allocator, void *p, size_t count, size_t element_size, size_t alignment)
+{
+	allocator->deallocate(p, count*element_size, alignment, allocator->context);
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
@@ -0,0 +1,201 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file DataAllocator.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_DataAllocator_h
+#define XRAD__File_DataAllocator_h
+/*!
+	\file
+	\brief Выделение памяти для данных контейнеров (DataOwner и наследники)
+
+	DataOwner выделяет память не через new[], а через распределитель data_allocator.
+	По умолчанию используется DefaultDataAllocator():
+	- данные выравниваются на default_data_alignment (64 байта: строка кэша, вектор AVX-512);
+	- буферы размером не менее HugePageThreshold() (если порог задан) выравниваются
+		на 2 МБ и отмечаются для прозрачных больших страниц (Linux, madvise(MADV_HUGEPAGE));
+	- страницы буферов размером не менее DataPlacementThreshold() размещаются по узлам NUMA
+		в соответствии с DataPlacement(), см. data_placement.
+
+	Приложение может установить свой распределитель (учет памяти, NUMA-локальное выделение и т.п.)
+	функцией SetDataAllocator(). Каждый буфер освобождается тем распределителем, которым он был
+	выделен, поэтому распределитель можно менять в любой момент, но объект data_allocator
+	должен существовать, пока не освобождены все выделенные им буферы.
+
+	~~~~
+	void *my_allocate(size_t size, size_t alignment, void *context);
+	void my_deallocate(void *p, size_t size, size_t alignment, void *context);
+
+	static const data_allocator my_allocator = {my_allocate, my_deallocate, &my_statistics};
+	SetDataAllocator(&my_allocator);
+	~~~~
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Sources/Core/Config.h>
+#include <XRADBasic/Sources/Core/BasicMacros.h>
+#include <cstddef>
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+//! \brief Выравнивание данных контейнеров по умолчанию, байт
+const size_t default_data_alignment = 64;
+
+//! \brief Выравнивание буфера из элементов типа T
+template <class T>
+constexpr size_t data_alignment()
+{
+	return alignof(T) > default_data_alignment ? alignof(T) : default_data_alignment;
+}
+
+/*!
+	\brief Распределитель памяти для данных контейнеров
+
+	Функции вызываются из разных потоков одновременно.
+*/
+struct data_allocator
+{
+	/*!
+		\brief Выделить size байт (size > 0) с выравниванием alignment (степень 2)
+
+		При нехватке памяти следует выбросить std::bad_alloc или вернуть nullptr.
+	*/
+	void	*(*allocate)(size_t size, size_t alignment, void *context);
+
+	//! \brief Освободить память, выделенную allocate(); size и alignment те же, что при выделении
+	void	(*deallocate)(void *p, size_t size, size_t alignment, void *context);
+
+	//! \brief Произвольные данные приложения, передаются в allocate() и deallocate()
+	void	*context;
+};
+
+//! \brief Распределитель по умолчанию
+const data_allocator *DefaultDataAllocator();
+
+//! \brief Распределитель, используемый для новых буферов в текущем потоке:
+//! заданный SetThreadDataAllocator(), если он есть, иначе заданный SetDataAllocator()
+const data_allocator *GetDataAllocator();
+
+//! \brief Установить распределитель для новых буферов. nullptr восстанавливает DefaultDataAllocator()
+void SetDataAllocator(const data_allocator *allocator);
+
+/*!
+	\brief Установить распределитель для новых буферов, создаваемых в текущем потоке.
+	Имеет приоритет над SetDataAllocator(); nullptr отменяет его
+
+	\return Предыдущее значение. Используется ScratchArenaScope.
+*/
+const data_allocator *SetThreadDataAllocator(const data_allocator *allocator);
+
+/*!
+	\brief На время существования объекта отменяет SetThreadDataAllocator() в текущем потоке
+
+	Используется при выделении долгоживущих буферов (таблицы, буферы потока), чтобы они
+	не попали в ScratchArena, если функция вызвана внутри ScratchArenaScope.
+*/
+class GlobalDataAllocatorScope
+{
+	public:
+		GlobalDataAllocatorScope(): m_previous_allocator(SetThreadDataAllocator(nullptr)) {}
+		~GlobalDataAllocatorScope() { SetThreadDataAllocator(m_previous_allocator); }
+
+		GlobalDataAllocatorScope(const GlobalDataAllocatorScope &) = delete;
+		GlobalDataAllocatorScope &operator=(const GlobalDataAllocatorScope &) = delete;
+
+	private:
+		const data_allocator	*m_previous_allocator;
+};
+
+/*!
+	\brief Минимальный размер буфера (байт), для которого DefaultDataAllocator() использует
+	прозрачные большие страницы. 0 (по умолчанию) отключает их использование
+
+	На платформах без поддержки прозрачных больших страниц значение игнорируется.
+*/
+void SetHugePageThreshold(size_t size);
+
+//! \brief См. SetHugePageThreshold()
+size_t HugePageThreshold();
+
+/*!
+	\brief Размещение страниц больших буферов DefaultDataAllocator() по узлам NUMA
+
+	Операционная система размещает страницу на узле NUMA того потока, который первым к ней обратился.
+	Если большой массив заполняется одним потоком, все его страницы оказываются на одном узле,
+	и последующая многопоточная обработка упирается в пропускную способность одного контроллера памяти.
+*/
+enum class data_placement
+{
+	//! Страницы размещаются при первом обращении к ним, распределитель их не затрагивает
+	on_first_use,
+
+	/*!
+		Страницы затрагиваются сразу после выделения потоками OpenMP (см. FirstTouchData()).
+		Поток t получает t-й непрерывный блок буфера, как при блочном распределении шагов
+		ParallelProcessor и статическом распределении итераций OpenMP, поэтому при последующей
+		многопоточной обработке срезов каждый поток обращается в основном к памяти своего узла
+	*/
+	parallel_first_touch,
+
+	/*!
+		Страницы распределяются по всем доступным процессу узлам NUMA поочередно
+		(Linux, mbind(MPOL_INTERLEAVE)). Подходит для данных, к которым потоки обращаются
+		в непредсказуемом порядке. На других платформах и на машинах с одним узлом
+		действует как parallel_first_touch
+	*/
+	interleave
+};
+
+//! \brief Порог DataPlacementThreshold() по умолчанию, байт
+const size_t default_data_placement_threshold = 64*1024*1024;
+
+/*!
+	\brief Установить способ размещения страниц буферов размером не менее DataPlacementThreshold().
+	По умолчанию data_placement::parallel_first_touch
+*/
+void SetDataPlacement(data_placement placement);
+
+//! \brief См. SetDataPlacement()
+data_placement DataPlacement();
+
+/*!
+	\brief Минимальный размер буфера (байт), к которому применяется DataPlacement().
+	0 отключает особое размещение для всех буферов
+*/
+void SetDataPlacementThreshold(size_t size);
+
+//! \brief См. SetDataPlacementThreshold()
+size_t DataPlacementThreshold();
+
+/*!
+	\brief Затронуть (записать по байту на страницу) size байт, начиная с p, потоками OpenMP
+
+	Буфер делится на omp_get_max_threads() непрерывных блоков, поток t записывает 0 в первый байт
+	каждой страницы t-го блока. Если доступен один поток или вызов сделан внутри параллельной
+	области, функция ничего не делает. Может использоваться распределителями приложения.
+*/
+void FirstTouchData(void *p, size_t size);
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Выделить память для count элементов размером element_size
+
+	Вызывает allocator->allocate(). При переполнении размера или нехватке памяти
+	выбрасывает std::bad_alloc.
+*/
+void *AllocateData(const data_allocator *allocator, size_t count, size_t element_size, size_t alignment);
+
+//! \brief Освободить память, выделенную AllocateData() с теми же параметрами
+void DeallocateData(const data_allocator *allocator, void *p, size_t count, size_t element_size, size_t alignment);
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_DataAllocator_h
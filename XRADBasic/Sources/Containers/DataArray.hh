@@ -8,6 +8,7 @@
 
 
 #include "BasicArrayInteractions1D.h"
+#include "ConvertData.h"
 #include <XRADBasic/Sources/Core/Functors.h>
 
 XRAD_BEGIN
@@ -178,6 +179,11 @@ void	DataArray<T>::CopyData(const DataArray<T2> &original, extrapolation::method
 	// типами массивов
 		return;
 	}
+	if(size() == original.size() && step() == 1 && original.step() == 1 && !empty() &&
+			ConvertDataAux::copy_contiguous(&at(0), &original.at(0), size(), linear_conversion()))
+	{
+		return;
+	}
 	Apply_AA_1D_Different_F2(*this, original, Functors::assign(), ex);
 }
 
@@ -185,6 +191,11 @@ template<class T>
 template<class T2, class F>
 void	DataArray<T>::CopyData(const DataArray<T2> &original, const F& function, extrapolation::method ex)
 {
+	if(size() == original.size() && step() == 1 && original.step() == 1 && !empty() &&
+			ConvertDataAux::copy_contiguous(&at(0), &original.at(0), size(), function))
+	{
+		return;
+	}
 	Apply_AA_1D_Different_F2(*this, original, function, ex);
 }
 
@@ -192,6 +203,12 @@ template<class T>
 template<class T2>
 void	DataArray<T>::CopyData(const T2 *new_data, ptrdiff_t in_step)
 {
+		// непрерывные целые -> float, double: векторизованное преобразование, см. ConvertData.h
+		if(in_step == 1 && step() == 1 && !empty() &&
+				ConvertDataAux::copy_contiguous(&at(0), new_data, size(), linear_conversion()))
+		{
+			return;
+		}
 		step_iterator<const T2, iterator_checker_none<const T2, ptrdiff_t> > data_it(new_data, in_step, size(), 0);
 		// в std::copy предупреждение C4244 (потеря точности) не по делу. поэтому цикл с явным указанием преобразования типов
 		// std::copy(data_it, data_it+size(), begin());
@@ -202,6 +219,11 @@ template<class T>
 template<class T2, class F>
 void	DataArray<T>::CopyData(const T2 *new_data, ptrdiff_t in_step, const F &function)
 {
+	if(in_step == 1 && step() == 1 && !empty() &&
+			ConvertDataAux::copy_contiguous(&at(0), new_data, size(), function))
+	{
+		return;
+	}
 	step_iterator<const T2, iterator_checker_none<const T2, ptrdiff_t> > data_it(new_data, in_step, size(), 0);
 	for(auto it = begin(); it<end(); ++it, ++data_it) *it = function(*data_it);
 }
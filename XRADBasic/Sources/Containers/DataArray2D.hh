@@ -157,7 +157,8 @@ void	DataArray2D<RT>::resize(size_t in_vs, size_t in_hs)
 template<class RT>
 void	DataArray2D<RT>::fill(const value_type &value)
 {
-	Apply_A_2D_F1(*this, [&value](value_type &v) { v = value; });
+	// Functors::assign позволяет заполнять большие массивы в несколько потоков, см. AutoOMPUsage()
+	Apply_AS_2D_F2(*this, value, Functors::assign());
 }
 
 
@@ -205,6 +206,13 @@ void	DataArray2D<RT>::CopyData(const DataArray2D<RT2> &original, extrapolation::
 		return;
 	}
 	if(!vsize() || !hsize()) return;
+	if(vsize() == original.vsize() && hsize() == original.hsize() &&
+			hstep_raw() == 1 && original.hstep_raw() == 1 &&
+			ConvertDataAux::copy_rows(&at(0, 0), vstep_raw(), &original.at(0, 0), original.vstep_raw(),
+					vsize(), hsize(), linear_conversion()))
+	{
+		return;
+	}
 
 	Apply_AA_2D_Different_F2(*this, original, Functors::assign(), ex);
 }
@@ -214,6 +222,13 @@ template<class RT2, class F>
 void	DataArray2D<RT>::CopyData(const DataArray2D<RT2> &original, const F &f, extrapolation::method ex)
 {
 	//TODO в двумерных алгоритмах сделать проверку на "пусто"
+	if(!empty() && vsize() == original.vsize() && hsize() == original.hsize() &&
+			hstep_raw() == 1 && original.hstep_raw() == 1 &&
+			ConvertDataAux::copy_rows(&at(0, 0), vstep_raw(), &original.at(0, 0), original.vstep_raw(),
+					vsize(), hsize(), f))
+	{
+		return;
+	}
 	Apply_AA_2D_Different_F2(*this, original, f, ex);
 }
 
@@ -222,6 +237,12 @@ template<class RT>
 template<class T2>
 void	DataArray2D<RT>::CopyData(const T2 *new_data, ptrdiff_t in_data_step)
 {
+	// непрерывные целые -> float, double: векторизованное преобразование, см. ConvertData.h
+	if(in_data_step == 1 && !empty() && hstep_raw() == 1 &&
+			ConvertDataAux::copy_rows(&at(0, 0), vstep_raw(), new_data, hsize(), vsize(), hsize(), linear_conversion()))
+	{
+		return;
+	}
 	step_iterator<const T2, iterator_checker_none<const T2, ptrdiff_t> > data_it(new_data, in_data_step, size(), 0);
 	for(size_t i = 0; i < vsize(); ++i)
 	{
@@ -240,6 +261,11 @@ template<class RT>
 template<class T2, class F>
 void	DataArray2D<RT>::CopyData(const T2 *new_data, ptrdiff_t in_data_step, const F &function)
 {
+	if(in_data_step == 1 && !empty() && hstep_raw() == 1 &&
+			ConvertDataAux::copy_rows(&at(0, 0), vstep_raw(), new_data, hsize(), vsize(), hsize(), function))
+	{
+		return;
+	}
 	step_iterator<const T2, iterator_checker_none<const T2, ptrdiff_t> > data_it(new_data, in_data_step, size(), 0);
 	for(size_t i = 0; i < vsize(); ++i)
 	{
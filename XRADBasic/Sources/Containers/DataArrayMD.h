@@ -247,8 +247,16 @@ class	DataArrayMD : private DataOwner<typename A2DT::value_type>
 		void	CopyData(const DataArrayMD<A2DT2> &original, const functor &f);
 		//TODO в отличие от двумерных и одномерных здесь CopyData не для разноразмерных массивов. возможно, потом придется это доделать
 
-		// void	CopyData(const value_type *, const index_vector &, int );
-		//TODO сделать функции импорта из указателя такие же, как в одномерном и двумерном массиве
+		/*!
+			\brief Копирует данные, лежащие по адресу указателя с заданным шагом, в выделенную память
+
+			Данные источника идут в построчном порядке (последний индекс меняется быстрее всего),
+			как в DataArray2D::CopyData(const T2 *, ptrdiff_t).
+		*/
+		template<class T2>
+		void	CopyData(const T2 *new_data, ptrdiff_t in_data_step = 1);
+		template<class T2, class F>
+		void	CopyData(const T2 *new_data, ptrdiff_t in_data_step, const F &f);
 
 		void UseData(value_type *new_data, const index_vector& in_sizes, ptrdiff_t in_data_step);
 		//! \todo Сделать поддержку отрицательных шагов внутри DataArrayMD.
@@ -463,6 +471,16 @@ class	DataArrayMD : private DataOwner<typename A2DT::value_type>
 		index_vector	m_sizes;
 		offset_vector	m_steps;
 
+	private:
+		//! \brief Копирование в CopyData() одним вызовом ConvertData() для плотных массивов одного размера.
+		//! false, если такое копирование невозможно
+		template<class A2DT2, class F>
+		bool	CopyDataContiguous(const DataArrayMD<A2DT2> &original, const F &f);
+		//! \brief Вызов copy_slice(slice, slice_data) для срезов из двух последних измерений
+		//! и соответствующих им участков данных источника
+		template<class T2, class CopySlice>
+		void	CopyDataBySlices(const T2 *new_data, ptrdiff_t in_data_step, const CopySlice &copy_slice);
+
 	private:
 		//! \name Вспомогательные функции разбора индексного вектора
 		//! @{
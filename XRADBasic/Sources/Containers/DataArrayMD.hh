@@ -204,7 +204,7 @@ void	DataArrayMD<A2DT>::reorder_dimensions(const index_vector& iv)
 	else for(size_t i = 0; i < n_dimensions(); ++i)
 	{
 		size_t j = 0;
-		while(iv[j] != slice_mask(i) && j < n_dimensions())
+		while(j < n_dimensions() && iv[j] != slice_mask(i))
 			++j;
 		if(j >= n_dimensions())
 			fault = true;
@@ -233,7 +233,8 @@ void	DataArrayMD<A2DT>::reorder_dimensions(const index_vector& iv)
 template<class A2DT>
 void	DataArrayMD<A2DT>::fill(const typename DataArrayMD<A2DT>::value_type &x)
 {
-	Apply_A_MD_F1(*this, [&x](value_type &v) { v = x; });
+	// Functors::assign позволяет заполнять большие массивы в несколько потоков, см. AutoOMPUsage()
+	Apply_AS_MD_F2(*this, x, Functors::assign());
 }
 
 //--------------------------------------------------------------
@@ -277,7 +278,7 @@ void DataArrayMD<A2DT>::CopyData(const DataArrayMD<A2DT2> &original)
 		return;
 	}
 	if(original.empty()) fill(zero_value(value_type()));
-	else Apply_AA_MD_Different_F2(*this, original, Functors::assign());
+	else if(!CopyDataContiguous(original, linear_conversion())) Apply_AA_MD_Different_F2(*this, original, Functors::assign());
 }
 
 template<class A2DT>
@@ -290,7 +291,80 @@ void DataArrayMD<A2DT>::CopyData(const DataArrayMD<A2DT2> &original, const funct
 		f(zero_converted, zero_value(typename A2DT2::value_type()));
 		fill(zero_converted);
 	}
-	else Apply_AA_MD_Different_F2(*this, original, f);
+	else if(!CopyDataContiguous(original, f)) Apply_AA_MD_Different_F2(*this, original, f);
+}
+
+template<class A2DT>
+template<class A2DT2, class F>
+bool DataArrayMD<A2DT>::CopyDataContiguous(const DataArrayMD<A2DT2> &original, const F &f)
+{
+	// непрерывные целые -> float, double: векторизованное преобразование, см. ConvertData.h
+	if(empty() || sizes() != original.sizes() ||
+			!ConvertDataAux::is_dense(*this) || !ConvertDataAux::is_dense(original))
+	{
+		return false;
+	}
+	return ConvertDataAux::copy_contiguous(&at(index_vector(n_dimensions(), 0)),
+			&original.at(index_vector(n_dimensions(), 0)), element_count(), f);
+}
+
+template<class A2DT>
+template<class T2>
+void DataArrayMD<A2DT>::CopyData(const T2 *new_data, ptrdiff_t in_data_step)
+{
+	if(empty())
+		return;
+	// непрерывные целые -> float, double: векторизованное преобразование, см. ConvertData.h
+	if(in_data_step == 1 && ConvertDataAux::is_dense(*this) &&
+			ConvertDataAux::copy_contiguous(&at(index_vector(n_dimensions(), 0)), new_data, element_count(),
+					linear_conversion()))
+	{
+		return;
+	}
+	CopyDataBySlices(new_data, in_data_step, [in_data_step](slice_type &slice, const T2 *slice_data)
+	{
+		slice.CopyData(slice_data, in_data_step);
+	});
+}
+
+template<class A2DT>
+template<class T2, class F>
+void DataArrayMD<A2DT>::CopyData(const T2 *new_data, ptrdiff_t in_data_step, const F &f)
+{
+	if(empty())
+		return;
+	if(in_data_step == 1 && ConvertDataAux::is_dense(*this) &&
+			ConvertDataAux::copy_contiguous(&at(index_vector(n_dimensions(), 0)), new_data, element_count(), f))
+	{
+		return;
+	}
+	CopyDataBySlices(new_data, in_data_step, [in_data_step, &f](slice_type &slice, const T2 *slice_data)
+	{
+		slice.CopyData(slice_data, in_data_step, f);
+	});
+}
+
+template<class A2DT>
+template<class T2, class CopySlice>
+void DataArrayMD<A2DT>::CopyDataBySlices(const T2 *new_data, ptrdiff_t in_data_step, const CopySlice &copy_slice)
+{
+	const size_t	n = n_dimensions();
+	const size_t	slice_size = sizes(n - 2)*sizes(n - 1);
+	const size_t	n_slices = element_count()/slice_size;
+	index_vector	iv(n);
+	iv[n - 2] = slice_mask(0);
+	iv[n - 1] = slice_mask(1);
+	slice_type	slice;
+	for(size_t k = 0; k < n_slices; ++k)
+	{
+		for(size_t d = n - 2, index = k; d-- > 0;)
+		{
+			iv[d] = index%sizes(d);
+			index /= sizes(d);
+		}
+		GetSlice(slice, iv);
+		copy_slice(slice, new_data + ptrdiff_t(k*slice_size)*in_data_step);
+	}
 }
 
 //--------------------------------------------------------------
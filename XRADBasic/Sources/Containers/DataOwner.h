@@ -10,6 +10,7 @@
 //--------------------------------------------------------------
 
 #include "Iterators.h"
+#include "DataAllocator.h"
 
 XRAD_BEGIN
 
@@ -85,6 +86,9 @@ template <class VT> class DataOwner
 		*/
 		ptrdiff_t	m_step;
 		bool	m_ownData;
+
+		//! \brief Распределитель, которым выделены собственные данные (при m_ownData)
+		const data_allocator	*m_allocator;
 		//! @}
 
 		//! \name Constructors and destructor
@@ -96,8 +100,8 @@ template <class VT> class DataOwner
 		//! Поэтому они объявлены = delete.
 		//! @{
 	protected:
-		DataOwner(): m_ownData(false), m_size(0), m_step(0), m_data(0) {}
-		explicit DataOwner(size_t in_size): m_ownData(false), m_size(0), m_step(0), m_data(0) {allocate(in_size);}
+		DataOwner(): m_ownData(false), m_size(0), m_step(0), m_data(0), m_allocator(nullptr) {}
+		explicit DataOwner(size_t in_size): m_ownData(false), m_size(0), m_step(0), m_data(0), m_allocator(nullptr) {allocate(in_size);}
 		virtual ~DataOwner() {dispose();}
 
 	private:
@@ -123,10 +127,12 @@ template <class VT> class DataOwner
 			m_size = other.m_size;
 			m_step = other.m_step;
 			m_data = other.m_data;
+			m_allocator = other.m_allocator;
 			other.m_ownData = false;
 			other.m_size = 0;
 			other.m_step = 0;
 			other.m_data = nullptr;
+			other.m_allocator = nullptr;
 		}
 
 	protected:
@@ -13,6 +13,7 @@
 #include <XRADBasic/Sources/Core/String.h>
 #include <XRADBasic/Sources/Core/BasicUtils.h>
 #include <type_traits>
+#include <memory>
 
 XRAD_BEGIN
 
@@ -37,53 +38,52 @@ void DataOwner<VT>::allocate(size_t s)
 	m_step = 0;
 	m_data = NULL;
 	m_ownData = false;
+	m_allocator = nullptr;
 
 	if(s>0)
 	{
-		// аллокируем через new[], память инициализируется только
-		// при наличии конструктора (для простых типов вроде int, double
-		// остается неинициализированной)
-		// удаляем через delete[]
+		// память выделяется текущим распределителем (см. DataAllocator.h) с выравниванием
+		// data_alignment<VT>(). элементы создаются так же, как при new[]: конструктор вызывается
+		// только при его наличии (для простых типов вроде int, double память остается
+		// неинициализированной)
+		// TODO: Для const-типов не долюно быть операций allocate вообще.
+		// Контейнеры с такими типами могут использоваться только как ссылки на внешние данные
+		// или быть пустыми.
+		const data_allocator	*allocator = GetDataAllocator();
+		value_type_variable	*data = nullptr;
 
 		try
 		{
-			m_size = s;
-			m_step = 1;
-			m_ownData = true;
-			// TODO: Для const-типов не долюно быть операций allocate вообще.
-			// Контейнеры с такими типами могут использоваться только как ссылки на внешние данные
-			// или быть пустыми.
-			m_data = new std::remove_const_t<VT>[m_size];
+			data = static_cast<value_type_variable*>(
+					AllocateData(allocator, s, sizeof(value_type_variable), data_alignment<value_type_variable>()));
 		}
 		catch(bad_alloc &)
 		{
 			// нехватка памяти
 			ForceDebugBreak();
-
-			m_size = 0;
-			m_step = 0;
-			m_ownData = false;
-			m_data = NULL;
-
 			throw;
 			// альтернативный вариант обработки: генерировать исключение с развернутой информацией в what(). к сожалению,
 			// передать текст внутри bad_alloc не получается, поэтому нужно передавать какой-то более развитый тип.
 			// throw(invalid_argument(typeid(self).name() + ssprintf("::allocate(int s = %d), out of memory", s)));
 		}
+
+		try
+		{
+			std::uninitialized_default_construct_n(data, s);
+		}
 		catch(...)
 		{
-			// проверка других исключений
+			// исключение в конструкторе элемента: созданные элементы уже уничтожены
 			ForceDebugBreak();
-
-			m_size = 0;
-			m_step = 0;
-			m_ownData = false;
-			// вначале m_data была проинициализирована нулем, так что
-			// удаление ненулевого массива здесь корректно
-			DestroyArray(m_data);
-
+			DeallocateData(allocator, data, s, sizeof(value_type_variable), data_alignment<value_type_variable>());
 			throw;
 		}
+
+		m_data = data;
+		m_size = s;
+		m_step = 1;
+		m_ownData = true;
+		m_allocator = allocator;
 	}
 }
 
@@ -93,9 +93,13 @@ void DataOwner<VT>::dispose()
 {
 	if(m_ownData)
 	{
-		delete[] (m_step >= 0 || !m_size? m_data: m_data + m_step * ptrdiff_t(m_size - 1));
+		value_type_variable	*data = const_cast<value_type_variable*>(
+				m_step >= 0 || !m_size? m_data: m_data + m_step * ptrdiff_t(m_size - 1));
+		std::destroy_n(data, m_size);
+		DeallocateData(m_allocator, data, m_size, sizeof(value_type_variable), data_alignment<value_type_variable>());
 		m_data = nullptr;
 		m_ownData = false;
+		m_allocator = nullptr;
 	}
 	else
 	{
@@ -107,6 +107,8 @@ class	MathFunction : public Algebra1D<MathFunction<XRAD__MathFunction_template_a
 		void	FilterRecursiveBidirectional(const FILTER_KERNEL_T &filter);
 
 	public:
+		//! \brief Фильтрация. Длинные КИХ-фильтры (от FIRFilterFFT::min_kernel_size отсчетов)
+		//! выполняются через FFT, если это возможно (см. FIRFilterFFT)
 		template<class FILTER_KERNEL_T>
 		void	Filter(const FILTER_KERNEL_T &filter);
 
@@ -12,6 +12,8 @@
 
 // TODO: Разорвать эту зависимость от посторонних типов данных.
 #include "FIRFilterKernelFunctions.h"
+#include "FIRFilterFFT.h"
+#include "ScratchArena.h"
 
 XRAD_BEGIN
 
@@ -30,6 +32,11 @@ template<class FILTER_KERNEL_T>
 void	MathFunction<XRAD__MathFunction_template_args>::Filter(const FILTER_KERNEL_T &filter)
 {
 	filtering_algorithm fa = filter.FilteringAlgorithm();
+
+	// Длинные КИХ-фильтры выполняются через FFT, если это возможно (см. FIRFilterFFT)
+	if((fa == fir_scan_data || fa == fir_scan_filter || fa == fir_built_in) && FIRFilterFFT::Filter1D(*this, filter))
+		return;
+
 	bool	do_bufferization = (step()>1) &&
 		(complexity_e(T()) <= number_complexity_e::array) &&
 		(fa != fir_scan_filter) &&
@@ -571,6 +578,8 @@ void	MathFunction<XRAD__MathFunction_template_args>::FilterMedian(size_t filter_
 	if(!(filter_size%2)) ++filter_size; // Должен быть нечетным
 	size_t	fs2 = filter_size/2;
 
+	// Временные буферы берутся из арены потока
+	ScratchArenaScope	scratch;
 	const self	unfiltered_buffer(*this);
 	self	filter(filter_size);
 
@@ -91,7 +91,8 @@ class	MathFunction2D : public Algebra2D<MathFunction2D<FT>, FT, typename FT::val
 		//! \name	Фильтрация
 		//! @{
 
-		//! \brief Линейная фильтрация
+		//! \brief Линейная фильтрация. Большие ядра FIRFilterKernel2DConvolve
+		//! применяются через FFT, если это возможно (см. FIRFilterFFT)
 		template<class FIR_FILTER_T>
 		void	Filter(const FIR_FILTER_T &);
 
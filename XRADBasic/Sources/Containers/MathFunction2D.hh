@@ -11,6 +11,9 @@
 
 #include "SpaceCoordinates.h"
 #include "UniversalInterpolation2D.h"
+#include "FIRFilterFFT.h"
+#include "ScratchArena.h"
+#include "TransposeCopy.h"
 
 XRAD_BEGIN
 
@@ -68,7 +71,17 @@ template<class FT>
 template<class FIR_FILTER_T>
 void	MathFunction2D<FT>::Filter(const FIR_FILTER_T &filter)
 {
-	self Buffer(*this);
+	// Большие ядра свертки применяются через FFT, если это возможно (см. FIRFilterFFT)
+	if(FIRFilterFFT::Filter2D(*this, filter))
+		return;
+
+	// Копия данных берется из арены потока. Область арены охватывает только выделение
+	// памяти: filter.Apply() может размещать собственные долговременные буферы
+	self Buffer;
+	{
+		ScratchArenaScope	scratch;
+		Buffer.MakeCopy(*this);
+	}
 
 	for(size_t i = 0; i < vsize(); i++)
 	{
@@ -88,6 +101,46 @@ void	MathFunction2D<FT>::Filter(const FIR_FILTER_T &filter)
 // Обход по каждой из 2 осей по рядам
 //--------------------------------------------------------------
 
+namespace FilterArray2DAuxiliaries
+{
+
+//! \brief Минимальное число столбцов, при котором столбцы фильтруются через транспонированную копию
+constexpr size_t	transposed_filter_min_columns = 8;
+
+/*!
+	\brief Отфильтровать столбцы как строки транспонированной копии
+
+	Фильтрация столбца с шагом в строку копирует его в буфер поэлементно, обращаясь к новой
+	строке кэша на каждом отсчете. Транспонированная копия (transpose_copy()) переносит данные
+	блоками, и затем все столбцы фильтруются как непрерывные строки.
+	Возвращает false, если такой способ не выгоден (узкий массив, отсчеты -- контейнеры).
+*/
+template <class FT, class FILTER_T>
+bool	FilterColumnsTransposed(DataArray2D<FT> &slice, const FILTER_T &filter)
+{
+	using value_type = typename DataArray2D<FT>::value_type;
+	if(slice.hsize() < transposed_filter_min_columns || slice.vsize() < 2 ||
+			complexity_e(value_type()) > number_complexity_e::array)
+	{
+		return false;
+	}
+	DataArray2D<FT>	transposed;
+	{
+		// Только буфер берется из арены потока: фильтр может размещать долговременные буферы
+		ScratchArenaScope	scratch;
+		transposed.realloc(slice.hsize(), slice.vsize());
+	}
+	transpose_copy(MakeView(transposed), MakeView(slice));
+	for(size_t i = 0; i < transposed.vsize(); ++i)
+	{
+		transposed.row(i).Filter(filter);
+	}
+	transpose_copy(MakeView(slice), MakeView(transposed));
+	return true;
+}
+
+} // namespace FilterArray2DAuxiliaries
+
 template <class FT, class FILTER_T1, class FILTER_T2>
 void FilterArray2DSeparate(DataArray2D<FT> &slice, const FILTER_T1 &filter_y, const FILTER_T2 &filter_x)
 {
@@ -105,7 +158,7 @@ void FilterArray2DSeparate(DataArray2D<FT> &slice, const FILTER_T1 &filter_y, co
 		}
 	}
 
-	if(filter_y.size()>1)
+	if(filter_y.size()>1 && !FilterArray2DAuxiliaries::FilterColumnsTransposed(slice, filter_y))
 	{
 		for(size_t i = 0; i < slice.hsize(); ++i)
 		{
@@ -155,7 +208,12 @@ template<class FT>
 template<class B>
 void	MathFunction2D<FT>::Filter(FIRFilterKernel2DMask<B> &filter)
 {
-	self	Buffer(*this);
+	self	Buffer;
+	{
+		// Копия данных из арены потока, см. выше
+		ScratchArenaScope	scratch;
+		Buffer.MakeCopy(*this);
+	}
 
 	for(size_t i = 0; i < vsize(); i++)
 	{
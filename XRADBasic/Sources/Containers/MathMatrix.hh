@@ -115,6 +115,10 @@ MathMatrix<XRAD__MathMatrix_template_args>	&MathMatrix<XRAD__MathMatrix_template
 		throw invalid_argument(problem_description);
 		}
 
+	// float, double, complexF32, complexF64: блочный многопоточный алгоритм, см. MatrixMultiply.h
+	if(MatrixMultiplyAux::matrix_multiply(*this, m1, m2))
+		return *this;
+
 	for(size_t i=0; i<m1.vsize(); i++)
 		{
 		auto it = row(i).begin();
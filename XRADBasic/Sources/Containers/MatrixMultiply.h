@@ -0,0 +1,130 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MatrixMultiply.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_MatrixMultiply_h
+#define XRAD__File_MatrixMultiply_h
+/*!
+	\file
+	\brief Блочное многопоточное умножение матриц для MathMatrix::matrix_multiply()
+
+	Внутренний файл библиотеки. Используется в MathMatrix.hh для матриц из float, double,
+	complexF32, complexF64 с одинаковыми типами элементов сомножителей и результата.
+
+	Алгоритм -- обычная схема GEMM с упаковкой панелей: измерение суммирования делится на отрезки
+	по blocking<R>::kc, столбцы результата -- на полосы по blocking<R>::nc. Для каждой пары
+	(полоса, отрезок) панель B переупаковывается в непрерывный буфер в порядке чтения
+	микроядром (см. MatrixMultiplySIMD.h), затем полосы результата по blocking<R>::mc строк
+	распределяются между потоками. Поток упаковывает свой блок A (mc x kc) в собственный
+	буфер, так что временная память ограничена размерами блоков и не зависит от размеров
+	матриц. Если полос меньше, чем нужно для загрузки потоков, они дополнительно делятся
+	по столбцам (не уже blocking<R>::min_task_columns).
+
+	Комплексное умножение сводится к действительному: комплексная матрица A размером m x k
+	в памяти совпадает с действительной матрицей m x 2k, результат -- с матрицей m x 2n,
+	а каждый элемент b матрицы B при упаковке заменяется блоком 2 x 2
+	[[re b, -im b], [im b, re b]]. Так вычисляется сумма a*conj(b), как в scalar_product(),
+	которым matrix_multiply() пользовалась раньше.
+
+	Порядок суммирования отличается от поэлементного алгоритма, поэтому результаты
+	для чисел с плавающей точкой могут отличаться в пределах ошибки округления.
+*/
+//--------------------------------------------------------------
+
+#include "MatrixMultiplySIMD.h"
+#include "ScratchArena.h"
+#include "DataArray.h"
+#include "BasicArrayInteractionsOMP.h"
+#include <omp.h>
+#include <XRADBasic/Sources/SampleTypes/ComplexSample.h>
+
+XRAD_BEGIN
+
+namespace MatrixMultiplyAux
+{
+
+//--------------------------------------------------------------
+
+//! \brief Размеры блоков алгоритма для действительного типа R
+template<class R>
+struct blocking
+{
+	//! \brief Длина отрезка суммирования: панель B kc x tile::columns остается в кэше L1
+	static constexpr size_t	kc = 256;
+	//! \brief Число строк блока A (kc x mc), который остается в кэше L2
+	static constexpr size_t	mc = 16*MatrixMultiplySIMD::tile<R>::rows;
+	//! \brief Ширина полосы столбцов, для которой упаковывается B
+	static constexpr size_t	nc = 2048;
+	//! \brief Наименьшая ширина блока результата, который получает один поток
+	static constexpr size_t	min_task_columns = 8*MatrixMultiplySIMD::tile<R>::columns;
+};
+
+//! \brief Наименьший объем m*n*k, начиная с которого используется блочный алгоритм
+constexpr size_t	blocked_min_volume = 16*16*16;
+
+//! \brief Сведения о типе элемента матрицы: поддерживается ли он блочным алгоритмом
+//! и каков соответствующий действительный тип
+template<class T>
+struct element_traits
+{
+	static constexpr bool	supported = false;
+};
+
+template<>
+struct element_traits<float>
+{
+	static constexpr bool	supported = true;
+	static constexpr bool	is_complex = false;
+	typedef float real_type;
+};
+
+template<>
+struct element_traits<double>
+{
+	static constexpr bool	supported = true;
+	static constexpr bool	is_complex = false;
+	typedef double real_type;
+};
+
+template<class R, class ST>
+struct element_traits<ComplexSample<R, ST>>
+{
+	static constexpr bool	supported = std::is_same<R, float>::value || std::is_same<R, double>::value;
+	static constexpr bool	is_complex = true;
+	typedef R real_type;
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Произведение c = a*b действительных матриц m x k и k x n
+
+	a(i, p) и b(p, j) возвращают элементы сомножителей, строки результата идут с шагом c_step,
+	элементы в строке -- подряд.
+*/
+template<class R, class AccessA, class AccessB>
+void	gemm(size_t m, size_t n, size_t k, const AccessA &a, const AccessB &b, R *c, ptrdiff_t c_step,
+		omp_usage_t omp);
+
+/*!
+	\brief Вычислить result = m1*m2 (для комплексных матриц m1*conj(m2)) блочным алгоритмом
+
+	\return false, если блочный алгоритм не применим (типы элементов или слишком малый размер);
+	тогда result не изменяется. Размеры должны быть проверены вызывающей стороной.
+*/
+template<class M, class M1, class M2>
+bool	matrix_multiply(M &result, const M1 &m1, const M2 &m2);
+
+//--------------------------------------------------------------
+
+} // namespace MatrixMultiplyAux
+
+XRAD_END
+
+#include "MatrixMultiply.hh"
+
+//--------------------------------------------------------------
+#endif // XRAD__File_MatrixMultiply_h
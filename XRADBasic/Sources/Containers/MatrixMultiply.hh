@@ -0,0 +1,219 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MatrixMultiply.hh
+//--------------------------------------------------------------
+#ifndef XRAD__File_MatrixMultiply_hh
+#define XRAD__File_MatrixMultiply_hh
+
+XRAD_BEGIN
+
+namespace MatrixMultiplyAux
+{
+
+//--------------------------------------------------------------
+
+//! \brief Скалярное микроядро с той же упаковкой, что у векторизованных (см. MatrixMultiplySIMD.h)
+template<class R>
+void	scalar_kernel(size_t k, const R *a, const R *b, R *c, ptrdiff_t c_step, bool accumulate)
+{
+	constexpr size_t	rows = MatrixMultiplySIMD::tile<R>::rows;
+	constexpr size_t	columns = MatrixMultiplySIMD::tile<R>::columns;
+	R	sum[rows][columns] = {};
+	for(size_t p = 0; p < k; ++p, a += rows, b += columns)
+	{
+		for(size_t i = 0; i < rows; ++i)
+		{
+			for(size_t j = 0; j < columns; ++j)
+				sum[i][j] += a[i]*b[j];
+		}
+	}
+	for(size_t i = 0; i < rows; ++i)
+	{
+		R	*row = c + ptrdiff_t(i)*c_step;
+		for(size_t j = 0; j < columns; ++j)
+			row[j] = accumulate? row[j] + sum[i][j]: sum[i][j];
+	}
+}
+
+template<class R, class AccessA, class AccessB>
+void	gemm(size_t m, size_t n, size_t k, const AccessA &a, const AccessB &b, R *c, ptrdiff_t c_step,
+		omp_usage_t omp)
+{
+	typedef blocking<R> block;
+	constexpr size_t	mr = MatrixMultiplySIMD::tile<R>::rows;
+	constexpr size_t	nr = MatrixMultiplySIMD::tile<R>::columns;
+	constexpr size_t	min_task_panels = block::min_task_columns/nr;
+	constexpr size_t	block_panels = block::mc/mr;
+
+	const MatrixMultiplySIMD::Kernels	*kernels = MatrixMultiplySIMD::ActiveKernels();
+	MatrixMultiplySIMD::kernel_function<R>	kernel = kernels? kernels->template kernel<R>(): scalar_kernel<R>;
+
+	const size_t	m_panels = (m + mr - 1)/mr;
+	const size_t	max_n_panels = (min(n, block::nc) + nr - 1)/nr;
+	const size_t	max_kc = min(k, block::kc);
+	const size_t	a_pack_size = min(m_panels, block_panels)*mr*max_kc;
+
+	// Панель B не больше nc x kc, блок A каждого потока не больше mc x kc, поэтому память
+	// арены не зависит от размеров матриц. Потоки OpenMP панель B только читают
+	DataArray<R>	b_pack;
+	{
+		ScratchArenaScope	scratch;
+		b_pack.realloc(max_n_panels*nr*max_kc);
+	}
+	R	*b_data = b_pack.data();
+
+	for(size_t jc = 0; jc < n; jc += block::nc)
+	{
+		const size_t	nc = min(block::nc, n - jc);
+		const size_t	n_panels = (nc + nr - 1)/nr;
+		for(size_t pc = 0; pc < k; pc += block::kc)
+		{
+			const size_t	kc = min(block::kc, k - pc);
+			const bool	accumulate = pc > 0;
+
+			BAI_OMP_aux::for_each_index(n_panels, omp, "matrix_multiply", [&](size_t jr)
+			{
+				R	*panel = b_data + jr*kc*nr;
+				for(size_t p = 0; p < kc; ++p, panel += nr)
+				{
+					for(size_t j = 0, column = jc + jr*nr; j < nr; ++j, ++column)
+						panel[j] = column < jc + nc? b(pc + p, column): R(0);
+				}
+			});
+
+			// Каждая задача упаковывает свой блок A, поэтому полосы строк делятся по столбцам
+			// только при нехватке задач (примерно 4 на поток)
+			const size_t	n_blocks = (m_panels + block_panels - 1)/block_panels;
+			size_t	n_splits = 1;
+			if(omp == e_use_omp)
+			{
+				const size_t	n_tasks = 4*size_t(omp_get_max_threads());
+				n_splits = max(size_t(1), min((n_tasks + n_blocks - 1)/n_blocks, n_panels/min_task_panels));
+			}
+			BAI_OMP_aux::for_each_index(n_blocks*n_splits, omp, "matrix_multiply", [&](size_t task_no)
+			{
+				const size_t	ir_begin = (task_no/n_splits)*block_panels;
+				const size_t	ir_end = min(ir_begin + block_panels, m_panels);
+				const size_t	jr_begin = (task_no%n_splits)*n_panels/n_splits;
+				const size_t	jr_end = (task_no%n_splits + 1)*n_panels/n_splits;
+
+				// блок A упаковывается в буфер потока, выполняющего задачу
+				DataArray<R>	a_pack;
+				{
+					ScratchArenaScope	scratch;
+					a_pack.realloc(a_pack_size);
+				}
+				R	*a_data = a_pack.data();
+				for(size_t ir = ir_begin; ir < ir_end; ++ir)
+				{
+					R	*panel = a_data + (ir - ir_begin)*kc*mr;
+					for(size_t p = 0; p < kc; ++p, panel += mr)
+					{
+						for(size_t i = 0, row = ir*mr; i < mr; ++i, ++row)
+							panel[i] = row < m? a(row, pc + p): R(0);
+					}
+				}
+
+				for(size_t jr = jr_begin; jr < jr_end; ++jr)
+				{
+					const R	*b_panel = b_data + jr*kc*nr;
+					const size_t	columns = min(nr, nc - jr*nr);
+					for(size_t ir = ir_begin; ir < ir_end; ++ir)
+					{
+						const R	*a_panel = a_data + (ir - ir_begin)*kc*mr;
+						const size_t	rows = min(mr, m - ir*mr);
+						R	*c_tile = c + ptrdiff_t(ir*mr)*c_step + ptrdiff_t(jc + jr*nr);
+						if(rows == mr && columns == nr)
+						{
+							kernel(kc, a_panel, b_panel, c_tile, c_step, accumulate);
+							continue;
+						}
+						// краевой блок вычисляется целиком во временный буфер
+						alignas(64) R	tile[mr*nr];
+						kernel(kc, a_panel, b_panel, tile, nr, false);
+						for(size_t i = 0; i < rows; ++i)
+						{
+							R	*row = c_tile + ptrdiff_t(i)*c_step;
+							for(size_t j = 0; j < columns; ++j)
+								row[j] = accumulate? row[j] + tile[i*nr + j]: tile[i*nr + j];
+						}
+					}
+				}
+			});
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class M, class M1, class M2>
+bool	matrix_multiply(M &result, const M1 &m1, const M2 &m2)
+{
+	typedef typename M::value_type T;
+	typedef std::remove_const_t<typename M1::value_type> T1;
+	typedef std::remove_const_t<typename M2::value_type> T2;
+	if constexpr (std::is_same<T, T1>::value && std::is_same<T, T2>::value && element_traits<T>::supported)
+	{
+		typedef typename element_traits<T>::real_type R;
+		const size_t	m = m1.vsize(), n = m2.hsize(), k = m1.hsize();
+		if(!m || !n || !k || m*n*k < blocked_min_volume)
+			return false;
+		if(result.hstep_raw() != 1)
+		{
+			// микроядро пишет строки результата подряд
+			M	buffer(result.vsize(), result.hsize());
+			matrix_multiply(buffer, m1, m2);
+			result.CopyData(buffer);
+			return true;
+		}
+		const omp_usage_t	omp = m*n*k >= parallel_interactions_min_size? e_use_omp: e_dont_use_omp;
+		const ptrdiff_t	a_vstep = m1.vstep_raw(), a_hstep = m1.hstep_raw();
+		const ptrdiff_t	b_vstep = m2.vstep_raw(), b_hstep = m2.hstep_raw();
+		if constexpr (!element_traits<T>::is_complex)
+		{
+			const R	*a = &m1.at(0, 0), *b = &m2.at(0, 0);
+			gemm<R>(m, n, k,
+					[a, a_vstep, a_hstep](size_t i, size_t p) { return a[ptrdiff_t(i)*a_vstep + ptrdiff_t(p)*a_hstep]; },
+					[b, b_vstep, b_hstep](size_t p, size_t j) { return b[ptrdiff_t(p)*b_vstep + ptrdiff_t(j)*b_hstep]; },
+					&result.at(0, 0), result.vstep_raw(), omp);
+		}
+		else
+		{
+			static_assert(sizeof(T) == 2*sizeof(R), "Unexpected complex layout.");
+			// действительные представления: шаги в числах R, (i, 2p + 1) -- мнимая часть m1(i, p)
+			const R	*a = reinterpret_cast<const R*>(&m1.at(0, 0));
+			const R	*b = reinterpret_cast<const R*>(&m2.at(0, 0));
+			gemm<R>(m, 2*n, 2*k,
+					[a, a_vstep, a_hstep](size_t i, size_t p)
+					{
+						return a[2*(ptrdiff_t(i)*a_vstep + ptrdiff_t(p/2)*a_hstep) + ptrdiff_t(p%2)];
+					},
+					[b, b_vstep, b_hstep](size_t p, size_t j)
+					{
+						// блок 2 x 2 для conj(b): [[re, -im], [im, re]]
+						const R	*element = b + 2*(ptrdiff_t(p/2)*b_vstep + ptrdiff_t(j/2)*b_hstep);
+						if(p%2 == j%2)
+							return element[0];
+						return p%2? element[1]: -element[1];
+					},
+					reinterpret_cast<R*>(&result.at(0, 0)), 2*result.vstep_raw(), omp);
+		}
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+//--------------------------------------------------------------
+
+} // namespace MatrixMultiplyAux
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_MatrixMultiply_hh
@@ -0,0 +1,31 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MatrixMultiplySIMD.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "MatrixMultiplySIMD.h"
+
+XRAD_BEGIN
+
+namespace MatrixMultiplySIMD
+{
+
+//--------------------------------------------------------------
+
+const Kernels *ActiveKernels()
+{
+#ifdef XRAD_CPU_X86
+	if(ActiveSIMDInstructionSet() >= e_simd_avx2)
+		return &Kernels_AVX2();
+#endif
+	return nullptr;
+}
+
+//--------------------------------------------------------------
+
+} // namespace MatrixMultiplySIMD
+
+XRAD_END
@@ -0,0 +1,105 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MatrixMultiplySIMD.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_MatrixMultiplySIMD_h
+#define XRAD__File_MatrixMultiplySIMD_h
+/*!
+	\file
+	\brief Векторизованные микроядра матричного умножения
+
+	Внутренний файл библиотеки. Используется в MatrixMultiply.hh.
+
+	Микроядро вычисляет блок tile<R>::rows x tile<R>::columns произведения упакованных панелей:
+	панели A (столбцы блока строк, по rows чисел на каждое p) и панели B (строки блока столбцов,
+	по columns чисел на каждое p). Накопители блока целиком помещаются в регистрах.
+
+	Реализация находится в отдельной единице трансляции MatrixMultiplySIMD_AVX2.cpp,
+	которая компилируется с ключами AVX2 и FMA. Выбор выполняется во время выполнения
+	по ActiveSIMDInstructionSet().
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Sources/Core/CPUFeatures.h>
+#include <cstddef>
+
+XRAD_BEGIN
+
+namespace MatrixMultiplySIMD
+{
+
+//--------------------------------------------------------------
+
+//! \brief Размеры блока результата, вычисляемого микроядром
+template<class R>
+struct tile;
+
+template<>
+struct tile<float>
+{
+	static constexpr size_t	rows = 6;
+	static constexpr size_t	columns = 16;
+};
+
+template<>
+struct tile<double>
+{
+	static constexpr size_t	rows = 6;
+	static constexpr size_t	columns = 8;
+};
+
+/*!
+	\brief Микроядро: c[i*c_step + j] = sum(a[p*rows + i]*b[p*columns + j], p < k)
+	для i < tile<R>::rows, j < tile<R>::columns. При accumulate сумма прибавляется к c
+*/
+template<class R>
+using kernel_function = void (*)(size_t k, const R *a, const R *b, R *c, ptrdiff_t c_step, bool accumulate);
+
+//! \brief Набор ядер для одного набора инструкций
+struct Kernels
+{
+	//! \brief Набор инструкций, для которого скомпилированы ядра
+	simd_instruction_set_t	instruction_set;
+
+	kernel_function<float>	kernel_f32;
+	kernel_function<double>	kernel_f64;
+
+	template<class R>
+	kernel_function<R>	kernel() const;
+};
+
+template<>
+inline kernel_function<float>	Kernels::kernel<float>() const { return kernel_f32; }
+
+template<>
+inline kernel_function<double>	Kernels::kernel<double>() const { return kernel_f64; }
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Ядра для текущего набора инструкций ActiveSIMDInstructionSet()
+
+	\return nullptr, если векторизованные ядра недоступны (используется скалярный код)
+*/
+const Kernels *ActiveKernels();
+
+//--------------------------------------------------------------
+
+#ifdef XRAD_CPU_X86
+
+//! \brief Реализация AVX2. Вызывать только при DetectedSIMDInstructionSet() >= e_simd_avx2
+const Kernels &Kernels_AVX2();
+
+#endif // XRAD_CPU_X86
+
+//--------------------------------------------------------------
+
+} // namespace MatrixMultiplySIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_MatrixMultiplySIMD_h
@@ -0,0 +1,136 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MatrixMultiplySIMD_AVX2.cpp
+//--------------------------------------------------------------
+// Файл компилируется с ключами AVX2 и FMA (см. CMakeLists.txt, XRADBasic.vcxproj)
+// без предкомпилированного заголовка: код из других файлов не должен компилироваться с этими ключами.
+// Функции этого файла вызываются только при DetectedSIMDInstructionSet() >= e_simd_avx2.
+#include "MatrixMultiplySIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <immintrin.h>
+
+XRAD_BEGIN
+
+namespace MatrixMultiplySIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Операции с вектором AVX для типа R
+template<class R>
+struct vector_ops;
+
+template<>
+struct vector_ops<float>
+{
+	typedef __m256	type;
+	static type	zero() { return _mm256_setzero_ps(); }
+	static type	load(const float *p) { return _mm256_loadu_ps(p); }
+	static type	broadcast(const float *p) { return _mm256_broadcast_ss(p); }
+	static type	fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+	static type	add(type a, type b) { return _mm256_add_ps(a, b); }
+	static void	store(float *p, type v) { _mm256_storeu_ps(p, v); }
+};
+
+template<>
+struct vector_ops<double>
+{
+	typedef __m256d	type;
+	static type	zero() { return _mm256_setzero_pd(); }
+	static type	load(const double *p) { return _mm256_loadu_pd(p); }
+	static type	broadcast(const double *p) { return _mm256_broadcast_sd(p); }
+	static type	fmadd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+	static type	add(type a, type b) { return _mm256_add_pd(a, b); }
+	static void	store(double *p, type v) { _mm256_storeu_pd(p, v); }
+};
+
+/*!
+	\brief Блок 6 x 2 вектора: 12 накопителей, 2 вектора строки B и значение A
+	занимают 15 из 16 регистров AVX
+*/
+template<class R>
+void	kernel_6x2(size_t k, const R *a, const R *b, R *c, ptrdiff_t c_step, bool accumulate)
+{
+	typedef vector_ops<R> ops;
+	typedef typename ops::type vector;
+	constexpr size_t	rows = tile<R>::rows;
+	constexpr size_t	columns = tile<R>::columns;
+	constexpr size_t	w = columns/2;
+	static_assert(rows == 6, "Invalid tile size.");
+
+	vector	c00 = ops::zero(), c01 = ops::zero(), c10 = ops::zero(), c11 = ops::zero();
+	vector	c20 = ops::zero(), c21 = ops::zero(), c30 = ops::zero(), c31 = ops::zero();
+	vector	c40 = ops::zero(), c41 = ops::zero(), c50 = ops::zero(), c51 = ops::zero();
+
+	for(size_t p = 0; p < k; ++p, a += rows, b += columns)
+	{
+		vector	b0 = ops::load(b), b1 = ops::load(b + w);
+		vector	ai = ops::broadcast(a);
+		c00 = ops::fmadd(ai, b0, c00);
+		c01 = ops::fmadd(ai, b1, c01);
+		ai = ops::broadcast(a + 1);
+		c10 = ops::fmadd(ai, b0, c10);
+		c11 = ops::fmadd(ai, b1, c11);
+		ai = ops::broadcast(a + 2);
+		c20 = ops::fmadd(ai, b0, c20);
+		c21 = ops::fmadd(ai, b1, c21);
+		ai = ops::broadcast(a + 3);
+		c30 = ops::fmadd(ai, b0, c30);
+		c31 = ops::fmadd(ai, b1, c31);
+		ai = ops::broadcast(a + 4);
+		c40 = ops::fmadd(ai, b0, c40);
+		c41 = ops::fmadd(ai, b1, c41);
+		ai = ops::broadcast(a + 5);
+		c50 = ops::fmadd(ai, b0, c50);
+		c51 = ops::fmadd(ai, b1, c51);
+	}
+
+	auto	store_row = [c_step, accumulate, c](size_t i, vector v0, vector v1)
+	{
+		R	*row = c + ptrdiff_t(i)*c_step;
+		if(accumulate)
+		{
+			v0 = ops::add(v0, ops::load(row));
+			v1 = ops::add(v1, ops::load(row + w));
+		}
+		ops::store(row, v0);
+		ops::store(row + w, v1);
+	};
+	store_row(0, c00, c01);
+	store_row(1, c10, c11);
+	store_row(2, c20, c21);
+	store_row(3, c30, c31);
+	store_row(4, c40, c41);
+	store_row(5, c50, c51);
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels &Kernels_AVX2()
+{
+	static const Kernels	kernels =
+	{
+		e_simd_avx2,
+		kernel_6x2<float>,
+		kernel_6x2<double>
+	};
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace MatrixMultiplySIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
@@ -0,0 +1,198 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ScratchArena.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "ScratchArena.h"
+#include <cstdint>
+#include <new>
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Минимальный размер блока арены, байт
+const size_t min_chunk_size = 256*1024;
+
+//! \brief Выравнивание блоков арены
+const size_t chunk_alignment = 4096;
+
+/*!
+	\brief Владелец арены потока
+
+	Если при завершении потока из арены еще не освобождены буферы (массив пережил поток),
+	арена не уничтожается, чтобы эти буферы оставались корректными.
+*/
+struct local_arena_holder
+{
+	ScratchArena	*arena = nullptr;
+
+	~local_arena_holder()
+	{
+		if(arena && !arena->BufferCount())
+			delete arena;
+	}
+};
+
+} // namespace
+
+//--------------------------------------------------------------
+
+ScratchArena::ScratchArena():
+	m_heap_allocation_count(0),
+	m_allocator{allocate_hook, deallocate_hook, this}
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+	FreeChunks();
+}
+
+ScratchArena &ScratchArena::Local()
+{
+	thread_local local_arena_holder	holder;
+	if(!holder.arena)
+		holder.arena = new ScratchArena;
+	return *holder.arena;
+}
+
+//--------------------------------------------------------------
+
+void *ScratchArena::TryAllocate(size_t chunk_index, size_t size, size_t alignment)
+{
+	chunk	&c = m_chunks[chunk_index];
+	uintptr_t	base = reinterpret_cast<uintptr_t>(c.data);
+	uintptr_t	start = (base + c.used + alignment - 1) & ~uintptr_t(alignment - 1);
+	if(start - base > c.size || c.size - (start - base) < size)
+		return nullptr;
+	m_buffers.push_back({reinterpret_cast<void*>(start), chunk_index, c.used, false});
+	c.used = start - base + size;
+	return reinterpret_cast<void*>(start);
+}
+
+void ScratchArena::AddChunk(size_t size)
+{
+	m_chunks.reserve(m_chunks.size() + 1);
+	char	*data = static_cast<char*>(AllocateData(DefaultDataAllocator(), size, 1, chunk_alignment));
+	++m_heap_allocation_count;
+	m_chunks.push_back({data, size, 0});
+}
+
+void ScratchArena::FreeChunks()
+{
+	for(auto &c: m_chunks)
+		DeallocateData(DefaultDataAllocator(), c.data, c.size, 1, chunk_alignment);
+	m_chunks.clear();
+}
+
+void ScratchArena::PopBuffer()
+{
+	const buffer	&b = m_buffers.back();
+	m_chunks[b.chunk_index].used = b.previous_used;
+	m_buffers.pop_back();
+}
+
+//--------------------------------------------------------------
+
+void *ScratchArena::Allocate(size_t size, size_t alignment)
+{
+	if(alignment > chunk_alignment)
+		return nullptr;
+	if(m_buffers.empty() && m_chunks.size() > 1)
+	{
+		// Объединяем блоки опустевшей арены в один, чтобы в установившемся режиме хватало
+		// одного блока. Это делается здесь, а не в Deallocate(): освобождение вызывается
+		// из деструкторов массивов и не должно обращаться к куче
+		size_t	total_size = Capacity();
+		FreeChunks();
+		try
+		{
+			AddChunk(total_size);
+		}
+		catch(std::bad_alloc &)
+		{
+			// Объединение необязательно: ниже будет выделен блок нужного размера
+		}
+	}
+	// Блоки после блока последнего буфера пусты
+	for(size_t i = m_buffers.empty()? 0: m_buffers.back().chunk_index; i < m_chunks.size(); ++i)
+	{
+		if(void *p = TryAllocate(i, size, alignment))
+			return p;
+	}
+	size_t	chunk_size = m_chunks.empty()? min_chunk_size: 2*m_chunks.back().size;
+	if(chunk_size < size)
+		chunk_size = size;
+	AddChunk(chunk_size);
+	return TryAllocate(m_chunks.size() - 1, size, alignment);
+}
+
+void ScratchArena::Deallocate(void *p)
+{
+	if(!m_buffers.empty() && m_buffers.back().p == p)
+	{
+		PopBuffer();
+		while(!m_buffers.empty() && m_buffers.back().released)
+			PopBuffer();
+		return;
+	}
+	for(auto it = m_buffers.rbegin(); it != m_buffers.rend(); ++it)
+	{
+		if(it->p == p)
+		{
+			it->released = true;
+			return;
+		}
+	}
+	// Буфер выделен не этой ареной
+	ForceDebugBreak();
+}
+
+void ScratchArena::Release()
+{
+	if(m_buffers.empty())
+		FreeChunks();
+}
+
+size_t ScratchArena::Capacity() const
+{
+	size_t	result = 0;
+	for(auto &c: m_chunks)
+		result += c.size;
+	return result;
+}
+
+//--------------------------------------------------------------
+
+void *ScratchArena::allocate_hook(size_t size, size_t alignment, void *context)
+{
+	return static_cast<ScratchArena*>(context)->Allocate(size, alignment);
+}
+
+void ScratchArena::deallocate_hook(void *p, size_t, size_t, void *context)
+{
+	static_cast<ScratchArena*>(context)->Deallocate(p);
+}
+
+//--------------------------------------------------------------
+
+ScratchArenaScope::ScratchArenaScope():
+	m_previous_allocator(SetThreadDataAllocator(ScratchArena::Local().Allocator()))
+{
+}
+
+ScratchArenaScope::~ScratchArenaScope()
+{
+	SetThreadDataAllocator(m_previous_allocator);
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
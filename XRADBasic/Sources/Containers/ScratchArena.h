@@ -0,0 +1,154 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file ScratchArena.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_ScratchArena_h
+#define XRAD__File_ScratchArena_h
+/*!
+	\file
+	\brief Потоковая арена для временных буферов контейнеров
+
+	Пока в потоке существует объект ScratchArenaScope, все контейнеры (DataArray, DataArray2D,
+	DataArrayMD и их наследники), создаваемые или переаллокируемые в этом потоке, получают память
+	из арены текущего потока ScratchArena::Local(). Память арены освобождается в порядке,
+	обратном выделению (как стек), и не возвращается в кучу: при повторных вызовах
+	той же процедуры с теми же размерами обращений к куче нет.
+
+	~~~~
+	void ProcessFrame(RealFunction2D_F32 &frame)
+	{
+		ScratchArenaScope scratch;
+		RealFunction2D_F32 buffer(frame); // память из арены
+		...
+	} // buffer освобождается до scratch
+	~~~~
+
+	Ограничения:
+	- внутри области следует создавать только временные массивы. Массив, переживший область,
+		остается корректным, но удерживает память арены до своего уничтожения;
+	- массив, память которого выделена из арены, должен уничтожаться в том же потоке;
+	- другие потоки (например, потоки OpenMP внутри области) области не наследуют.
+*/
+//--------------------------------------------------------------
+
+#include "DataAllocator.h"
+#include <vector>
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Стековый распределитель памяти из крупных блоков
+
+	Блоки памяти берутся у DefaultDataAllocator(). Если для нового буфера не хватает места,
+	добавляется блок вдвое большего размера; при первом выделении после того, как арена стала пустой,
+	блоки объединяются в один, так что в установившемся режиме используется один блок.
+	Deallocate() к куче не обращается.
+
+	Объект не является потокобезопасным: каждому потоку соответствует своя арена Local().
+*/
+class ScratchArena
+{
+	public:
+		ScratchArena();
+		~ScratchArena();
+
+		ScratchArena(const ScratchArena &) = delete;
+		ScratchArena &operator=(const ScratchArena &) = delete;
+
+		//! \brief Арена текущего потока
+		static ScratchArena &Local();
+
+		//! \brief Выделить size байт с выравниванием alignment
+		void *Allocate(size_t size, size_t alignment);
+		//! \brief Освободить буфер. Если он не последний из выделенных, память освобождается
+		//! вместе с последним
+		void Deallocate(void *p);
+
+		//! \brief Распределитель для SetThreadDataAllocator()
+		const data_allocator *Allocator() const { return &m_allocator; }
+
+		//! \brief Вернуть память в кучу, если в арене нет буферов
+		void Release();
+
+		//! \brief Объем памяти, полученной из кучи, байт
+		size_t Capacity() const;
+		//! \brief Число буферов, выделенных из арены и еще не освобожденных
+		size_t BufferCount() const { return m_buffers.size(); }
+		//! \brief Число обращений к куче за все время существования арены
+		size_t HeapAllocationCount() const { return m_heap_allocation_count; }
+
+	private:
+		struct chunk
+		{
+			char	*data;
+			size_t	size;
+			size_t	used;
+		};
+		struct buffer
+		{
+			void	*p;
+			size_t	chunk_index;
+			size_t	previous_used;
+			bool	released;
+		};
+
+		void *TryAllocate(size_t chunk_index, size_t size, size_t alignment);
+		void AddChunk(size_t size);
+		void FreeChunks();
+		void PopBuffer();
+
+		static void *allocate_hook(size_t size, size_t alignment, void *context);
+		static void deallocate_hook(void *p, size_t size, size_t alignment, void *context);
+
+	private:
+		std::vector<chunk>	m_chunks;
+		std::vector<buffer>	m_buffers;
+		size_t	m_heap_allocation_count;
+		data_allocator	m_allocator;
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Область, в которой контейнеры текущего потока получают память из ScratchArena::Local()
+
+	Области могут быть вложенными. Объекты, использующие арену, следует объявлять после объекта
+	области, чтобы они уничтожались раньше него.
+
+	Буфер запоминает распределитель, которым он выделен, поэтому область достаточно открыть
+	только на время выделения памяти. Так поступают, если последующий код может создавать
+	долговременные массивы (например, внутренние буферы фильтра):
+
+	~~~~
+	RealFunction2D_F32 buffer;
+	{
+		ScratchArenaScope scratch;
+		buffer.MakeCopy(frame);
+	}
+	filter.Apply(buffer, ...);
+	~~~~
+*/
+class ScratchArenaScope
+{
+	public:
+		ScratchArenaScope();
+		~ScratchArenaScope();
+
+		ScratchArenaScope(const ScratchArenaScope &) = delete;
+		ScratchArenaScope &operator=(const ScratchArenaScope &) = delete;
+
+	private:
+		const data_allocator	*m_previous_allocator;
+};
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_ScratchArena_h
@@ -0,0 +1,290 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file StridedView.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_StridedView_h
+#define XRAD__File_StridedView_h
+/*!
+	\file
+	\brief Легкие (POD) представления одно-, двух- и трехмерных данных с шагами
+
+	DataArray2D и DataArrayMD хранят для доступа к строкам и срезам вспомогательные объекты
+	DataArray, поэтому row(), col() и GetSlice() обходятся дороже, чем арифметика указателей,
+	и для временного массива-ссылки требуется создать объект-контейнер.
+
+	StridedView1D, StridedView2D и StridedView3D содержат только указатель на начальный элемент,
+	размеры и шаги (в элементах). Они не владеют данными, копируются как обычные структуры,
+	не выделяют память, и их строки, столбцы, срезы и фрагменты -- такие же представления,
+	вычисляемые на месте. Константность данных задается параметром: StridedView2D<const float>.
+
+	Представление контейнера получается функцией MakeView(), контейнер-ссылку на данные
+	представления дает UseView():
+
+	~~~~
+	RealFunction2D_F32	image(512, 512);
+	StridedView2D<float>	view = MakeView(image);
+	BiexpBlur2D(view.fragment(100, 100, 200, 200), 3, 3);
+	FFT(MakeView(spectrum).transposed(), ftForward);
+	~~~~
+
+	Время жизни представления не должно превышать времени жизни данных. Обращение
+	по индексу границы не проверяет.
+*/
+//--------------------------------------------------------------
+
+#include "DataArrayMD.h"
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace StridedViewAux
+{
+
+#if XRAD_CHECK_ITERATOR_BOUNDARIES
+template<class T>
+using element_iterator = step_iterator<T, iterator_range_checker<T, ptrdiff_t>>;
+#else
+template<class T>
+using element_iterator = step_iterator<T, iterator_checker_none<T, ptrdiff_t>>;
+#endif //XRAD_CHECK_ITERATOR_BOUNDARIES
+
+/*!
+	\brief Итератор по подчиненным представлениям (строкам двумерного, срезам трехмерного)
+
+	Разыменование возвращает представление по значению.
+*/
+template<class VIEW>
+class view_iterator
+{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef VIEW value_type;
+		typedef ptrdiff_t difference_type;
+		typedef const VIEW *pointer;
+		typedef VIEW reference;
+
+		view_iterator(): m_view(), m_step(0) {}
+		view_iterator(const VIEW &view, ptrdiff_t step): m_view(view), m_step(step) {}
+
+		VIEW	operator*() const { return m_view; }
+		const VIEW	*operator->() const { return &m_view; }
+		view_iterator	&operator++() { m_view.origin += m_step; return *this; }
+		view_iterator	operator++(int) { view_iterator result(*this); ++*this; return result; }
+		bool	operator==(const view_iterator &other) const { return m_view.origin == other.m_view.origin; }
+		bool	operator!=(const view_iterator &other) const { return m_view.origin != other.m_view.origin; }
+
+	private:
+		VIEW	m_view;
+		ptrdiff_t	m_step;
+};
+
+} // namespace StridedViewAux
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Одномерное представление: указатель, число элементов, шаг
+*/
+template<class T>
+struct StridedView1D
+{
+	typedef T value_type;
+	typedef StridedViewAux::element_iterator<T> iterator;
+
+	T	*origin;
+	size_t	count;
+	ptrdiff_t	stride;
+
+	T	*data() const { return origin; }
+	size_t	size() const { return count; }
+	ptrdiff_t	step() const { return stride; }
+	bool	empty() const { return !count; }
+
+	T	&at(size_t i) const { return origin[ptrdiff_t(i)*stride]; }
+	T	&operator[](size_t i) const { return at(i); }
+
+	iterator	begin() const { return iterator(origin, stride, count, 0); }
+	iterator	end() const { return iterator(origin, stride, count, count); }
+
+	//! \brief Элементы first..last-1
+	StridedView1D	fragment(size_t first, size_t last) const
+	{
+		return {origin + ptrdiff_t(first)*stride, last - first, stride};
+	}
+	//! \brief Элементы в обратном порядке
+	StridedView1D	reversed() const
+	{
+		return {count? origin + ptrdiff_t(count - 1)*stride: origin, count, -stride};
+	}
+	operator StridedView1D<const T>() const { return {origin, count, stride}; }
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Двумерное представление: указатель, размеры и шаги по нулевому (v) и первому (h) индексам
+
+	Итераторы begin(), end() перебирают строки.
+*/
+template<class T>
+struct StridedView2D
+{
+	typedef T value_type;
+	typedef StridedView1D<T> row_type;
+	typedef StridedViewAux::view_iterator<row_type> iterator;
+
+	T	*origin;
+	size_t	extents[2];
+	ptrdiff_t	strides[2];
+
+	T	*data() const { return origin; }
+	size_t	vsize() const { return extents[0]; }
+	size_t	hsize() const { return extents[1]; }
+	ptrdiff_t	vstep() const { return strides[0]; }
+	ptrdiff_t	hstep() const { return strides[1]; }
+	bool	empty() const { return !extents[0] || !extents[1]; }
+	//! \brief Данные строк лежат в памяти без разрывов
+	bool	rows_contiguous() const { return strides[1] == 1; }
+
+	T	&at(size_t v, size_t h) const { return origin[ptrdiff_t(v)*strides[0] + ptrdiff_t(h)*strides[1]]; }
+
+	row_type	row(size_t v) const { return {origin + ptrdiff_t(v)*strides[0], extents[1], strides[1]}; }
+	row_type	col(size_t h) const { return {origin + ptrdiff_t(h)*strides[1], extents[0], strides[0]}; }
+
+	iterator	begin() const { return iterator(row(0), strides[0]); }
+	iterator	end() const { return iterator(row(extents[0]), strides[0]); }
+
+	//! \brief Прямоугольный фрагмент [v0, v1) x [h0, h1)
+	StridedView2D	fragment(size_t v0, size_t h0, size_t v1, size_t h1) const
+	{
+		return {&at(v0, h0), {v1 - v0, h1 - h0}, {strides[0], strides[1]}};
+	}
+	//! \brief Транспонированное представление (строки становятся столбцами), данные не перемещаются
+	StridedView2D	transposed() const
+	{
+		return {origin, {extents[1], extents[0]}, {strides[1], strides[0]}};
+	}
+	operator StridedView2D<const T>() const
+	{
+		return {origin, {extents[0], extents[1]}, {strides[0], strides[1]}};
+	}
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Трехмерное представление: указатель, три размера и три шага
+
+	Итераторы begin(), end() перебирают срезы по нулевому индексу.
+*/
+template<class T>
+struct StridedView3D
+{
+	typedef T value_type;
+	typedef StridedView2D<T> slice_type;
+	typedef StridedView1D<T> row_type;
+	typedef StridedViewAux::view_iterator<slice_type> iterator;
+
+	T	*origin;
+	size_t	extents[3];
+	ptrdiff_t	strides[3];
+
+	T	*data() const { return origin; }
+	size_t	sizes(size_t dimension) const { return extents[dimension]; }
+	ptrdiff_t	steps(size_t dimension) const { return strides[dimension]; }
+	bool	empty() const { return !extents[0] || !extents[1] || !extents[2]; }
+
+	T	&at(size_t i0, size_t i1, size_t i2) const
+	{
+		return origin[ptrdiff_t(i0)*strides[0] + ptrdiff_t(i1)*strides[1] + ptrdiff_t(i2)*strides[2]];
+	}
+
+	/*!
+		\brief Срез при фиксированном индексе по измерению dimension
+
+		Оставшиеся измерения идут в прежнем порядке: slice(1, y) дает срез с индексами (z, x).
+	*/
+	slice_type	slice(size_t dimension, size_t index) const
+	{
+		size_t	d0 = dimension == 0? 1: 0, d1 = dimension == 2? 1: 2;
+		return {origin + ptrdiff_t(index)*strides[dimension], {extents[d0], extents[d1]}, {strides[d0], strides[d1]}};
+	}
+	/*!
+		\brief Линия вдоль измерения dimension
+
+		i, j -- индексы по двум другим измерениям в порядке их следования.
+	*/
+	row_type	line(size_t dimension, size_t i, size_t j) const
+	{
+		size_t	d0 = dimension == 0? 1: 0, d1 = dimension == 2? 1: 2;
+		return {origin + ptrdiff_t(i)*strides[d0] + ptrdiff_t(j)*strides[d1], extents[dimension], strides[dimension]};
+	}
+
+	iterator	begin() const { return iterator(slice(0, 0), strides[0]); }
+	iterator	end() const { return iterator(slice(0, extents[0]), strides[0]); }
+
+	//! \brief Фрагмент [p0, p1) по каждому измерению
+	StridedView3D	fragment(const index_vector &p0, const index_vector &p1) const
+	{
+		return {&at(p0[0], p0[1], p0[2]), {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]},
+				{strides[0], strides[1], strides[2]}};
+	}
+	operator StridedView3D<const T>() const
+	{
+		return {origin, {extents[0], extents[1], extents[2]}, {strides[0], strides[1], strides[2]}};
+	}
+};
+
+//--------------------------------------------------------------
+
+//! \name Представления контейнеров
+//! Представление ссылается на данные контейнера и действительно, пока данные не перемещены
+//! (до realloc() или разрушения контейнера). Для DataArrayMD требуется три измерения.
+//! @{
+template<class T>
+StridedView1D<T>	MakeView(DataArray<T> &array);
+template<class T>
+StridedView1D<const T>	MakeView(const DataArray<T> &array);
+template<class RT>
+StridedView2D<typename RT::value_type>	MakeView(DataArray2D<RT> &array);
+template<class RT>
+StridedView2D<const typename RT::value_type>	MakeView(const DataArray2D<RT> &array);
+template<class A2DT>
+StridedView3D<typename A2DT::value_type>	MakeView(DataArrayMD<A2DT> &array);
+template<class A2DT>
+StridedView3D<const typename A2DT::value_type>	MakeView(const DataArrayMD<A2DT> &array);
+//! @}
+
+//! \name Контейнеры-ссылки на данные представлений
+//! Аналог UseData(): контейнер не владеет данными, память не выделяется.
+//! @{
+template<class T>
+void	UseView(DataArray<T> &array, const StridedView1D<T> &view);
+template<class RT>
+void	UseView(DataArray2D<RT> &array, const StridedView2D<typename RT::value_type> &view);
+template<class A2DT>
+void	UseView(DataArrayMD<A2DT> &array, const StridedView3D<typename A2DT::value_type> &view);
+//! @}
+
+//! \name Поэлементное копирование между представлениями одинаковых размеров
+//! @{
+template<class T, class T2>
+void	CopyView(const StridedView1D<T> &destination, const StridedView1D<T2> &source);
+template<class T, class T2>
+void	CopyView(const StridedView2D<T> &destination, const StridedView2D<T2> &source);
+template<class T, class T2>
+void	CopyView(const StridedView3D<T> &destination, const StridedView3D<T2> &source);
+//! @}
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+#include "StridedView.hh"
+
+//--------------------------------------------------------------
+#endif // XRAD__File_StridedView_h
@@ -0,0 +1,161 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file StridedView.hh
+//--------------------------------------------------------------
+#ifndef XRAD__File_StridedView_hh
+#define XRAD__File_StridedView_hh
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace StridedViewAux
+{
+
+inline void	check_sizes(bool sizes_equal, const char *function_name)
+{
+	if(!sizes_equal)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("%s: view sizes differ.", EnsureType<const char*>(function_name)));
+	}
+}
+
+template<class A2DT>
+void	check_view_dimensions(const DataArrayMD<A2DT> &array)
+{
+	if(array.n_dimensions() != 3)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("MakeView(DataArrayMD): 3 dimensions expected, got %zu.",
+				EnsureType<size_t>(array.n_dimensions())));
+	}
+}
+
+} // namespace StridedViewAux
+
+//--------------------------------------------------------------
+
+template<class T>
+StridedView1D<T>	MakeView(DataArray<T> &array)
+{
+	// data() допустим только для сплошных данных
+	return {array.empty()? nullptr: &array.at(0), array.size(), array.step()};
+}
+
+template<class T>
+StridedView1D<const T>	MakeView(const DataArray<T> &array)
+{
+	// data() допустим только для сплошных данных
+	return {array.empty()? nullptr: &array.at(0), array.size(), array.step()};
+}
+
+template<class RT>
+StridedView2D<typename RT::value_type>	MakeView(DataArray2D<RT> &array)
+{
+	if(array.empty())
+		return {nullptr, {array.vsize(), array.hsize()}, {0, 0}};
+	return {&array.at(0, 0), {array.vsize(), array.hsize()}, {array.vstep_raw(), array.hstep_raw()}};
+}
+
+template<class RT>
+StridedView2D<const typename RT::value_type>	MakeView(const DataArray2D<RT> &array)
+{
+	if(array.empty())
+		return {nullptr, {array.vsize(), array.hsize()}, {0, 0}};
+	return {&array.at(0, 0), {array.vsize(), array.hsize()}, {array.vstep_raw(), array.hstep_raw()}};
+}
+
+template<class A2DT>
+StridedView3D<typename A2DT::value_type>	MakeView(DataArrayMD<A2DT> &array)
+{
+	StridedViewAux::check_view_dimensions(array);
+	if(array.empty())
+		return {nullptr, {array.sizes(0), array.sizes(1), array.sizes(2)}, {0, 0, 0}};
+	return {&array.at({0, 0, 0}), {array.sizes(0), array.sizes(1), array.sizes(2)},
+			{array.steps_raw(0), array.steps_raw(1), array.steps_raw(2)}};
+}
+
+template<class A2DT>
+StridedView3D<const typename A2DT::value_type>	MakeView(const DataArrayMD<A2DT> &array)
+{
+	StridedViewAux::check_view_dimensions(array);
+	if(array.empty())
+		return {nullptr, {array.sizes(0), array.sizes(1), array.sizes(2)}, {0, 0, 0}};
+	return {&array.at({0, 0, 0}), {array.sizes(0), array.sizes(1), array.sizes(2)},
+			{array.steps_raw(0), array.steps_raw(1), array.steps_raw(2)}};
+}
+
+//--------------------------------------------------------------
+
+template<class T>
+void	UseView(DataArray<T> &array, const StridedView1D<T> &view)
+{
+	array.UseData(view.origin, view.count, view.stride);
+}
+
+template<class RT>
+void	UseView(DataArray2D<RT> &array, const StridedView2D<typename RT::value_type> &view)
+{
+	array.UseData(view.origin, view.extents[0], view.extents[1], view.strides[0], view.strides[1]);
+}
+
+template<class A2DT>
+void	UseView(DataArrayMD<A2DT> &array, const StridedView3D<typename A2DT::value_type> &view)
+{
+	if(view.strides[0] < 0 || view.strides[1] < 0 || view.strides[2] < 0)
+	{
+		// См. DataArrayMD::UseData(): отрицательные шаги не поддерживаются
+		ForceDebugBreak();
+		throw invalid_argument("UseView(DataArrayMD): negative view steps are not supported.");
+	}
+	offset_vector	steps(3);
+	std::copy(view.strides, view.strides + 3, steps.begin());
+	array.UseData(view.origin, {view.extents[0], view.extents[1], view.extents[2]}, steps);
+}
+
+//--------------------------------------------------------------
+
+template<class T, class T2>
+void	CopyView(const StridedView1D<T> &destination, const StridedView1D<T2> &source)
+{
+	StridedViewAux::check_sizes(destination.count == source.count, "CopyView");
+	T	*d = destination.origin;
+	const T2	*s = source.origin;
+	if(destination.stride == 1 && source.stride == 1)
+	{
+		std::copy(s, s + source.count, d);
+		return;
+	}
+	for(size_t i = 0; i < source.count; ++i, d += destination.stride, s += source.stride)
+		*d = *s;
+}
+
+template<class T, class T2>
+void	CopyView(const StridedView2D<T> &destination, const StridedView2D<T2> &source)
+{
+	StridedViewAux::check_sizes(destination.extents[0] == source.extents[0] &&
+			destination.extents[1] == source.extents[1], "CopyView");
+	for(size_t i = 0; i < source.extents[0]; ++i)
+		CopyView(destination.row(i), source.row(i));
+}
+
+template<class T, class T2>
+void	CopyView(const StridedView3D<T> &destination, const StridedView3D<T2> &source)
+{
+	StridedViewAux::check_sizes(destination.extents[0] == source.extents[0] &&
+			destination.extents[1] == source.extents[1] &&
+			destination.extents[2] == source.extents[2], "CopyView");
+	for(size_t i = 0; i < source.extents[0]; ++i)
+		CopyView(destination.slice(0, i), source.slice(0, i));
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_StridedView_hh
@@ -0,0 +1,83 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file TransposeCopy.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_TransposeCopy_h
+#define XRAD__File_TransposeCopy_h
+/*!
+	\file
+	\brief Транспонирование и перестановка измерений с физическим переносом данных
+
+	DataArray2D::transpose() и DataArrayMD::reorder_dimensions() меняют только шаги:
+	после них строки результата идут в памяти с шагом в строку (срез) исходного массива,
+	и каждый построчный проход по ним читает память с большим шагом.
+
+	transpose_copy() и permute_copy() переносят данные в новый массив с плотным построчным
+	размещением. Копирование выполняется рекурсивным делением на блоки (cache-oblivious),
+	пока блок источника и блок приемника не поместятся в кэш L1. Блоки со строками
+	с шагом 1 транспонируются в регистрах (см. TransposeSIMD.h) для элементов размером
+	2, 4 и 8 байт (int16, float, int32, double, complexF32 и т.п.). При omp == e_use_omp
+	большие массивы делятся между потоками полосами.
+
+	~~~~
+	RealFunction2D_F32	transposed;
+	transpose_copy(transposed, image, e_use_omp);	// transposed.at(j, i) == image.at(i, j)
+
+	RealFunctionMD_F32	zxy;
+	permute_copy(zxy, volume, {slice_mask(1), slice_mask(2), slice_mask(0)});
+	~~~~
+
+	Приемник и источник не должны ссылаться на общие данные.
+*/
+//--------------------------------------------------------------
+
+#include "StridedView.h"
+#include "TransposeSIMD.h"
+#include <vector>
+#include <algorithm>
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Транспонирование представления: destination.at(j, i) = source.at(i, j)
+
+	Размеры destination должны быть source.hsize() x source.vsize().
+*/
+template<class T, class T2>
+void	transpose_copy(const StridedView2D<T> &destination, const StridedView2D<T2> &source,
+		omp_usage_t omp = e_dont_use_omp);
+
+/*!
+	\brief Транспонированная копия двумерного массива
+
+	Размер result при необходимости изменяется на original.hsize() x original.vsize().
+*/
+template<class RT, class RT2>
+void	transpose_copy(DataArray2D<RT> &result, const DataArray2D<RT2> &original,
+		omp_usage_t omp = e_dont_use_omp);
+
+/*!
+	\brief Копия многомерного массива с переставленными измерениями
+
+	Перестановка order задается так же, как в DataArrayMD::reorder_dimensions().
+	Результат совпадает с MakeCopy() от массива-ссылки на original, к которому применена
+	reorder_dimensions(order), но его данные размещены построчно. Как и в MakeCopy(),
+	выполняется result.realloc().
+*/
+template<class A2DT, class A2DT2>
+void	permute_copy(DataArrayMD<A2DT> &result, const DataArrayMD<A2DT2> &original, const index_vector &order,
+		omp_usage_t omp = e_dont_use_omp);
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+#include "TransposeCopy.hh"
+
+//--------------------------------------------------------------
+#endif // XRAD__File_TransposeCopy_h
@@ -0,0 +1,273 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file TransposeCopy.hh
+//--------------------------------------------------------------
+#ifndef XRAD__File_TransposeCopy_hh
+#define XRAD__File_TransposeCopy_hh
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace TransposeCopyAux
+{
+
+/*!
+	\brief Наибольшая сторона блока, копируемого без дальнейшего деления
+
+	Блок источника и блок приемника вместе занимают не более 32 КБ.
+*/
+template<class T>
+constexpr size_t	leaf_size()
+{
+	return sizeof(T) <= 4? 64: 32;
+}
+
+//! \brief Ширина полосы, которую получает один поток. Кратна leaf_size()
+constexpr size_t	parallel_band_size = 128;
+
+//! \brief Точка деления n пополам, кратная размеру регистрового блока (8)
+inline size_t	split_point(size_t n)
+{
+	return ((n/2 + 7)/8)*8;
+}
+
+//! \brief Векторизованное ядро для копирования T2 -> T или nullptr
+template<class T, class T2>
+TransposeSIMD::transpose_function	simd_kernel()
+{
+	if constexpr (std::is_same<std::remove_const_t<T2>, T>::value && std::is_trivially_copyable<T>::value)
+	{
+		const TransposeSIMD::Kernels	*kernels = TransposeSIMD::ActiveKernels();
+		return kernels? kernels->transpose(sizeof(T)): nullptr;
+	}
+	else
+	{
+		return nullptr;
+	}
+}
+
+template<class T, class T2>
+void	transpose_leaf(const StridedView2D<T> &destination, const StridedView2D<T2> &source,
+		TransposeSIMD::transpose_function kernel)
+{
+	if(kernel && source.hstep() == 1 && destination.hstep() == 1)
+	{
+		kernel(source.data(), source.vstep(), destination.data(), destination.vstep(), source.vsize(), source.hsize());
+		return;
+	}
+	for(size_t i = 0; i < source.vsize(); ++i)
+	{
+		auto	row = source.row(i);
+		auto	column = destination.col(i);
+		for(size_t j = 0; j < row.size(); ++j)
+			column[j] = row[j];
+	}
+}
+
+/*!
+	\brief Деление большей стороны пополам до блоков не больше leaf_size()
+
+	Деление не зависит от размеров кэша: на каждом уровне иерархии памяти найдется уровень
+	рекурсии, блоки которого в нем помещаются.
+*/
+template<class T, class T2>
+void	transpose_recursive(const StridedView2D<T> &destination, const StridedView2D<T2> &source,
+		TransposeSIMD::transpose_function kernel)
+{
+	const size_t	rows = source.vsize(), columns = source.hsize();
+	constexpr size_t	leaf = leaf_size<T>();
+	if(rows <= leaf && columns <= leaf)
+	{
+		transpose_leaf(destination, source, kernel);
+	}
+	else if(rows >= columns)
+	{
+		const size_t	half = split_point(rows);
+		transpose_recursive(destination.fragment(0, 0, columns, half), source.fragment(0, 0, half, columns), kernel);
+		transpose_recursive(destination.fragment(0, half, columns, rows), source.fragment(half, 0, rows, columns), kernel);
+	}
+	else
+	{
+		const size_t	half = split_point(columns);
+		transpose_recursive(destination.fragment(0, 0, half, rows), source.fragment(0, 0, rows, half), kernel);
+		transpose_recursive(destination.fragment(half, 0, columns, rows), source.fragment(0, half, rows, columns), kernel);
+	}
+}
+
+/*!
+	\brief Вызов f(dst, src) для каждой линии (при fast == true) или плоскости
+	многомерной перестановки
+
+	Перебираются все сочетания индексов по измерениям, кроме inner (одного или двух).
+	Указатели сдвигаются по шагам destination_steps и source_steps.
+*/
+template<class T, class T2, class F>
+void	for_each_outer_index(T *destination, const offset_vector &destination_steps,
+		T2 *source, const offset_vector &source_steps,
+		const index_vector &sizes, const std::vector<size_t> &inner, omp_usage_t omp, const F &f)
+{
+	std::vector<size_t>	outer_dimensions, outer_sizes;
+	for(size_t d = 0; d < sizes.size(); ++d)
+	{
+		if(std::find(inner.begin(), inner.end(), d) == inner.end())
+		{
+			outer_dimensions.push_back(d);
+			outer_sizes.push_back(sizes[d]);
+		}
+	}
+	size_t	count = 1;
+	for(auto s: outer_sizes)
+		count *= s;
+	BAI_OMP_aux::for_each_index(count, omp, "permute_copy", [&](size_t n)
+	{
+		T	*d = destination;
+		T2	*s = source;
+		for(size_t k = outer_dimensions.size(); k-- > 0;)
+		{
+			const size_t	index = n%outer_sizes[k];
+			n /= outer_sizes[k];
+			d += ptrdiff_t(index)*destination_steps[outer_dimensions[k]];
+			s += ptrdiff_t(index)*source_steps[outer_dimensions[k]];
+		}
+		f(d, s);
+	});
+}
+
+//! \brief Измерение с наименьшим по модулю шагом среди измерений размера больше 1
+inline size_t	fastest_dimension(const index_vector &sizes, const offset_vector &steps)
+{
+	size_t	result = sizes.size() - 1;
+	for(size_t d = sizes.size(); d-- > 0;)
+	{
+		if(sizes[d] > 1 && std::abs(steps[d]) < std::abs(steps[result]))
+			result = d;
+	}
+	return result;
+}
+
+} // namespace TransposeCopyAux
+
+//--------------------------------------------------------------
+
+template<class T, class T2>
+void	transpose_copy(const StridedView2D<T> &destination, const StridedView2D<T2> &source, omp_usage_t omp)
+{
+	if(destination.vsize() != source.hsize() || destination.hsize() != source.vsize())
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("transpose_copy: destination sizes %zu x %zu do not match source sizes %zu x %zu.",
+				EnsureType<size_t>(destination.vsize()), EnsureType<size_t>(destination.hsize()),
+				EnsureType<size_t>(source.vsize()), EnsureType<size_t>(source.hsize())));
+	}
+	if(source.empty())
+		return;
+
+	using namespace TransposeCopyAux;
+	const auto	kernel = simd_kernel<T, T2>();
+	const size_t	rows = source.vsize(), columns = source.hsize();
+	constexpr size_t	band = parallel_band_size;
+	if(omp != e_use_omp || rows*columns < parallel_interactions_min_size)
+	{
+		transpose_recursive(destination, source, kernel);
+	}
+	else if(rows >= columns)
+	{
+		BAI_OMP_aux::for_each_index((rows + band - 1)/band, omp, "transpose_copy", [&](size_t n)
+		{
+			const size_t	first = n*band, last = min(first + band, rows);
+			transpose_recursive(destination.fragment(0, first, columns, last), source.fragment(first, 0, last, columns), kernel);
+		});
+	}
+	else
+	{
+		BAI_OMP_aux::for_each_index((columns + band - 1)/band, omp, "transpose_copy", [&](size_t n)
+		{
+			const size_t	first = n*band, last = min(first + band, columns);
+			transpose_recursive(destination.fragment(first, 0, last, rows), source.fragment(0, first, rows, last), kernel);
+		});
+	}
+}
+
+template<class RT, class RT2>
+void	transpose_copy(DataArray2D<RT> &result, const DataArray2D<RT2> &original, omp_usage_t omp)
+{
+	if(result.vsize() != original.hsize() || result.hsize() != original.vsize())
+		result.realloc(original.hsize(), original.vsize());
+	transpose_copy(MakeView(result), MakeView(original), omp);
+}
+
+//--------------------------------------------------------------
+
+template<class A2DT, class A2DT2>
+void	permute_copy(DataArrayMD<A2DT> &result, const DataArrayMD<A2DT2> &original, const index_vector &order,
+		omp_usage_t omp)
+{
+	using namespace TransposeCopyAux;
+	using value_type = typename A2DT::value_type;
+	using source_value_type = const typename A2DT2::value_type;
+
+	// Массив-ссылка с переставленными шагами; reorder_dimensions() проверяет order.
+	// Ссылка используется только для чтения (UseData() от константного массива
+	// для DataArrayMD не реализована)
+	DataArrayMD<A2DT2>	reordered;
+	reordered.UseData(const_cast<DataArrayMD<A2DT2>&>(original));
+	reordered.reorder_dimensions(order);
+
+	result.realloc(reordered.sizes());
+	if(result.empty())
+		return;
+
+	const size_t	n_dimensions = result.n_dimensions();
+	const index_vector	&sizes = result.sizes();
+	index_vector	zero(n_dimensions);
+	zero.fill(0);
+	const offset_vector	destination_steps = result.steps_raw(), source_steps = reordered.steps_raw();
+	value_type	*destination = &result.at(zero);
+	source_value_type	*source = &reordered.at(zero);
+
+	const size_t	destination_fast = fastest_dimension(sizes, destination_steps);
+	const size_t	source_fast = fastest_dimension(sizes, source_steps);
+
+	if(destination_fast == source_fast)
+	{
+		// Порядок элементов в строках совпадает: копирование линий
+		const size_t	fast = destination_fast, line_size = sizes[fast];
+		for_each_outer_index(destination, destination_steps, source, source_steps, sizes, {fast}, omp,
+				[&](value_type *d, source_value_type *s)
+				{
+					CopyView(StridedView1D<value_type>{d, line_size, destination_steps[fast]},
+							StridedView1D<source_value_type>{s, line_size, source_steps[fast]});
+				});
+		return;
+	}
+
+	// Плоскость (destination_fast, source_fast) транспонируется: строки источника идут
+	// по source_fast, строки приемника -- по destination_fast
+	const size_t	v = destination_fast, h = source_fast;
+	size_t	outer_count = 1;
+	for(size_t d = 0; d < n_dimensions; ++d)
+	{
+		if(d != v && d != h)
+			outer_count *= sizes[d];
+	}
+	const omp_usage_t	plane_omp = outer_count > 1? e_dont_use_omp: omp;
+	for_each_outer_index(destination, destination_steps, source, source_steps, sizes, {v, h},
+			outer_count > 1? omp: e_dont_use_omp,
+			[&](value_type *d, source_value_type *s)
+			{
+				transpose_copy(StridedView2D<value_type>{d, {sizes[h], sizes[v]}, {destination_steps[h], destination_steps[v]}},
+						StridedView2D<source_value_type>{s, {sizes[v], sizes[h]}, {source_steps[v], source_steps[h]}},
+						plane_omp);
+			});
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_TransposeCopy_hh
@@ -0,0 +1,31 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file TransposeSIMD.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "TransposeSIMD.h"
+
+XRAD_BEGIN
+
+namespace TransposeSIMD
+{
+
+//--------------------------------------------------------------
+
+const Kernels *ActiveKernels()
+{
+#ifdef XRAD_CPU_X86
+	if(ActiveSIMDInstructionSet() >= e_simd_avx2)
+		return &Kernels_AVX2();
+#endif
+	return nullptr;
+}
+
+//--------------------------------------------------------------
+
+} // namespace TransposeSIMD
+
+XRAD_END
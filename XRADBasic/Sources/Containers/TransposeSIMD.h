@@ -0,0 +1,96 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file TransposeSIMD.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_TransposeSIMD_h
+#define XRAD__File_TransposeSIMD_h
+/*!
+	\file
+	\brief Векторизованное транспонирование блоков непрерывных строк
+
+	Внутренний файл библиотеки. Используется в TransposeCopy.hh для блоков, строки которых
+	и в источнике, и в приемнике идут с шагом 1.
+
+	Ядра только перемещают данные и не зависят от типа элемента, важен лишь его размер:
+	2 байта (8x8 в регистрах SSE), 4 байта (8x8 в регистрах AVX), 8 байт (4x4 в регистрах AVX).
+
+	Реализация находится в отдельной единице трансляции TransposeSIMD_AVX2.cpp,
+	которая компилируется с ключами AVX2. Выбор выполняется во время выполнения
+	по ActiveSIMDInstructionSet().
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Sources/Core/CPUFeatures.h>
+#include <cstddef>
+
+XRAD_BEGIN
+
+namespace TransposeSIMD
+{
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Транспонирование блока rows x columns
+
+	destination[j*destination_step + i] = source[i*source_step + j] для i < rows, j < columns.
+	Шаги указываются в элементах. Области источника и приемника не должны перекрываться.
+*/
+typedef void (*transpose_function)(const void *source, ptrdiff_t source_step,
+		void *destination, ptrdiff_t destination_step, size_t rows, size_t columns);
+
+//! \brief Набор ядер для одного набора инструкций
+struct Kernels
+{
+	//! \brief Набор инструкций, для которого скомпилированы ядра
+	simd_instruction_set_t	instruction_set;
+
+	//! \name Транспонирование для элементов размером 2, 4, 8 байт
+	//! @{
+	transpose_function	transpose_16;
+	transpose_function	transpose_32;
+	transpose_function	transpose_64;
+	//! @}
+
+	//! \brief Ядро для элемента размером element_size байт или nullptr
+	transpose_function	transpose(size_t element_size) const
+	{
+		switch(element_size)
+		{
+			case 2: return transpose_16;
+			case 4: return transpose_32;
+			case 8: return transpose_64;
+		}
+		return nullptr;
+	}
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Ядра для текущего набора инструкций ActiveSIMDInstructionSet()
+
+	\return nullptr, если векторизованные ядра недоступны (используется скалярный код)
+*/
+const Kernels *ActiveKernels();
+
+//--------------------------------------------------------------
+
+#ifdef XRAD_CPU_X86
+
+//! \brief Реализация AVX2. Вызывать только при DetectedSIMDInstructionSet() >= e_simd_avx2
+const Kernels &Kernels_AVX2();
+
+#endif // XRAD_CPU_X86
+
+//--------------------------------------------------------------
+
+} // namespace TransposeSIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_TransposeSIMD_h
@@ -0,0 +1,192 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file TransposeSIMD_AVX2.cpp
+//--------------------------------------------------------------
+// Файл компилируется с ключами AVX2 (см. CMakeLists.txt, XRADBasic.vcxproj)
+// без предкомпилированного заголовка: код из других файлов не должен компилироваться с этими ключами.
+// Функции этого файла вызываются только при DetectedSIMDInstructionSet() >= e_simd_avx2.
+// Используются только перестановки (unpack, shuffle, permute): значения копируются побитово,
+// поэтому регистры с плавающей точкой подходят для данных любого типа.
+#include "TransposeSIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <immintrin.h>
+#include <cstring>
+
+XRAD_BEGIN
+
+namespace TransposeSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Блок 8x8 элементов по 2 байта
+struct tile_16
+{
+	static constexpr size_t	element_size = 2;
+	static constexpr size_t	size = 8;
+
+	static void run(const char *s, ptrdiff_t ss, char *d, ptrdiff_t ds)
+	{
+		__m128i	r0 = _mm_loadu_si128((const __m128i*)(s));
+		__m128i	r1 = _mm_loadu_si128((const __m128i*)(s + ss));
+		__m128i	r2 = _mm_loadu_si128((const __m128i*)(s + 2*ss));
+		__m128i	r3 = _mm_loadu_si128((const __m128i*)(s + 3*ss));
+		__m128i	r4 = _mm_loadu_si128((const __m128i*)(s + 4*ss));
+		__m128i	r5 = _mm_loadu_si128((const __m128i*)(s + 5*ss));
+		__m128i	r6 = _mm_loadu_si128((const __m128i*)(s + 6*ss));
+		__m128i	r7 = _mm_loadu_si128((const __m128i*)(s + 7*ss));
+
+		__m128i	a0 = _mm_unpacklo_epi16(r0, r1), a1 = _mm_unpackhi_epi16(r0, r1);
+		__m128i	a2 = _mm_unpacklo_epi16(r2, r3), a3 = _mm_unpackhi_epi16(r2, r3);
+		__m128i	a4 = _mm_unpacklo_epi16(r4, r5), a5 = _mm_unpackhi_epi16(r4, r5);
+		__m128i	a6 = _mm_unpacklo_epi16(r6, r7), a7 = _mm_unpackhi_epi16(r6, r7);
+
+		__m128i	b0 = _mm_unpacklo_epi32(a0, a2), b1 = _mm_unpackhi_epi32(a0, a2);
+		__m128i	b2 = _mm_unpacklo_epi32(a1, a3), b3 = _mm_unpackhi_epi32(a1, a3);
+		__m128i	b4 = _mm_unpacklo_epi32(a4, a6), b5 = _mm_unpackhi_epi32(a4, a6);
+		__m128i	b6 = _mm_unpacklo_epi32(a5, a7), b7 = _mm_unpackhi_epi32(a5, a7);
+
+		_mm_storeu_si128((__m128i*)(d), _mm_unpacklo_epi64(b0, b4));
+		_mm_storeu_si128((__m128i*)(d + ds), _mm_unpackhi_epi64(b0, b4));
+		_mm_storeu_si128((__m128i*)(d + 2*ds), _mm_unpacklo_epi64(b1, b5));
+		_mm_storeu_si128((__m128i*)(d + 3*ds), _mm_unpackhi_epi64(b1, b5));
+		_mm_storeu_si128((__m128i*)(d + 4*ds), _mm_unpacklo_epi64(b2, b6));
+		_mm_storeu_si128((__m128i*)(d + 5*ds), _mm_unpackhi_epi64(b2, b6));
+		_mm_storeu_si128((__m128i*)(d + 6*ds), _mm_unpacklo_epi64(b3, b7));
+		_mm_storeu_si128((__m128i*)(d + 7*ds), _mm_unpackhi_epi64(b3, b7));
+	}
+};
+
+//! \brief Блок 8x8 элементов по 4 байта
+struct tile_32
+{
+	static constexpr size_t	element_size = 4;
+	static constexpr size_t	size = 8;
+
+	static void run(const char *s, ptrdiff_t ss, char *d, ptrdiff_t ds)
+	{
+		__m256	r0 = _mm256_loadu_ps((const float*)(s));
+		__m256	r1 = _mm256_loadu_ps((const float*)(s + ss));
+		__m256	r2 = _mm256_loadu_ps((const float*)(s + 2*ss));
+		__m256	r3 = _mm256_loadu_ps((const float*)(s + 3*ss));
+		__m256	r4 = _mm256_loadu_ps((const float*)(s + 4*ss));
+		__m256	r5 = _mm256_loadu_ps((const float*)(s + 5*ss));
+		__m256	r6 = _mm256_loadu_ps((const float*)(s + 6*ss));
+		__m256	r7 = _mm256_loadu_ps((const float*)(s + 7*ss));
+
+		__m256	t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+		__m256	t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+		__m256	t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+		__m256	t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+
+		__m256	u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256	u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256	u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256	u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256	u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256	u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256	u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256	u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		_mm256_storeu_ps((float*)(d), _mm256_permute2f128_ps(u0, u4, 0x20));
+		_mm256_storeu_ps((float*)(d + ds), _mm256_permute2f128_ps(u1, u5, 0x20));
+		_mm256_storeu_ps((float*)(d + 2*ds), _mm256_permute2f128_ps(u2, u6, 0x20));
+		_mm256_storeu_ps((float*)(d + 3*ds), _mm256_permute2f128_ps(u3, u7, 0x20));
+		_mm256_storeu_ps((float*)(d + 4*ds), _mm256_permute2f128_ps(u0, u4, 0x31));
+		_mm256_storeu_ps((float*)(d + 5*ds), _mm256_permute2f128_ps(u1, u5, 0x31));
+		_mm256_storeu_ps((float*)(d + 6*ds), _mm256_permute2f128_ps(u2, u6, 0x31));
+		_mm256_storeu_ps((float*)(d + 7*ds), _mm256_permute2f128_ps(u3, u7, 0x31));
+	}
+};
+
+//! \brief Блок 4x4 элементов по 8 байт
+struct tile_64
+{
+	static constexpr size_t	element_size = 8;
+	static constexpr size_t	size = 4;
+
+	static void run(const char *s, ptrdiff_t ss, char *d, ptrdiff_t ds)
+	{
+		__m256d	r0 = _mm256_loadu_pd((const double*)(s));
+		__m256d	r1 = _mm256_loadu_pd((const double*)(s + ss));
+		__m256d	r2 = _mm256_loadu_pd((const double*)(s + 2*ss));
+		__m256d	r3 = _mm256_loadu_pd((const double*)(s + 3*ss));
+
+		__m256d	t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+		__m256d	t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+
+		_mm256_storeu_pd((double*)(d), _mm256_permute2f128_pd(t0, t2, 0x20));
+		_mm256_storeu_pd((double*)(d + ds), _mm256_permute2f128_pd(t1, t3, 0x20));
+		_mm256_storeu_pd((double*)(d + 2*ds), _mm256_permute2f128_pd(t0, t2, 0x31));
+		_mm256_storeu_pd((double*)(d + 3*ds), _mm256_permute2f128_pd(t1, t3, 0x31));
+	}
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Транспонирование блоками Tile::size x Tile::size, края -- поэлементно
+
+	Шаги переводятся в байты; элементы краев копируются через memcpy, чтобы не зависеть
+	от типа элемента.
+*/
+template<class Tile>
+void transpose_loop(const void *source, ptrdiff_t source_step,
+		void *destination, ptrdiff_t destination_step, size_t rows, size_t columns)
+{
+	constexpr size_t	es = Tile::element_size;
+	constexpr size_t	n = Tile::size;
+	const char	*s = static_cast<const char*>(source);
+	char	*d = static_cast<char*>(destination);
+	const ptrdiff_t	ss = source_step*ptrdiff_t(es), ds = destination_step*ptrdiff_t(es);
+
+	size_t	i = 0;
+	for(; i + n <= rows; i += n)
+	{
+		size_t	j = 0;
+		for(; j + n <= columns; j += n)
+			Tile::run(s + ptrdiff_t(i)*ss + ptrdiff_t(j*es), ss, d + ptrdiff_t(j)*ds + ptrdiff_t(i*es), ds);
+		for(; j < columns; ++j)
+		{
+			for(size_t k = 0; k < n; ++k)
+				memcpy(d + ptrdiff_t(j)*ds + ptrdiff_t((i + k)*es), s + ptrdiff_t(i + k)*ss + ptrdiff_t(j*es), es);
+		}
+	}
+	for(; i < rows; ++i)
+	{
+		for(size_t j = 0; j < columns; ++j)
+			memcpy(d + ptrdiff_t(j)*ds + ptrdiff_t(i*es), s + ptrdiff_t(i)*ss + ptrdiff_t(j*es), es);
+	}
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels &Kernels_AVX2()
+{
+	static const Kernels	kernels =
+	{
+		e_simd_avx2,
+		transpose_loop<tile_16>,
+		transpose_loop<tile_32>,
+		transpose_loop<tile_64>
+	};
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace TransposeSIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
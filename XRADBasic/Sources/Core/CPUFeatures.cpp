@@ -0,0 +1,147 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file CPUFeatures.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "CPUFeatures.h"
+#include <atomic>
+
+#ifdef XRAD_CPU_X86
+	#if defined(XRAD_COMPILER_MSC)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+#ifdef XRAD_CPU_X86
+
+//! \brief Регистры EAX, EBX, ECX, EDX, возвращаемые инструкцией CPUID
+struct cpuid_registers
+{
+	unsigned int	eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+cpuid_registers	cpuid(unsigned int leaf, unsigned int subleaf)
+{
+	cpuid_registers	result;
+#if defined(XRAD_COMPILER_MSC)
+	int	registers[4];
+	__cpuidex(registers, int(leaf), int(subleaf));
+	result.eax = registers[0];
+	result.ebx = registers[1];
+	result.ecx = registers[2];
+	result.edx = registers[3];
+#else
+	if(leaf > __get_cpuid_max(leaf & 0x80000000u, nullptr))
+		return result;
+	__cpuid_count(leaf, subleaf, result.eax, result.ebx, result.ecx, result.edx);
+#endif
+	return result;
+}
+
+//! \brief Регистр XCR0: какие наборы регистров сохраняет ОС при переключении контекста
+unsigned long long	xgetbv0()
+{
+#if defined(XRAD_COMPILER_MSC)
+	return _xgetbv(0);
+#else
+	unsigned int	eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+simd_instruction_set_t	detect_simd_instruction_set()
+{
+	const cpuid_registers	features = cpuid(1, 0);
+	const bool	sse2 = (features.edx >> 26) & 1;
+	if(!sse2)
+		return e_simd_none;
+
+	const bool	osxsave = (features.ecx >> 27) & 1;
+	const bool	avx = (features.ecx >> 28) & 1;
+	const bool	fma = (features.ecx >> 12) & 1;
+	if(!osxsave || !avx || !fma || cpuid(0, 0).eax < 7)
+		return e_simd_sse2;
+
+	// ОС должна сохранять регистры XMM и YMM (биты 1, 2),
+	// для AVX-512 также регистры маски и ZMM (биты 5, 6, 7)
+	const unsigned long long	xcr0 = xgetbv0();
+	if((xcr0 & 0x06) != 0x06)
+		return e_simd_sse2;
+
+	const cpuid_registers	extended_features = cpuid(7, 0);
+	const bool	avx2 = (extended_features.ebx >> 5) & 1;
+	const bool	avx512f = (extended_features.ebx >> 16) & 1;
+	if(!avx2)
+		return e_simd_sse2;
+	if(!avx512f || (xcr0 & 0xE6) != 0xE6)
+		return e_simd_avx2;
+	return e_simd_avx512;
+}
+
+#else
+
+simd_instruction_set_t	detect_simd_instruction_set()
+{
+	return e_simd_none;
+}
+
+#endif // XRAD_CPU_X86
+
+std::atomic<simd_instruction_set_t>	simd_instruction_set_limit(e_simd_avx512);
+
+} // namespace
+
+//--------------------------------------------------------------
+
+simd_instruction_set_t DetectedSIMDInstructionSet()
+{
+	static const simd_instruction_set_t	detected = detect_simd_instruction_set();
+	return detected;
+}
+
+//--------------------------------------------------------------
+
+simd_instruction_set_t ActiveSIMDInstructionSet()
+{
+	const simd_instruction_set_t	detected = DetectedSIMDInstructionSet();
+	const simd_instruction_set_t	limit = simd_instruction_set_limit.load(std::memory_order_relaxed);
+	return detected < limit ? detected : limit;
+}
+
+//--------------------------------------------------------------
+
+void SetSIMDInstructionSetLimit(simd_instruction_set_t limit)
+{
+	simd_instruction_set_limit.store(limit, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+
+const char *SIMDInstructionSetName(simd_instruction_set_t instruction_set)
+{
+	switch(instruction_set)
+	{
+		case e_simd_none: return "none";
+		case e_simd_sse2: return "SSE2";
+		case e_simd_avx2: return "AVX2";
+		case e_simd_avx512: return "AVX-512";
+	}
+	return "unknown";
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
@@ -0,0 +1,77 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file CPUFeatures.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_CPUFeatures_h
+#define XRAD__File_CPUFeatures_h
+/*!
+	\file
+	\brief Определение наборов SIMD-инструкций процессора во время выполнения
+
+	Используется для выбора векторизованных реализаций алгоритмов. Векторизованные реализации
+	компилируются в отдельных единицах трансляции с соответствующими ключами компилятора
+	и вызываются только тогда, когда процессор и ОС поддерживают нужный набор инструкций.
+*/
+//--------------------------------------------------------------
+
+#include "Config.h"
+#include "BasicMacros.h"
+
+//! \brief Определено, если целевая платформа x86 или x86-64 (доступны SSE2 и выше)
+#if defined(XRAD_COMPILER_MSC)
+	#if defined(_M_X64) || defined(_M_IX86)
+		#define XRAD_CPU_X86
+	#endif
+#elif defined(__x86_64__) || defined(__i386__)
+	#define XRAD_CPU_X86
+#endif
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Наборы SIMD-инструкций, для которых в библиотеке есть отдельные реализации
+
+	Значения упорядочены: каждый следующий набор включает предыдущие.
+*/
+enum simd_instruction_set_t
+{
+	//! \brief Скалярный код
+	e_simd_none,
+	//! \brief SSE2 (обязателен для x86-64)
+	e_simd_sse2,
+	//! \brief AVX2 и FMA3
+	e_simd_avx2,
+	//! \brief AVX-512F
+	e_simd_avx512
+};
+
+//! \brief Наиболее полный набор инструкций, поддерживаемый процессором и ОС.
+//! Определяется один раз при первом обращении
+simd_instruction_set_t DetectedSIMDInstructionSet();
+
+//! \brief Набор инструкций, который следует использовать: DetectedSIMDInstructionSet(),
+//! ограниченный значением SetSIMDInstructionSetLimit()
+simd_instruction_set_t ActiveSIMDInstructionSet();
+
+/*!
+	\brief Ограничить используемый набор инструкций
+
+	Например, e_simd_none отключает векторизованные реализации. Используется для сравнения
+	результатов и производительности. Не следует вызывать во время вычислений в других потоках.
+*/
+void SetSIMDInstructionSetLimit(simd_instruction_set_t limit);
+
+//! \brief Название набора инструкций ("none", "SSE2", "AVX2", "AVX-512")
+const char *SIMDInstructionSetName(simd_instruction_set_t instruction_set);
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_CPUFeatures_h
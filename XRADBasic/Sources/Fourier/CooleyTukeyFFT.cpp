@@ -9,7 +9,8 @@
 
 #include "CooleyTukeyFFT.h"
 #include "WinogradShortFFT.h"
-#include <omp.h>
+#include <atomic>
+#include <mutex>
 
 XRAD_BEGIN
 
@@ -24,7 +25,7 @@ XRAD_USING
 //
 
 template<class T, class T2>
-Transformer<T, T2> ::Transformer(const Phasors<phasor_sample_t> *in_h) : phasors(in_h)
+Transformer<T, T2> ::Transformer() : phasors(nullptr)
 {
 	recursion_level = 0;
 }
@@ -165,7 +166,12 @@ void	Transformer<T, T2> ::FFT(fft_sample_t *array_ptr, size_t size, ftDirection
 
 	if(!recursion_level)
 	{
-		if(reorder_buffer.size() < phasors->max_fft_length()) reorder_buffer.realloc(phasors->max_fft_length());
+		if(reorder_buffer.size() < phasors->max_fft_length())
+		{
+			// Буфер преобразователя потока живет до завершения потока
+			GlobalDataAllocatorScope	persistent;
+			reorder_buffer.realloc(phasors->max_fft_length());
+		}
 	}
 
 	// выбор вариантов расщепления
@@ -229,39 +235,72 @@ void	Transformer<T, T2> ::FFT(fft_sample_t *array_ptr, size_t size, ftDirection
 	normalize_fft_result(array_ptr, size);
 }
 
+template<class T, class T2>
+void	Transformer<T, T2> ::FFT(fft_sample_t *array_ptr, size_t size, ftDirection direction,
+		const Phasors<phasor_sample_t> &in_phasors)
+{
+	phasors = &in_phasors;
+	FFT(array_ptr, size, direction);
+}
+
 //--------------------------------------------------------------
 
 template<class T, class T2>
-TransformerSet<T, T2>::TransformerSet(const Phasors<T2>	*in_phasors) : phasors(in_phasors)
+auto	TransformerSet<T, T2>::thread_transformer() -> transformer_t &
 {
-	size_t	n = omp_get_num_procs();
-	for(size_t i = 0; i < n; ++i)
+	// Наборов с одинаковыми параметрами шаблона может быть несколько,
+	// поэтому преобразователи потока хранятся вместе с адресом набора, которому они принадлежат.
+	// Наборы являются глобальными объектами, поэтому адрес набора однозначно его определяет.
+	thread_local std::vector<std::pair<const TransformerSet*, unique_ptr<transformer_t>>> thread_transformers;
+	for(auto &item: thread_transformers)
 	{
-		transformers.push_back(make_unique<transformer_t>(phasors));
+		if(item.first == this)
+			return *item.second;
 	}
+	thread_transformers.emplace_back(this, make_unique<transformer_t>());
+	return *thread_transformers.back().second;
 }
 
 
 template<class T, class T2>
 void	TransformerSet<T, T2>::FFT(T *data, size_t size, ftDirection direction)
 {
-	size_t	n(0);
-	while(!transformers[n]->try_lock())
-	{
-		(++n)%=transformers.size();
-	}
-	transformers[n]->FFT(data, size, direction);
-	transformers[n]->unlock();
+	thread_transformer().FFT(data, size, direction, GetPhasors(size));
 }
 
 //--------------------------------------------------------------
 
-//	преобразование по степеням 3 также возможно, для этого нужно использовать следующий объект:
-//Phasors<phasor_value_type> fft_phasors(3);
-Phasors<phasor_value_type> fft_phasors(2);
+const Phasors<phasor_value_type> &GetPhasors(size_t min_fft_length)
+{
+	// Текущая таблица читается без блокировки. Таблицы создаются и сохраняются под мьютексом
+	static std::atomic<const Phasors<phasor_value_type>*>	current_phasors(nullptr);
+	auto	*phasors = current_phasors.load(std::memory_order_acquire);
+	if(phasors && phasors->max_fft_length() >= min_fft_length)
+		return *phasors;
+
+	static std::mutex	mx;
+	static std::vector<unique_ptr<const Phasors<phasor_value_type>>>	all_phasors;
+	std::lock_guard<std::mutex>	lock(mx);
+	phasors = current_phasors.load(std::memory_order_relaxed);
+	if(phasors && phasors->max_fft_length() >= min_fft_length)
+		return *phasors;
+
+	//	преобразование по степеням 3 также возможно, для этого нужно использовать основание 3
+	const size_t	base = 2;
+	size_t	order = Phasors<phasor_value_type>::max_FFT_size(base);
+	while(size_t(pow(double(base), double(order))) < min_fft_length)
+		++order;
+	GlobalDataAllocatorScope	persistent;
+	all_phasors.push_back(make_unique<const Phasors<phasor_value_type>>(base, order));
+	phasors = all_phasors.back().get();
+	current_phasors.store(phasors, std::memory_order_release);
+	return *phasors;
+}
+
+//--------------------------------------------------------------
 
-TransformerSet<complexF32, phasor_value_type>	FTCT_F32(&fft_phasors);
-TransformerSet<complexF64, phasor_value_type>	FTCT_F64(&fft_phasors);
+TransformerSet<complexF32, phasor_value_type>	FTCT_F32;
+TransformerSet<complexF64, phasor_value_type>	FTCT_F64;
 
 //--------------------------------------------------------------
 
@@ -19,7 +19,6 @@
 #include <XRADBasic/Sources/SampleTypes/ComplexSample.h>
 #include <memory>
 #include <vector>
-#include <mutex>
 
 XRAD_BEGIN
 
@@ -34,8 +33,11 @@ using Phasors = FFTPrimitives::Phasors<T>;
 //--------------------------------------------------------------
 
 //! \brief Fourier transform Cooley-Tukey class
+//!
+//! Объект не является потокобезопасным: содержит буфер перестановки и счетчик уровня рекурсии.
+//! Для многопоточного использования см. TransformerSet.
 template<class T, class T2>
-class	Transformer : public std::mutex
+class	Transformer
 {
 	typedef T fft_sample_t;
 	typedef T2 phasor_sample_t;
@@ -44,34 +46,44 @@ private:
 
 	size_t	recursion_level;
 
-	// phasors
+	// phasors: таблица, переданная при вызове FFT верхнего уровня
 	const Phasors<phasor_sample_t> *phasors;
 	DataArray<fft_sample_t> reorder_buffer;
 
 	void	intermediate_array_reorder(fft_sample_t *array_ptr, size_t sub_size_1, size_t sub_size_2);
 	void	partial_fourier_transform(fft_sample_t *array_ptr, size_t vsize, size_t hsize, bool transposed, ftDirection direction);
 	inline void	normalize_fft_result(fft_sample_t *array_ptr, size_t size);
+	void	FFT(fft_sample_t *array_ptr, size_t size, ftDirection direction);
 
 public:
 
-	Transformer(const Phasors<phasor_sample_t> *in_h);
+	Transformer();
 	Transformer(const Transformer &) = delete;
 	Transformer &operator=(const Transformer &) = delete;
 
-	//! \brief FFT, size >= 2
-	void	FFT(fft_sample_t *array_ptr, size_t size, ftDirection direction);
+	//! \brief FFT, size >= 2. Длина size не должна превышать in_phasors.max_fft_length()
+	void	FFT(fft_sample_t *array_ptr, size_t size, ftDirection direction, const Phasors<phasor_sample_t> &in_phasors);
 };
 
 //--------------------------------------------------------------
 
+/*!
+	\brief Набор преобразователей для многопоточного вызова FFT
+
+	Каждый поток при первом вызове FFT() получает собственный Transformer (вместе с буфером перестановки),
+	поэтому вызов не требует блокировок и не зависит от числа одновременно работающих потоков.
+	Таблица множителей берется из GetPhasors(). Сам набор не содержит данных, поэтому глобальные
+	наборы FTCT_F32, FTCT_F64 не требуют действий при запуске программы.
+*/
 template<class T, class T2>
 class TransformerSet
 {
 	typedef Transformer<T, T2> transformer_t;
-	std::vector<unique_ptr<transformer_t>> transformers;
-	const Phasors<T2>	*phasors;
+
+	//! \brief Преобразователь текущего потока, создается при первом обращении
+	transformer_t	&thread_transformer();
 public:
-	TransformerSet(const Phasors<T2>	*in_phasors);
+	constexpr TransformerSet() = default;
 	TransformerSet(const TransformerSet &) = delete;
 	TransformerSet &operator=(const TransformerSet &) = delete;
 
@@ -83,7 +95,14 @@ public:
 
 typedef	complexF64 phasor_value_type;
 
-extern Phasors<phasor_value_type> fft_phasors;
+/*!
+	\brief Таблица множителей для длин 2^n <= max(min_fft_length, 65536)
+
+	Таблица создается при первом обращении. Если запрошена длина больше, чем допускает текущая
+	таблица, создается новая таблица. Прежние таблицы не удаляются: их могут использовать
+	преобразования, выполняемые в других потоках. Функция потокобезопасна.
+*/
+const Phasors<phasor_value_type> &GetPhasors(size_t min_fft_length);
 
 extern TransformerSet<complexF32, phasor_value_type>	FTCT_F32;
 extern TransformerSet<complexF64, phasor_value_type>	FTCT_F64;
@@ -9,9 +9,9 @@
 
 #include "DecompositionFFT.h"
 #include "WinogradShortFFT.h"
-#include <XRADBasic/Sources/Utils/ProcessorPoolDispatcher.h>
+#include <atomic>
 #include <cstring>
-#include <omp.h>
+#include <mutex>
 
 XRAD_BEGIN
 
@@ -121,159 +121,89 @@ namespace
 
 //--------------------------------------------------------------
 
-class FFTProcessor
-{
-	public:
-		using phasors_t = std::tuple<
-				const vector<DataArray<complexF64>>*,
-				const vector<DataArray<complexF32>>*>;
-		static constexpr size_t max_sample_size = std::max(sizeof(complexF32), sizeof(complexF64));
-		using Log = function<void (const string &)>;
-
-		FFTProcessor(size_t max_data_size,
-				phasors_t phasors,
-				const vector<DataArray<size_t>> *rev_index_tables,
-				size_t processor_id,
-				shared_ptr<Log> log = nullptr);
-		template <class complex_t>
-		void operator()(complex_t *data, size_t data_size, size_t power, ftDirection direction);
-	private:
-		phasors_t phasors;
-		const vector<DataArray<size_t>> *rev_index_tables;
-		DataArray<char> buffer;
-		size_t processor_id;
-		shared_ptr<Log> log;
-};
-
-FFTProcessor::FFTProcessor(size_t max_data_size,
-		phasors_t phasors,
-		const vector<DataArray<size_t>> *rev_index_tables,
-		size_t processor_id,
-		shared_ptr<Log> log):
-	phasors(phasors),
-	rev_index_tables(rev_index_tables),
-	processor_id(processor_id),
-	log(std::move(log))
-{
-	size_t buffer_size = max_data_size * max_sample_size;
-	buffer.realloc(buffer_size);
-}
-
-template <class complex_t>
-void FFTProcessor::operator()(complex_t *data, size_t data_size, size_t power,
-		ftDirection direction)
-{
-	if (log)
-	{
-		(*log)(ssprintf("FFTProcessor[%zu]::FFT(): id = %s begin\n",
-				EnsureType<size_t>(processor_id),
-				EnsureType<const char*>(DebugThreadIdStr().c_str())));
-	}
-
-	DecompositionFFT(data, data_size, direction,
-			(*get<const vector<DataArray<complex_t>>*>(phasors))[power].data(),
-			reinterpret_cast<complex_t*>(buffer.data()),
-			(*rev_index_tables)[power].data());
-
-	if (log)
-	{
-		(*log)(ssprintf("FFTProcessor[%zu]::FFT(): id = %s end\n",
-				EnsureType<size_t>(processor_id),
-				EnsureType<const char*>(DebugThreadIdStr().c_str())));
-	}
-}
-
-//--------------------------------------------------------------
-
+//! \brief Таблицы для БПФ длины 2^power
 struct FFTTables
 {
-	vector<DataArray<complexF64>> phasors_f64;
-	vector<DataArray<complexF32>> phasors_f32;
-	vector<DataArray<size_t>> rev_index_tables;
+	DataArray<complexF64> phasors_f64;
+	DataArray<complexF32> phasors_f32;
+	DataArray<size_t> rev_index_table;
 
-	FFTTables(size_t max_data_size, size_t max_power);
+	FFTTables(size_t power);
 
 	template <class complex_t>
-	const complex_t *get_phasors(size_t power) const = delete;
+	const complex_t *get_phasors() const = delete;
 };
 
 template <>
-inline const complexF64 *FFTTables::get_phasors(size_t power) const
+inline const complexF64 *FFTTables::get_phasors() const
 {
-	return phasors_f64[power].data();
+	return phasors_f64.data();
 }
 
 template <>
-inline const complexF32 *FFTTables::get_phasors(size_t power) const
+inline const complexF32 *FFTTables::get_phasors() const
 {
-	return phasors_f32[power].data();
+	return phasors_f32.data();
 }
 
 //--------------------------------------------------------------
 
-FFTTables::FFTTables(size_t max_data_size, size_t max_power):
-	phasors_f64(max_power+1),
-	phasors_f32(max_power+1),
-	rev_index_tables(max_power+1)
+FFTTables::FFTTables(size_t power)
 {
-	phasors_f64.back() = ComputePhasors<DataArray<complexF64>>(max_data_size);
-	for (auto it = phasors_f64.rbegin();;)
-	{
-		auto it_next = next(it);
-		if (it_next == phasors_f64.rend())
-			break;
-		auto &phasors = *it;
-		auto &phasors_next = *it_next;
-		phasors_next.realloc(phasors.size()/2);
-		for (size_t i = 0; i != phasors_next.size(); ++i)
-		{
-			phasors_next[i] = phasors[2*i];
-		}
-		it = it_next;
-	}
-	for (size_t i = 0; i < phasors_f64.size(); ++i)
-	{
-		phasors_f32[i].MakeCopy(phasors_f64[i]);
-	}
-
-	size_t data_size = 1;
-	for (size_t power = 0; power <= max_power; ++power, data_size <<= 1)
-	{
-		rev_index_tables[power] = MakeRevIndexTable(data_size);
-	}
+	size_t data_size = size_t(1) << power;
+	phasors_f64 = ComputePhasors<DataArray<complexF64>>(data_size);
+	phasors_f32.MakeCopy(phasors_f64);
+	rev_index_table = MakeRevIndexTable(data_size);
 }
 
 //--------------------------------------------------------------
 
-struct FFTDispatcherWithData
-{
-	FFTTables tables;
-	size_t max_data_size;
-	ProcessorPoolDispatcher<FFTProcessor> dispatcher;
+//! \brief Максимальная степень 2, для которой ceil_fft_length() может вернуть длину
+constexpr size_t MaxFFTPower = numeric_limits<size_t>::digits - 1;
 
-	FFTDispatcherWithData(size_t max_data_size, size_t max_power);
+/*!
+	\brief Таблицы для каждой степени 2, создаются при первом обращении (см. GetTables())
 
-	FFTProcessor CreateProcessor(size_t processor_id);
-};
+	Массив атомарных указателей не требует динамической инициализации, поэтому модуль
+	ничего не вычисляет при запуске программы. Созданные таблицы не удаляются до завершения
+	программы: указатель на них может быть у преобразования, выполняемого в другом потоке.
+*/
+atomic<const FFTTables*> fft_tables[MaxFFTPower + 1];
+
+//! \brief Мьютекс на создание таблиц (чтение fft_tables выполняется без блокировки)
+mutex fft_tables_mutex;
 
 //--------------------------------------------------------------
 
-FFTDispatcherWithData::FFTDispatcherWithData(size_t max_data_size, size_t max_power):
-	tables(max_data_size, max_power),
-	max_data_size(max_data_size),
-	dispatcher(omp_get_num_procs(),
-			[this](size_t processor_id) { return this->CreateProcessor(processor_id); })
+const FFTTables &GetTables(size_t power)
 {
+	const FFTTables *tables = fft_tables[power].load(memory_order_acquire);
+	if (tables)
+		return *tables;
+	lock_guard<mutex> lock(fft_tables_mutex);
+	tables = fft_tables[power].load(memory_order_relaxed);
+	if (!tables)
+	{
+		GlobalDataAllocatorScope persistent;
+		tables = new FFTTables(power);
+		fft_tables[power].store(tables, memory_order_release);
+	}
+	return *tables;
 }
 
 //--------------------------------------------------------------
 
-FFTProcessor FFTDispatcherWithData::CreateProcessor(size_t processor_id)
+//! \brief Буфер для промежуточных данных, свой для каждого потока. Память выделяется только при увеличении размера
+template <class complex_t>
+complex_t *GetThreadBuffer(size_t size)
 {
-	return FFTProcessor(max_data_size,
-			FFTProcessor::phasors_t(&tables.phasors_f64, &tables.phasors_f32),
-			&tables.rev_index_tables,
-			processor_id);
+	thread_local DataArray<complex_t> buffer;
+	if (buffer.size() < size)
+	{
+		GlobalDataAllocatorScope persistent;
+		buffer.realloc(size);
+	}
+	return buffer.data();
 }
 
 //--------------------------------------------------------------
@@ -291,26 +221,14 @@ struct IntegerLog2Lower<1>
 
 // \brief Максимально допустимый размер локального буфера БПФ (в стеке)
 constexpr size_t MaxLocalBufferSize = 8192;
-constexpr size_t FFTTablesMinSampleSize = sizeof(complexF32);
-
-//! \brief Требуемая максимальная длина БПФ для статических таблиц.
-//! Это соответствует MaxLocalBufferSize и может быть не степенью двойки
-constexpr size_t FFTTablesMaxSize_nn = MaxLocalBufferSize / FFTTablesMinSampleSize;
+constexpr size_t FFTMinSampleSize = sizeof(complexF32);
 
-constexpr size_t FFTTablesMaxPower = IntegerLog2Lower<FFTTablesMaxSize_nn>::value;
-constexpr size_t FFTTablesMaxSize = 1 << FFTTablesMaxPower;
+//! \brief Максимальная длина БПФ с буфером в стеке
+constexpr size_t FFTMaxLocalPower = IntegerLog2Lower<MaxLocalBufferSize / FFTMinSampleSize>::value;
+constexpr size_t FFTMaxLocalSize = size_t(1) << FFTMaxLocalPower;
 //! \brief Нормализованное значение локального буфера для БПФ.
-//! Соответствует FFTTablesMaxSize, может быть меньше MaxLocalBufferSize.
-constexpr size_t FFTTablesMaxLocalBufferSize = FFTTablesMaxSize * FFTTablesMinSampleSize;
-
-//! \brief Таблицы БПФ для "коротких" длин, доступные всегда, не меняются после инициализации
-const FFTTables small_fft_tables(FFTTablesMaxSize, FFTTablesMaxPower);
-
-//! \brief Диспетчер, чтение и запись должны выполняться атомарными функциями
-shared_ptr<FFTDispatcherWithData> dispatcher;
-
-//! \brief Мьютекс на создание нового dispatcher (само изменение производится атомарной функцией)
-mutex dispatcher_mutex;
+//! Соответствует FFTMaxLocalSize, может быть меньше MaxLocalBufferSize.
+constexpr size_t FFTMaxLocalBufferSize = FFTMaxLocalSize * FFTMinSampleSize;
 
 //--------------------------------------------------------------
 
@@ -341,37 +259,19 @@ size_t ceil_fft_length(size_t length, size_t *power_of_2)
 	return res_length;
 }
 
+
 //--------------------------------------------------------------
 
 void InitializeFFT(size_t length)
 {
 	size_t max_power = 0;
-	size_t max_data_size = ceil_fft_length(length, &max_power);
-	if (!max_power)
-	{
-		atomic_store(&dispatcher, shared_ptr<FFTDispatcherWithData>());
-		return;
-	}
-
-	lock_guard<mutex> lock(dispatcher_mutex);
-	if (dispatcher && dispatcher->max_data_size == length)
-		return;
-	// Замечание: Можно оптимизировать инициализацию для случая уменьшения длины.
-	atomic_store(&dispatcher, make_shared<FFTDispatcherWithData>(max_data_size, max_power));
+	ceil_fft_length(length, &max_power);
+	for (size_t power = 1; power <= max_power; ++power)
+		GetTables(power);
 }
 
 //--------------------------------------------------------------
 
-namespace
-{
-shared_ptr<FFTDispatcherWithData> GetDispatcher()
-{
-	return atomic_load(&dispatcher);
-}
-} // namespace
-
-//--------------------------------------------------------------
-
 namespace
 {
 template <size_t buffer_size, class complex_t>
@@ -430,36 +330,22 @@ inline void FFT_template(complex_t *array, size_t size, ftDirection direction)
 		throw runtime_error(ssprintf("Invalid FFT size: %zu.", EnsureType<size_t>(size)));
 	}
 
-	constexpr size_t MaxSmallSize = FFTTablesMaxLocalBufferSize / sizeof(complex_t);
+	// Таблицы для длины size создаются при первом обращении
+	const FFTTables &tables = GetTables(power);
+	constexpr size_t MaxSmallSize = FFTMaxLocalBufferSize / sizeof(complex_t);
 	if (size <= MaxSmallSize)
 	{
-		// Для малых длин БПФ накладные расходы на синхронизацию потоков превышают время самого БПФ.
-		// Поэтому используем локальный буфер.
-
-		// Проверяем, что таблицы small_fft_tables содержат нужные данные:
-		static_assert(FFTTablesMaxSize * sizeof(complex_t) >= FFTTablesMaxLocalBufferSize,
-				"Invalid static FFT sizes.");
-
-		DecompositionFFTStaticBuf<FFTTablesMaxLocalBufferSize>(array, size, direction,
-				small_fft_tables.get_phasors<complex_t>(power),
-				small_fft_tables.rev_index_tables[power].data());
+		// Для малых длин БПФ используем буфер в стеке
+		DecompositionFFTStaticBuf<FFTMaxLocalBufferSize>(array, size, direction,
+				tables.get_phasors<complex_t>(),
+				tables.rev_index_table.data());
 	}
 	else
 	{
-		auto local_dispatcher = GetDispatcher();
-		if (!local_dispatcher)
-			throw runtime_error("FFT is not initialized.");
-		if (normalized_size > local_dispatcher->max_data_size)
-		{
-			throw runtime_error(ssprintf("FFT size exceeds initialized FFT size: %zu > %zu.",
-					EnsureType<size_t>(size),
-					EnsureType<size_t>(local_dispatcher->max_data_size)));
-			// Замечание:
-			// Есть возможность вместо исключения переинициализировать dispatcher с нужной длиной FFT.
-			// Делать инициализацию нужно в GetDispatcher().
-		}
-
-		local_dispatcher->dispatcher.Perform(array, size, power, direction);
+		DecompositionFFT(array, size, direction,
+				tables.get_phasors<complex_t>(),
+				GetThreadBuffer<complex_t>(size),
+				tables.rev_index_table.data());
 	}
 }
 
@@ -479,19 +365,6 @@ void FFT(complexF64 *array, size_t size, ftDirection direction)
 
 //--------------------------------------------------------------
 
-class GlobalInitializer
-{
-	public:
-		GlobalInitializer()
-		{
-			InitializeFFT(65536);
-		}
-};
-
-GlobalInitializer global_initializer;
-
-//--------------------------------------------------------------
-
 } // namespace DecompositionFFT
 
 XRAD_END
@@ -71,9 +71,10 @@ void DecompositionFFT(complex_t *data, size_t data_size, ftDirection direction,
 size_t ceil_fft_length(size_t length, size_t *power_of_2 = nullptr);
 
 /*!
-	\brief Инициализировать модуль FFT для максимально допустимой длины length
+	\brief Заранее создать таблицы FFT для длин до length включительно
 
-	Длина length нормализуется до ближайшей подходящей при помощи ceil_fft_length.
+	Вызов необязателен: таблицы для каждой длины создаются при первом преобразовании
+	этой длины. Длина length нормализуется до ближайшей подходящей при помощи ceil_fft_length.
 */
 void InitializeFFT(size_t length);
 
@@ -0,0 +1,318 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+#include "pre.h"
+#include "FFTConvolution.h"
+#include "FourierBasic.h"
+#include <XRADBasic/Sources/Containers/DataArray.h>
+#include <cmath>
+#include <limits>
+
+XRAD_BEGIN
+
+namespace FFTConvolution
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+template<class T>
+struct sample_traits;
+
+template<>
+struct sample_traits<float>
+{
+	using complex_type = complexF32;
+	using is_real = std::true_type;
+};
+
+template<>
+struct sample_traits<double>
+{
+	using complex_type = complexF64;
+	using is_real = std::true_type;
+};
+
+template<>
+struct sample_traits<complexF32>
+{
+	using complex_type = complexF32;
+	using is_real = std::false_type;
+};
+
+template<>
+struct sample_traits<complexF64>
+{
+	using complex_type = complexF64;
+	using is_real = std::false_type;
+};
+
+//--------------------------------------------------------------
+
+//! \brief Ограничение размера двумерной плитки по каждой оси (если ядро не требует большего)
+const size_t max_tile_length = 1024;
+
+/*!
+	\brief Длина блока overlap-save для ядра kernel_size и result_size отсчетов результата
+
+	Перебираются длины ceil_fft_length(m*kernel_size) и длина, покрывающая весь сигнал
+	одним блоком. Выбирается длина с наименьшей оценкой числа операций:
+	(число блоков)*L*log2(L). Длины больше max_length рассматриваются, только если
+	меньших подходящих длин нет.
+*/
+size_t block_length(size_t kernel_size, size_t result_size, size_t max_length)
+{
+	auto	cost = [kernel_size, result_size](size_t length)
+	{
+		size_t	step = length - kernel_size + 1;
+		double	n_blocks = double((result_size + step - 1)/step);
+		return n_blocks*double(length)*std::log2(double(max(length, size_t(2))));
+	};
+	const size_t	whole_length = ceil_fft_length(result_size + kernel_size - 1);
+	size_t	best_length = whole_length;
+	double	best_cost = whole_length <= max_length? cost(whole_length): std::numeric_limits<double>::infinity();
+	for(size_t factor: {2, 3, 4, 6, 8, 12, 16, 24, 32, 64})
+	{
+		size_t	length = ceil_fft_length(factor*kernel_size);
+		if(length >= whole_length)
+			break;
+		if(length > max_length && best_cost < std::numeric_limits<double>::infinity())
+			break;
+		double	c = cost(length);
+		if(c < best_cost)
+		{
+			best_cost = c;
+			best_length = length;
+		}
+	}
+	return best_length;
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Спектр ядра для свертки блоков длины length (одномерный или двумерный)
+
+	Ядро записывается в обратном порядке по модулю длины: g(-i, -j) = kernel(i, j), после
+	чего IFFT(FFT(x)*FFT(g)) дает корреляцию x с ядром. Множитель sqrt(length) компенсирует
+	нормировку FFT_ptr().
+*/
+template<class complex_t, class T>
+void kernel_spectrum(complex_t *spectrum, size_t vlength, size_t hlength,
+		const T *kernel, size_t kernel_vsize, size_t kernel_hsize)
+{
+	std::fill(spectrum, spectrum + vlength*hlength, complex_t(0));
+	for(size_t i = 0; i < kernel_vsize; ++i)
+	{
+		size_t	v = (vlength - i)%vlength;
+		for(size_t j = 0; j < kernel_hsize; ++j)
+		{
+			size_t	h = (hlength - j)%hlength;
+			spectrum[v*hlength + h] = complex_t(kernel[i*kernel_hsize + j]);
+		}
+	}
+	FFTPrimitives::FFT_batch(spectrum, hlength, vlength, 1, hlength, ftForward);
+	if(vlength > 1)
+		FFTPrimitives::FFT_batch(spectrum, vlength, hlength, hlength, 1, ftForward);
+	using scalar_t = typename complex_t::part_type;
+	const scalar_t	factor = scalar_t(std::sqrt(double(vlength*hlength)));
+	for(size_t i = 0; i < vlength*hlength; ++i)
+		spectrum[i] *= factor;
+}
+
+//! \brief Свертка плитки с ядром в частотной области
+template<class complex_t>
+void correlate_tile(complex_t *tile, const complex_t *spectrum, size_t vlength, size_t hlength)
+{
+	FFTPrimitives::FFT_batch(tile, hlength, vlength, 1, hlength, ftForward);
+	if(vlength > 1)
+		FFTPrimitives::FFT_batch(tile, vlength, hlength, hlength, 1, ftForward);
+	for(size_t i = 0; i < vlength*hlength; ++i)
+		tile[i] *= spectrum[i];
+	if(vlength > 1)
+		FFTPrimitives::FFT_batch(tile, vlength, hlength, hlength, 1, ftReverse);
+	FFTPrimitives::FFT_batch(tile, hlength, vlength, 1, hlength, ftReverse);
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Загрузка плитки vlength*hlength из extended с позиции (v0, h0)
+
+	Для вещественных данных в мнимую часть загружается соседняя плитка с позиции
+	(v0, h0 + hstep). Отсчеты за пределами extended заполняются нулями.
+*/
+template<class complex_t, class T>
+void load_tile(complex_t *tile, size_t vlength, size_t hlength,
+		const T *extended, size_t extended_vsize, size_t extended_hsize,
+		size_t v0, size_t h0, size_t /*hstep*/, std::false_type /*is_real*/)
+{
+	size_t	vcount = min(vlength, extended_vsize - v0);
+	size_t	hcount = min(hlength, extended_hsize - h0);
+	for(size_t i = 0; i < vcount; ++i)
+	{
+		const T	*src = extended + (v0 + i)*extended_hsize + h0;
+		complex_t	*dst = tile + i*hlength;
+		std::copy(src, src + hcount, dst);
+		std::fill(dst + hcount, dst + hlength, complex_t(0));
+	}
+	std::fill(tile + vcount*hlength, tile + vlength*hlength, complex_t(0));
+}
+
+template<class complex_t, class T>
+void load_tile(complex_t *tile, size_t vlength, size_t hlength,
+		const T *extended, size_t extended_vsize, size_t extended_hsize,
+		size_t v0, size_t h0, size_t hstep, std::true_type /*is_real*/)
+{
+	size_t	vcount = min(vlength, extended_vsize - v0);
+	size_t	hcount_re = min(hlength, extended_hsize - h0);
+	size_t	h1 = h0 + hstep;
+	size_t	hcount_im = h1 < extended_hsize? min(hlength, extended_hsize - h1): 0;
+	for(size_t i = 0; i < vcount; ++i)
+	{
+		const T	*src = extended + (v0 + i)*extended_hsize;
+		complex_t	*dst = tile + i*hlength;
+		for(size_t j = 0; j < hlength; ++j)
+		{
+			dst[j] = complex_t(j < hcount_re? src[h0 + j]: T(0), j < hcount_im? src[h1 + j]: T(0));
+		}
+	}
+	std::fill(tile + vcount*hlength, tile + vlength*hlength, complex_t(0));
+}
+
+//! \brief Запись vcount*hcount верных отсчетов плитки в result с позиции (v0, h0)
+template<class complex_t, class T>
+void store_tile(T *result, size_t vsize, size_t hsize, const complex_t *tile, size_t hlength,
+		size_t v0, size_t h0, size_t vstep, size_t hstep, std::false_type /*is_real*/)
+{
+	size_t	vcount = min(vstep, vsize - v0);
+	size_t	hcount = min(hstep, hsize - h0);
+	for(size_t i = 0; i < vcount; ++i)
+	{
+		std::copy(tile + i*hlength, tile + i*hlength + hcount, result + (v0 + i)*hsize + h0);
+	}
+}
+
+template<class complex_t, class T>
+void store_tile(T *result, size_t vsize, size_t hsize, const complex_t *tile, size_t hlength,
+		size_t v0, size_t h0, size_t vstep, size_t hstep, std::true_type /*is_real*/)
+{
+	size_t	vcount = min(vstep, vsize - v0);
+	size_t	hcount_re = min(hstep, hsize - h0);
+	size_t	h1 = h0 + hstep;
+	size_t	hcount_im = h1 < hsize? min(hstep, hsize - h1): 0;
+	for(size_t i = 0; i < vcount; ++i)
+	{
+		const complex_t	*src = tile + i*hlength;
+		T	*dst = result + (v0 + i)*hsize;
+		for(size_t j = 0; j < hcount_re; ++j)
+			dst[h0 + j] = src[j].re;
+		for(size_t j = 0; j < hcount_im; ++j)
+			dst[h1 + j] = src[j].im;
+	}
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Общая реализация одномерной и двумерной свертки
+
+	Одномерная свертка -- частный случай с vsize = kernel_vsize = 1.
+*/
+template<class T>
+void Correlate2D_template(const T *extended, T *result, size_t vsize, size_t hsize,
+		const T *kernel, size_t kernel_vsize, size_t kernel_hsize, size_t max_length)
+{
+	using complex_t = typename sample_traits<T>::complex_type;
+	using is_real = typename sample_traits<T>::is_real;
+	if(!kernel_vsize || !kernel_hsize)
+	{
+		ForceDebugBreak();
+		throw invalid_argument("FFTConvolution::Correlate, empty kernel.");
+	}
+	if(!vsize || !hsize)
+		return;
+
+	const size_t	extended_vsize = vsize + kernel_vsize - 1;
+	const size_t	extended_hsize = hsize + kernel_hsize - 1;
+	const size_t	vlength = block_length(kernel_vsize, vsize, max_length);
+	const size_t	hlength = block_length(kernel_hsize, hsize, max_length);
+	const size_t	vstep = vlength - kernel_vsize + 1;
+	const size_t	hstep = hlength - kernel_hsize + 1;
+	// Для вещественных данных одно преобразование обрабатывает две соседние по горизонтали плитки
+	const size_t	hstride = is_real::value? 2*hstep: hstep;
+
+	DataArray<complex_t>	spectrum(vlength*hlength), tile(vlength*hlength);
+	kernel_spectrum(spectrum.data(), vlength, hlength, kernel, kernel_vsize, kernel_hsize);
+
+	for(size_t v0 = 0; v0 < vsize; v0 += vstep)
+	{
+		for(size_t h0 = 0; h0 < hsize; h0 += hstride)
+		{
+			load_tile(tile.data(), vlength, hlength, extended, extended_vsize, extended_hsize,
+					v0, h0, hstep, is_real());
+			correlate_tile(tile.data(), spectrum.data(), vlength, hlength);
+			store_tile(result, vsize, hsize, tile.data(), hlength, v0, h0, vstep, hstep, is_real());
+		}
+	}
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+void Correlate(const float *extended, float *result, size_t result_size, const float *kernel, size_t kernel_size)
+{
+	Correlate2D_template(extended, result, 1, result_size, kernel, 1, kernel_size, numeric_limits<size_t>::max());
+}
+
+void Correlate(const double *extended, double *result, size_t result_size, const double *kernel, size_t kernel_size)
+{
+	Correlate2D_template(extended, result, 1, result_size, kernel, 1, kernel_size, numeric_limits<size_t>::max());
+}
+
+void Correlate(const complexF32 *extended, complexF32 *result, size_t result_size, const complexF32 *kernel, size_t kernel_size)
+{
+	Correlate2D_template(extended, result, 1, result_size, kernel, 1, kernel_size, numeric_limits<size_t>::max());
+}
+
+void Correlate(const complexF64 *extended, complexF64 *result, size_t result_size, const complexF64 *kernel, size_t kernel_size)
+{
+	Correlate2D_template(extended, result, 1, result_size, kernel, 1, kernel_size, numeric_limits<size_t>::max());
+}
+
+//--------------------------------------------------------------
+
+void Correlate2D(const float *extended, float *result, size_t vsize, size_t hsize,
+		const float *kernel, size_t kernel_vsize, size_t kernel_hsize)
+{
+	Correlate2D_template(extended, result, vsize, hsize, kernel, kernel_vsize, kernel_hsize, max_tile_length);
+}
+
+void Correlate2D(const double *extended, double *result, size_t vsize, size_t hsize,
+		const double *kernel, size_t kernel_vsize, size_t kernel_hsize)
+{
+	Correlate2D_template(extended, result, vsize, hsize, kernel, kernel_vsize, kernel_hsize, max_tile_length);
+}
+
+void Correlate2D(const complexF32 *extended, complexF32 *result, size_t vsize, size_t hsize,
+		const complexF32 *kernel, size_t kernel_vsize, size_t kernel_hsize)
+{
+	Correlate2D_template(extended, result, vsize, hsize, kernel, kernel_vsize, kernel_hsize, max_tile_length);
+}
+
+void Correlate2D(const complexF64 *extended, complexF64 *result, size_t vsize, size_t hsize,
+		const complexF64 *kernel, size_t kernel_vsize, size_t kernel_hsize)
+{
+	Correlate2D_template(extended, result, vsize, hsize, kernel, kernel_vsize, kernel_hsize, max_tile_length);
+}
+
+//--------------------------------------------------------------
+
+} // namespace FFTConvolution
+
+XRAD_END
@@ -0,0 +1,79 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTConvolution.h
+//--------------------------------------------------------------
+#ifndef XRAD__FFTConvolution_h
+#define XRAD__FFTConvolution_h
+//--------------------------------------------------------------
+
+#include "FourierDefs.h"
+#include <XRADBasic/Sources/SampleTypes/ComplexSample.h>
+
+XRAD_BEGIN
+
+/*!
+	\brief Быстрая свертка с длинными ядрами через FFT (overlap-save)
+
+	Функции вычисляют свертку в той форме, в которой ее выполняют КИХ-фильтры XRAD
+	(без обращения ядра, т.е. корреляцию):
+
+	result[j] = sum_{p < kernel_size} kernel[p]*extended[j + p],  j < result_size.
+
+	Массив extended содержит result_size + kernel_size - 1 отсчетов: исходные данные вместе
+	с уже экстраполированными краями. Экстраполяцию выполняет вызывающий код
+	(см. FIRFilterFFT.h), здесь она не рассматривается.
+
+	Данные обрабатываются блоками длины L (см. ceil_fft_length()), каждый блок дает
+	L - kernel_size + 1 отсчетов результата. Длина блока выбирается по минимуму числа операций
+	на отсчет результата. Спектр ядра вычисляется один раз. Для вещественных данных
+	два соседних блока упаковываются в одно комплексное преобразование (вещественная
+	и мнимая части).
+
+	Вычисления выполняются в точности данных: complexF32 для float и complexF32,
+	complexF64 для double и complexF64. Сложность O(n log kernel_size) на отсчет вместо
+	O(kernel_size) у прямой свертки.
+*/
+namespace FFTConvolution
+{
+
+//--------------------------------------------------------------
+
+//! \brief Одномерная свертка, kernel_size >= 1
+void Correlate(const float *extended, float *result, size_t result_size, const float *kernel, size_t kernel_size);
+void Correlate(const double *extended, double *result, size_t result_size, const double *kernel, size_t kernel_size);
+void Correlate(const complexF32 *extended, complexF32 *result, size_t result_size, const complexF32 *kernel, size_t kernel_size);
+void Correlate(const complexF64 *extended, complexF64 *result, size_t result_size, const complexF64 *kernel, size_t kernel_size);
+
+/*!
+	\brief Двумерная свертка
+
+	result(v, h) = sum_{i, j} kernel(i, j)*extended(v + i, h + j).
+
+	Все массивы хранятся построчно без промежутков: extended имеет размер
+	(vsize + kernel_vsize - 1)*(hsize + kernel_hsize - 1), result -- vsize*hsize,
+	kernel -- kernel_vsize*kernel_hsize. Размеры ядра >= 1.
+
+	Изображение обрабатывается плитками (двумерный overlap-save), размер плитки
+	по каждой оси выбирается так же, как длина блока одномерной свертки, но не больше 1024
+	(если ядро не требует большего).
+*/
+void Correlate2D(const float *extended, float *result, size_t vsize, size_t hsize,
+		const float *kernel, size_t kernel_vsize, size_t kernel_hsize);
+void Correlate2D(const double *extended, double *result, size_t vsize, size_t hsize,
+		const double *kernel, size_t kernel_vsize, size_t kernel_hsize);
+void Correlate2D(const complexF32 *extended, complexF32 *result, size_t vsize, size_t hsize,
+		const complexF32 *kernel, size_t kernel_vsize, size_t kernel_hsize);
+void Correlate2D(const complexF64 *extended, complexF64 *result, size_t vsize, size_t hsize,
+		const complexF64 *kernel, size_t kernel_vsize, size_t kernel_hsize);
+
+//--------------------------------------------------------------
+
+} // namespace FFTConvolution
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__FFTConvolution_h
@@ -0,0 +1,67 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTSIMD.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "FFTSIMD.h"
+
+XRAD_BEGIN
+
+namespace FFTSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+template<class T>
+const Kernels<T> *select_kernels(const Kernels<T> &(*sse2)(), const Kernels<T> &(*avx2)(),
+		const Kernels<T> &(*avx512)())
+{
+#ifdef XRAD_CPU_X86
+	switch(ActiveSIMDInstructionSet())
+	{
+		case e_simd_sse2: return &sse2();
+		case e_simd_avx2: return &avx2();
+		case e_simd_avx512: return &avx512();
+		default: break;
+	}
+#endif
+	return nullptr;
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+template<>
+const Kernels<float> *ActiveKernels<float>()
+{
+#ifdef XRAD_CPU_X86
+	return select_kernels(KernelsF32_SSE2, KernelsF32_AVX2, KernelsF32_AVX512);
+#else
+	return nullptr;
+#endif
+}
+
+//--------------------------------------------------------------
+
+template<>
+const Kernels<double> *ActiveKernels<double>()
+{
+#ifdef XRAD_CPU_X86
+	return select_kernels(KernelsF64_SSE2, KernelsF64_AVX2, KernelsF64_AVX512);
+#else
+	return nullptr;
+#endif
+}
+
+//--------------------------------------------------------------
+
+} // namespace FFTSIMD
+
+XRAD_END
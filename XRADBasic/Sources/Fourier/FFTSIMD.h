@@ -0,0 +1,136 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTSIMD.h
+//--------------------------------------------------------------
+#ifndef XRAD__FFTSIMD_h
+#define XRAD__FFTSIMD_h
+/*!
+	\file
+	\brief Векторизованные (SSE2, AVX2, AVX-512) ядра БПФ
+
+	Внутренний файл библиотеки. Ядра работают с массивами комплексных отсчетов, представленных
+	парами вещественных чисел (re, im), т.е. с complexF32 и complexF64, приведенными
+	к float* и double* соответственно.
+
+	Реализации для каждого набора инструкций находятся в отдельных единицах трансляции
+	(FFTSIMD_SSE2.cpp, FFTSIMD_AVX2.cpp, FFTSIMD_AVX512.cpp), которые компилируются
+	с соответствующими ключами. Выбор реализации выполняется во время выполнения
+	по ActiveSIMDInstructionSet().
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Sources/Core/CPUFeatures.h>
+#include <cstddef>
+
+XRAD_BEGIN
+
+namespace FFTSIMD
+{
+
+//--------------------------------------------------------------
+
+//! \brief Набор ядер для одного набора инструкций и одного типа T (float или double)
+template<class T>
+struct Kernels
+{
+	//! \brief Набор инструкций, для которого скомпилированы ядра
+	simd_instruction_set_t	instruction_set;
+
+	//! \brief Число комплексных отсчетов в векторном регистре
+	size_t	lanes;
+
+	/*!
+		\brief Проход схемы Стокхэма (см. MixedRadixFFT)
+
+		Для j = q*span + k (k < span) читаются отсчеты in[j + r*size/radix], r = 0..radix-1,
+		умножаются на twiddles[(r-1)*span + k] (при обратном преобразовании на сопряженные
+		значения), преобразуются ядром длины radix и записываются в out[q*span*radix + k + r*span].
+
+		Размеры указываются в комплексных отсчетах.
+
+		\return false, если для radix нет векторизованного ядра. В этом случае данные не изменяются.
+		Поддерживаются radix 2, 3, 4, 5, 7, 8.
+	*/
+	bool	(*stockham_stage)(const T *in, T *out, size_t size, size_t radix, size_t span,
+			const T *twiddles, bool forward);
+
+	//! \brief out[i] = in[i]*factor, i < size. Допускается in == out
+	void	(*scale)(const T *in, T *out, size_t size, T factor);
+
+	//! \brief out[i] = a[i]*b[i], i < size. Допускается совпадение out с a или b
+	void	(*multiply)(const T *a, const T *b, T *out, size_t size);
+
+	/*!
+		\name Пакетные ядра: векторизация по сигналам
+
+		Блок содержит lanes сигналов длины size. Отсчет i блока занимает 2*lanes чисел:
+		вещественные части отсчета i всех сигналов, затем мнимые части. Порядок сигналов
+		в блоке определяется реализацией и восстанавливается при записи store_block().
+		@{
+	*/
+
+	//! \brief Проход схемы Стокхэма для блока (см. stockham_stage). Поддерживаются те же radix
+	bool	(*stockham_block_stage)(const T *in, T *out, size_t size, size_t radix, size_t span,
+			const T *twiddles, bool forward);
+
+	/*!
+		\brief Перенести в блок n <= lanes сигналов
+
+		Отсчет i сигнала s находится в src[s*dist + i*stride] (в комплексных отсчетах).
+		Сигнал циклически сдвигается на shift отсчетов вперед: отсчет i блока равен отсчету
+		(i - shift) mod size сигнала. Сигналы n..lanes-1 блока заполняются нулями.
+	*/
+	void	(*load_block)(const T *src, size_t size, size_t n, ptrdiff_t stride, ptrdiff_t dist,
+			size_t shift, T *block);
+
+	//! \brief Операция, обратная load_block(): отсчет i блока, умноженный на factor,
+	//! записывается в отсчет (i + shift) mod size сигнала
+	void	(*store_block)(const T *block, T *dst, size_t size, size_t n, ptrdiff_t stride, ptrdiff_t dist,
+			size_t shift, T factor);
+
+	//! @}
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Ядра для текущего набора инструкций ActiveSIMDInstructionSet()
+
+	\return nullptr, если векторизованные ядра недоступны (используется скалярный код)
+*/
+template<class T>
+const Kernels<T> *ActiveKernels();
+
+template<>
+const Kernels<float> *ActiveKernels<float>();
+
+template<>
+const Kernels<double> *ActiveKernels<double>();
+
+//--------------------------------------------------------------
+
+#ifdef XRAD_CPU_X86
+
+// Реализации для конкретных наборов инструкций. Вызывать только при поддержке
+// соответствующих инструкций процессором
+
+const Kernels<float> &KernelsF32_SSE2();
+const Kernels<double> &KernelsF64_SSE2();
+const Kernels<float> &KernelsF32_AVX2();
+const Kernels<double> &KernelsF64_AVX2();
+const Kernels<float> &KernelsF32_AVX512();
+const Kernels<double> &KernelsF64_AVX512();
+
+#endif // XRAD_CPU_X86
+
+//--------------------------------------------------------------
+
+} // namespace FFTSIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__FFTSIMD_h
@@ -0,0 +1,675 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTSIMDKernels.hh
+//--------------------------------------------------------------
+/*!
+	\file
+	\brief Общая реализация векторизованных ядер БПФ
+
+	Внутренний файл библиотеки. Подключается только из FFTSIMD_*.cpp после определения структуры V,
+	описывающей векторный регистр:
+	- `real` -- float или double;
+	- `reg` -- тип регистра, `lanes` -- число вещественных чисел в регистре;
+	- `set1`, `add`, `sub`, `mul`, `fmadd` (a*b + c), `fmsub` (a*b - c);
+	- `load_real`, `store_real` -- чтение и запись lanes вещественных чисел;
+	- `load_complex`, `store_complex` -- чтение и запись lanes комплексных чисел (пар re, im)
+	с разделением на регистры вещественных и мнимых частей. Порядок отсчетов в регистрах
+	может быть любым, если store_complex восстанавливает исходный порядок.
+
+	Все определения находятся в безымянном пространстве имен: код компилируется с разными
+	ключами набора инструкций и не должен смешиваться при компоновке. По той же причине здесь
+	не подключаются Core.h и WinogradShortFFT.h: встраиваемые функции и статические объекты
+	из этих файлов были бы скомпилированы с ключами AVX и могли бы выполняться на процессоре
+	без поддержки этих инструкций. Ядра коротких преобразований повторяют WinogradShortFFT.hh.
+*/
+//--------------------------------------------------------------
+
+#include "FFTSIMD.h"
+
+XRAD_BEGIN
+
+namespace FFTSIMD
+{
+
+namespace
+{
+
+//--------------------------------------------------------------
+
+//! \brief Вектор вещественных чисел с арифметическими операциями
+template<class V>
+struct real_pack
+{
+	typename V::reg	value;
+
+	real_pack() = default;
+	real_pack(typename V::reg in_value): value(in_value) {}
+};
+
+template<class V>
+inline real_pack<V> operator+(const real_pack<V> &x, const real_pack<V> &y)
+{
+	return V::add(x.value, y.value);
+}
+
+template<class V>
+inline real_pack<V> operator-(const real_pack<V> &x, const real_pack<V> &y)
+{
+	return V::sub(x.value, y.value);
+}
+
+//--------------------------------------------------------------
+
+//! \brief Вектор комплексных чисел: отдельные регистры вещественных и мнимых частей
+template<class V>
+struct complex_pack
+{
+	real_pack<V>	re, im;
+
+	complex_pack() = default;
+	complex_pack(const real_pack<V> &in_re, const real_pack<V> &in_im): re(in_re), im(in_im) {}
+
+	complex_pack &operator+=(const complex_pack &x)
+	{
+		re = re + x.re;
+		im = im + x.im;
+		return *this;
+	}
+
+	complex_pack &operator-=(const complex_pack &x)
+	{
+		re = re - x.re;
+		im = im - x.im;
+		return *this;
+	}
+};
+
+template<class V>
+inline complex_pack<V> operator+(const complex_pack<V> &x, const complex_pack<V> &y)
+{
+	return complex_pack<V>(x.re + y.re, x.im + y.im);
+}
+
+template<class V>
+inline complex_pack<V> operator-(const complex_pack<V> &x, const complex_pack<V> &y)
+{
+	return complex_pack<V>(x.re - y.re, x.im - y.im);
+}
+
+template<class V>
+inline complex_pack<V> operator*(const complex_pack<V> &x, double factor)
+{
+	const auto	f = V::set1(factor);
+	return complex_pack<V>(V::mul(x.re.value, f), V::mul(x.im.value, f));
+}
+
+//--------------------------------------------------------------
+
+template<class V>
+inline complex_pack<V> load(const typename V::real *p)
+{
+	typename V::reg	re, im;
+	V::load_complex(p, re, im);
+	return complex_pack<V>(re, im);
+}
+
+template<class V>
+inline void store(typename V::real *p, const complex_pack<V> &x)
+{
+	V::store_complex(p, x.re.value, x.im.value);
+}
+
+//--------------------------------------------------------------
+
+//! \brief Умножение на множитель w (forward) или на сопряженный множитель (!forward)
+template<class V, bool forward>
+inline complex_pack<V> multiply_phasor(const complex_pack<V> &x, const complex_pack<V> &w)
+{
+	const auto	&xr = x.re.value, &xi = x.im.value, &wr = w.re.value, &wi = w.im.value;
+	if(forward)
+		return complex_pack<V>(V::fmsub(xr, wr, V::mul(xi, wi)), V::fmadd(xr, wi, V::mul(xi, wr)));
+	else
+		return complex_pack<V>(V::fmadd(xr, wr, V::mul(xi, wi)), V::fmsub(xi, wr, V::mul(xr, wi)));
+}
+
+//--------------------------------------------------------------
+
+//	Ядра коротких преобразований (см. WinogradShortFFT.hh)
+
+constexpr double	S_2pi3 = 0.8660254037844387;
+constexpr double	C_2pi31 = -1.5;
+constexpr double	C_2pi5 = 0.30901699437494745;
+constexpr double	C_4pi5 = -0.8090169943749473;
+constexpr double	S_2pi5 = 0.9510565162951535;
+constexpr double	S_4pi5 = 0.5877852522924732;
+constexpr double	C_2pi7 = 0.6234898018587336;
+constexpr double	C_4pi7 = -0.22252093395631434;
+constexpr double	C_6pi7 = -0.900968867902419;
+constexpr double	S_2pi7 = 0.7818314824680298;
+constexpr double	S_4pi7 = 0.9749279121818236;
+constexpr double	S_6pi7 = 0.43388373911755823;
+constexpr double	cos_2PI_8 = 0.7071067811865476;
+
+//! \brief x + i*y
+template<class V>
+inline complex_pack<V> add_i(const complex_pack<V> &x, const complex_pack<V> &y)
+{
+	return complex_pack<V>(x.re - y.im, x.im + y.re);
+}
+
+//! \brief x - i*y
+template<class V>
+inline complex_pack<V> subtract_i(const complex_pack<V> &x, const complex_pack<V> &y)
+{
+	return complex_pack<V>(x.re + y.im, x.im - y.re);
+}
+
+//! \brief Запись пары результатов T -+ i*S (прямое преобразование) или T +- i*S (обратное)
+template<class V, bool forward>
+inline void store_pair(complex_pack<V> &first, complex_pack<V> &second,
+		const complex_pack<V> &T, const complex_pack<V> &S)
+{
+	if(forward)
+	{
+		first = subtract_i(T, S);
+		second = add_i(T, S);
+	}
+	else
+	{
+		first = add_i(T, S);
+		second = subtract_i(T, S);
+	}
+}
+
+template<class V, bool forward>
+inline void fft_2(complex_pack<V> *v)
+{
+	auto b = v[0] - v[1];
+	v[0] += v[1];
+	v[1] = b;
+}
+
+template<class V, bool forward>
+inline void fft_3(complex_pack<V> *v)
+{
+	auto a1 = v[1] + v[2];
+	auto a2 = (v[1] - v[2])*S_2pi3;
+	auto a0 = v[0] + a1;
+	v[0] = a0;
+	auto T0 = a0 + a1*C_2pi31;
+	store_pair<V, forward>(v[1], v[2], T0, a2);
+}
+
+template<class V, bool forward>
+inline void fft_4(complex_pack<V> *v)
+{
+	auto t0 = v[0] + v[2];
+	auto a2 = v[0] - v[2];
+	auto t1 = v[1] + v[3];
+	auto a3 = v[1] - v[3];
+	v[0] = t0 + t1;
+	v[2] = t0 - t1;
+	store_pair<V, forward>(v[1], v[3], a2, a3);
+}
+
+template<class V, bool forward>
+inline void fft_5(complex_pack<V> *v)
+{
+	auto a1 = v[1] + v[4];
+	auto b1 = v[1] - v[4];
+	auto a2 = v[2] + v[3];
+	auto b2 = v[2] - v[3];
+
+	auto T1 = v[0] + a1*C_2pi5 + a2*C_4pi5;
+	auto T2 = v[0] + a1*C_4pi5 + a2*C_2pi5;
+	auto S1 = b1*S_2pi5 + b2*S_4pi5;
+	auto S2 = b1*S_4pi5 - b2*S_2pi5;
+
+	v[0] += a1 + a2;
+	store_pair<V, forward>(v[1], v[4], T1, S1);
+	store_pair<V, forward>(v[2], v[3], T2, S2);
+}
+
+template<class V, bool forward>
+inline void fft_7(complex_pack<V> *v)
+{
+	auto a1 = v[1] + v[6];
+	auto b1 = v[1] - v[6];
+	auto a2 = v[2] + v[5];
+	auto b2 = v[2] - v[5];
+	auto a3 = v[3] + v[4];
+	auto b3 = v[3] - v[4];
+
+	auto T1 = v[0] + a1*C_2pi7 + a2*C_4pi7 + a3*C_6pi7;
+	auto T2 = v[0] + a1*C_4pi7 + a2*C_6pi7 + a3*C_2pi7;
+	auto T3 = v[0] + a1*C_6pi7 + a2*C_2pi7 + a3*C_4pi7;
+	auto S1 = b1*S_2pi7 + b2*S_4pi7 + b3*S_6pi7;
+	auto S2 = b1*S_4pi7 - b2*S_6pi7 - b3*S_2pi7;
+	auto S3 = b1*S_6pi7 - b2*S_2pi7 + b3*S_4pi7;
+
+	v[0] += a1 + a2 + a3;
+	store_pair<V, forward>(v[1], v[6], T1, S1);
+	store_pair<V, forward>(v[2], v[5], T2, S2);
+	store_pair<V, forward>(v[3], v[4], T3, S3);
+}
+
+template<class V, bool forward>
+inline void fft_8(complex_pack<V> *v)
+{
+	auto t0 = v[0] + v[4];
+	auto t1 = v[1] + v[5];
+	auto t2 = v[1] - v[5];
+	auto t3 = v[2] + v[6];
+	auto t4 = v[3] + v[7];
+	auto t5 = v[3] - v[7];
+	auto t6 = t0 + t3;
+	auto t7 = t1 + t4;
+
+	auto a2 = t0 - t3;
+	auto a3 = v[0] - v[4];
+	auto a4 = (t2 - t5)*cos_2PI_8;
+	auto a5 = t1 - t4;
+	auto a6 = v[2] - v[6];
+	auto a7 = (t2 + t5)*cos_2PI_8;
+
+	v[0] = t6 + t7;
+	v[4] = t6 - t7;
+
+	auto T0 = a3 + a4;
+	auto T1 = a3 - a4;
+	auto T2 = a6 + a7;
+	auto T3 = a6 - a7;
+
+	store_pair<V, forward>(v[1], v[7], T0, T2);
+	store_pair<V, forward>(v[2], v[6], a2, a5);
+	store_pair<V, forward>(v[5], v[3], T1, T3);
+}
+
+template<size_t radix, bool forward, class V>
+inline void short_fft(complex_pack<V> *v)
+{
+	switch(radix)
+	{
+		case 2: fft_2<V, forward>(v); break;
+		case 3: fft_3<V, forward>(v); break;
+		case 4: fft_4<V, forward>(v); break;
+		case 5: fft_5<V, forward>(v); break;
+		case 7: fft_7<V, forward>(v); break;
+		case 8: fft_8<V, forward>(v); break;
+	}
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Один регистр прохода схемы Стокхэма для отсчетов j = first..first+n-1 (n <= lanes)
+
+	Используется, когда отсчеты регистра относятся к разным q (span < lanes) или их меньше lanes.
+	Множители и результаты переставляются через буфер.
+*/
+template<class V, size_t radix, bool forward>
+void stockham_buffered(const typename V::real *in, typename V::real *out, size_t size, size_t span,
+		const typename V::real *twiddles, size_t first, size_t n)
+{
+	using real = typename V::real;
+	constexpr size_t	lanes = V::lanes;
+	const size_t	stride = size/radix;
+	alignas(64) real	buffer[radix][2*lanes];
+	complex_pack<V>	v[radix];
+
+	for(size_t r = 0; r < radix; ++r)
+	{
+		const real	*src = in + 2*(first + r*stride);
+		if(n == lanes)
+		{
+			v[r] = load<V>(src);
+			continue;
+		}
+		for(size_t i = 0; i < 2*n; ++i)
+			buffer[r][i] = src[i];
+		for(size_t i = 2*n; i < 2*lanes; ++i)
+			buffer[r][i] = 0;
+		v[r] = load<V>(buffer[r]);
+	}
+	if(span > 1)
+	{
+		alignas(64) real	twiddle_buffer[radix][2*lanes];
+		for(size_t l = 0, k = first%span; l < lanes; ++l, k = k + 1 < span ? k + 1 : 0)
+		{
+			for(size_t r = 1; r < radix; ++r)
+			{
+				const real	*w = twiddles + 2*((r - 1)*span + k);
+				twiddle_buffer[r][2*l] = w[0];
+				twiddle_buffer[r][2*l + 1] = w[1];
+			}
+		}
+		for(size_t r = 1; r < radix; ++r)
+		{
+			v[r] = multiply_phasor<V, forward>(v[r], load<V>(twiddle_buffer[r]));
+		}
+	}
+	short_fft<radix, forward>(v);
+	for(size_t r = 0; r < radix; ++r)
+	{
+		store<V>(buffer[r], v[r]);
+	}
+
+	for(size_t l = 0, q = first/span, k = first%span; l < n; ++l)
+	{
+		real	*dst = out + 2*(q*span*radix + k);
+		for(size_t r = 0; r < radix; ++r)
+		{
+			dst[2*r*span] = buffer[r][2*l];
+			dst[2*r*span + 1] = buffer[r][2*l + 1];
+		}
+		if(++k == span)
+		{
+			k = 0;
+			++q;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Проход схемы Стокхэма для ядра длины radix (см. Kernels::stockham_stage)
+
+	Векторизация по индексу j = q*span + k: соседние j читают соседние входные отсчеты.
+	Внутри одного q множители и результаты для соседних k также расположены подряд.
+	Остаток span%lanes каждого q, а также проходы с span < lanes (первые проходы)
+	обрабатываются через буфер.
+*/
+template<class V, size_t radix, bool forward>
+void stockham_radix_stage(const typename V::real *in, typename V::real *out, size_t size, size_t span,
+		const typename V::real *twiddles)
+{
+	using real = typename V::real;
+	constexpr size_t	lanes = V::lanes;
+	const size_t	stride = size/radix;
+
+	if(span < lanes)
+	{
+		for(size_t j = 0; j < stride; j += lanes)
+		{
+			stockham_buffered<V, radix, forward>(in, out, size, span, twiddles, j,
+					stride - j < lanes ? stride - j : lanes);
+		}
+		return;
+	}
+
+	complex_pack<V>	v[radix];
+	for(size_t j0 = 0; j0 < stride; j0 += span)
+	{
+		const real	*src = in + 2*j0;
+		real	*dst = out + 2*j0*radix;
+		size_t	k = 0;
+		for(; k + lanes <= span; k += lanes)
+		{
+			v[0] = load<V>(src + 2*k);
+			for(size_t r = 1; r < radix; ++r)
+			{
+				v[r] = multiply_phasor<V, forward>(load<V>(src + 2*(k + r*stride)),
+						load<V>(twiddles + 2*((r - 1)*span + k)));
+			}
+			short_fft<radix, forward>(v);
+			for(size_t r = 0; r < radix; ++r)
+			{
+				store<V>(dst + 2*(k + r*span), v[r]);
+			}
+		}
+		if(k < span)
+		{
+			stockham_buffered<V, radix, forward>(in, out, size, span, twiddles, j0 + k, span - k);
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class V, bool forward>
+bool stockham_stage(const typename V::real *in, typename V::real *out, size_t size, size_t radix,
+		size_t span, const typename V::real *twiddles)
+{
+	switch(radix)
+	{
+		case 2: stockham_radix_stage<V, 2, forward>(in, out, size, span, twiddles); return true;
+		case 3: stockham_radix_stage<V, 3, forward>(in, out, size, span, twiddles); return true;
+		case 4: stockham_radix_stage<V, 4, forward>(in, out, size, span, twiddles); return true;
+		case 5: stockham_radix_stage<V, 5, forward>(in, out, size, span, twiddles); return true;
+		case 7: stockham_radix_stage<V, 7, forward>(in, out, size, span, twiddles); return true;
+		case 8: stockham_radix_stage<V, 8, forward>(in, out, size, span, twiddles); return true;
+	}
+	return false;
+}
+
+template<class V>
+bool stockham_stage(const typename V::real *in, typename V::real *out, size_t size, size_t radix,
+		size_t span, const typename V::real *twiddles, bool forward)
+{
+	if(forward)
+		return stockham_stage<V, true>(in, out, size, radix, span, twiddles);
+	else
+		return stockham_stage<V, false>(in, out, size, radix, span, twiddles);
+}
+
+//--------------------------------------------------------------
+
+template<class V>
+void scale(const typename V::real *in, typename V::real *out, size_t size, typename V::real factor)
+{
+	const size_t	n = 2*size;
+	const auto	f = V::set1(factor);
+	size_t	i = 0;
+	for(; i + V::lanes <= n; i += V::lanes)
+	{
+		V::store_real(out + i, V::mul(V::load_real(in + i), f));
+	}
+	for(; i < n; ++i)
+	{
+		out[i] = in[i]*factor;
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class V>
+void multiply(const typename V::real *a, const typename V::real *b, typename V::real *out, size_t size)
+{
+	size_t	i = 0;
+	for(; i + V::lanes <= size; i += V::lanes)
+	{
+		store<V>(out + 2*i, multiply_phasor<V, true>(load<V>(a + 2*i), load<V>(b + 2*i)));
+	}
+	for(; i < size; ++i)
+	{
+		const auto	re = a[2*i]*b[2*i] - a[2*i + 1]*b[2*i + 1];
+		const auto	im = a[2*i]*b[2*i + 1] + a[2*i + 1]*b[2*i];
+		out[2*i] = re;
+		out[2*i + 1] = im;
+	}
+}
+
+//--------------------------------------------------------------
+
+//	Пакетные ядра: отсчет блока -- регистр вещественных частей и регистр мнимых частей
+//	отсчетов lanes сигналов (см. Kernels::stockham_block_stage)
+
+template<class V>
+inline complex_pack<V> load_split(const typename V::real *p)
+{
+	return complex_pack<V>(V::load_real(p), V::load_real(p + V::lanes));
+}
+
+template<class V>
+inline void store_split(typename V::real *p, const complex_pack<V> &x)
+{
+	V::store_real(p, x.re.value);
+	V::store_real(p + V::lanes, x.im.value);
+}
+
+//--------------------------------------------------------------
+
+//! \brief Проход для блока: та же схема, что у stockham_radix_stage, отсчет -- пара регистров
+template<class V, size_t radix, bool forward>
+void stockham_block_radix_stage(const typename V::real *in, typename V::real *out, size_t size, size_t span,
+		const typename V::real *twiddles)
+{
+	using real = typename V::real;
+	constexpr size_t	sample_size = 2*V::lanes;
+	const size_t	stride = size/radix;
+	complex_pack<V>	v[radix];
+
+	for(size_t j0 = 0; j0 < stride; j0 += span)
+	{
+		const real	*src = in + sample_size*j0;
+		real	*dst = out + sample_size*j0*radix;
+		for(size_t k = 0; k < span; ++k)
+		{
+			v[0] = load_split<V>(src + sample_size*k);
+			for(size_t r = 1; r < radix; ++r)
+			{
+				v[r] = load_split<V>(src + sample_size*(k + r*stride));
+				if(span > 1)
+				{
+					const real	*w = twiddles + 2*((r - 1)*span + k);
+					v[r] = multiply_phasor<V, forward>(v[r],
+							complex_pack<V>(V::set1(w[0]), V::set1(w[1])));
+				}
+			}
+			short_fft<radix, forward>(v);
+			for(size_t r = 0; r < radix; ++r)
+			{
+				store_split<V>(dst + sample_size*(k + r*span), v[r]);
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class V, bool forward>
+bool stockham_block_stage(const typename V::real *in, typename V::real *out, size_t size, size_t radix,
+		size_t span, const typename V::real *twiddles)
+{
+	switch(radix)
+	{
+		case 2: stockham_block_radix_stage<V, 2, forward>(in, out, size, span, twiddles); return true;
+		case 3: stockham_block_radix_stage<V, 3, forward>(in, out, size, span, twiddles); return true;
+		case 4: stockham_block_radix_stage<V, 4, forward>(in, out, size, span, twiddles); return true;
+		case 5: stockham_block_radix_stage<V, 5, forward>(in, out, size, span, twiddles); return true;
+		case 7: stockham_block_radix_stage<V, 7, forward>(in, out, size, span, twiddles); return true;
+		case 8: stockham_block_radix_stage<V, 8, forward>(in, out, size, span, twiddles); return true;
+	}
+	return false;
+}
+
+template<class V>
+bool stockham_block_stage(const typename V::real *in, typename V::real *out, size_t size, size_t radix,
+		size_t span, const typename V::real *twiddles, bool forward)
+{
+	if(forward)
+		return stockham_block_stage<V, true>(in, out, size, radix, span, twiddles);
+	else
+		return stockham_block_stage<V, false>(in, out, size, radix, span, twiddles);
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Перенос сигналов в блок (см. Kernels::load_block)
+
+	Если сигналы идут подряд (dist == 1) и заполняют весь блок, отсчеты читаются load_complex()
+	с перестановкой сигналов, которую отменяет store_complex() в store_block(). Иначе отсчеты
+	переносятся по одному в исходном порядке. Вариант в load_block() и store_block()
+	выбирается по одним и тем же dist и n, поэтому перестановки согласованы.
+*/
+template<class V>
+void load_block(const typename V::real *src, size_t size, size_t n, ptrdiff_t stride, ptrdiff_t dist,
+		size_t shift, typename V::real *block)
+{
+	using real = typename V::real;
+	constexpr size_t	lanes = V::lanes;
+	const bool	contiguous = dist == 1 && n == lanes;
+	shift %= size;
+	size_t	source_i = shift ? size - shift : 0;
+	for(size_t i = 0; i < size; ++i)
+	{
+		const real	*s = src + 2*ptrdiff_t(source_i)*stride;
+		real	*b = block + 2*lanes*i;
+		if(++source_i == size)
+			source_i = 0;
+		if(contiguous)
+		{
+			typename V::reg	re, im;
+			V::load_complex(s, re, im);
+			V::store_real(b, re);
+			V::store_real(b + lanes, im);
+			continue;
+		}
+		for(size_t l = 0; l < n; ++l)
+		{
+			b[l] = s[2*ptrdiff_t(l)*dist];
+			b[lanes + l] = s[2*ptrdiff_t(l)*dist + 1];
+		}
+		for(size_t l = n; l < lanes; ++l)
+		{
+			b[l] = 0;
+			b[lanes + l] = 0;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class V>
+void store_block(const typename V::real *block, typename V::real *dst, size_t size, size_t n,
+		ptrdiff_t stride, ptrdiff_t dist, size_t shift, typename V::real factor)
+{
+	using real = typename V::real;
+	constexpr size_t	lanes = V::lanes;
+	const bool	contiguous = dist == 1 && n == lanes;
+	const auto	f = V::set1(factor);
+	size_t	dest_i = shift % size;
+	for(size_t i = 0; i < size; ++i)
+	{
+		real	*d = dst + 2*ptrdiff_t(dest_i)*stride;
+		const real	*b = block + 2*lanes*i;
+		if(++dest_i == size)
+			dest_i = 0;
+		if(contiguous)
+		{
+			V::store_complex(d, V::mul(V::load_real(b), f), V::mul(V::load_real(b + lanes), f));
+			continue;
+		}
+		for(size_t l = 0; l < n; ++l)
+		{
+			d[2*ptrdiff_t(l)*dist] = b[l]*factor;
+			d[2*ptrdiff_t(l)*dist + 1] = b[lanes + l]*factor;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class V>
+Kernels<typename V::real> make_kernels(simd_instruction_set_t instruction_set)
+{
+	Kernels<typename V::real>	kernels = {instruction_set, V::lanes,
+			stockham_stage<V>, scale<V>, multiply<V>,
+			stockham_block_stage<V>, load_block<V>, store_block<V>};
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace
+
+} // namespace FFTSIMD
+
+XRAD_END
+
+//--------------------------------------------------------------
@@ -0,0 +1,119 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTSIMD_AVX2.cpp
+//--------------------------------------------------------------
+// Файл компилируется с ключами AVX2 и FMA (см. CMakeLists.txt, XRADBasic.vcxproj)
+// без предкомпилированного заголовка: код из других файлов не должен компилироваться с этими ключами.
+// Функции этого файла вызываются только при DetectedSIMDInstructionSet() >= e_simd_avx2.
+#include "FFTSIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <immintrin.h>
+#include "FFTSIMDKernels.hh"
+
+XRAD_BEGIN
+
+namespace FFTSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+/*!
+	\brief Регистр из 8 чисел float
+
+	Перестановка при чтении действует внутри 128-битных половин: вещественные части
+	отсчетов 0, 1, 4, 5, 2, 3, 6, 7. Запись восстанавливает исходный порядок.
+*/
+struct avx2_f32
+{
+	using real = float;
+	using reg = __m256;
+	static constexpr size_t	lanes = 8;
+
+	static reg set1(double x) { return _mm256_set1_ps(float(x)); }
+	static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+	static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+	static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+	static reg fmsub(reg a, reg b, reg c) { return _mm256_fmsub_ps(a, b, c); }
+	static reg load_real(const real *p) { return _mm256_loadu_ps(p); }
+	static void store_real(real *p, reg x) { _mm256_storeu_ps(p, x); }
+
+	static void load_complex(const real *p, reg &re, reg &im)
+	{
+		reg	a = _mm256_loadu_ps(p), b = _mm256_loadu_ps(p + 8);
+		re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	static void store_complex(real *p, reg re, reg im)
+	{
+		_mm256_storeu_ps(p, _mm256_unpacklo_ps(re, im));
+		_mm256_storeu_ps(p + 8, _mm256_unpackhi_ps(re, im));
+	}
+};
+
+//--------------------------------------------------------------
+
+//! \brief Регистр из 4 чисел double. Порядок отсчетов после чтения: 0, 2, 1, 3
+struct avx2_f64
+{
+	using real = double;
+	using reg = __m256d;
+	static constexpr size_t	lanes = 4;
+
+	static reg set1(double x) { return _mm256_set1_pd(x); }
+	static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+	static reg fmsub(reg a, reg b, reg c) { return _mm256_fmsub_pd(a, b, c); }
+	static reg load_real(const real *p) { return _mm256_loadu_pd(p); }
+	static void store_real(real *p, reg x) { _mm256_storeu_pd(p, x); }
+
+	static void load_complex(const real *p, reg &re, reg &im)
+	{
+		reg	a = _mm256_loadu_pd(p), b = _mm256_loadu_pd(p + 4);
+		re = _mm256_unpacklo_pd(a, b);
+		im = _mm256_unpackhi_pd(a, b);
+	}
+
+	static void store_complex(real *p, reg re, reg im)
+	{
+		_mm256_storeu_pd(p, _mm256_unpacklo_pd(re, im));
+		_mm256_storeu_pd(p + 4, _mm256_unpackhi_pd(re, im));
+	}
+};
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels<float> &KernelsF32_AVX2()
+{
+	static const Kernels<float>	kernels = make_kernels<avx2_f32>(e_simd_avx2);
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+const Kernels<double> &KernelsF64_AVX2()
+{
+	static const Kernels<double>	kernels = make_kernels<avx2_f64>(e_simd_avx2);
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace FFTSIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
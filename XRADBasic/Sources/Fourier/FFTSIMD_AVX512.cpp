@@ -0,0 +1,122 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTSIMD_AVX512.cpp
+//--------------------------------------------------------------
+// Файл компилируется с ключами AVX-512F (см. CMakeLists.txt, XRADBasic.vcxproj)
+// без предкомпилированного заголовка: код из других файлов не должен компилироваться с этими ключами.
+// Функции этого файла вызываются только при DetectedSIMDInstructionSet() >= e_simd_avx512.
+#include "FFTSIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <immintrin.h>
+#include "FFTSIMDKernels.hh"
+
+XRAD_BEGIN
+
+namespace FFTSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Регистр из 16 чисел float. Порядок отсчетов сохраняется
+struct avx512_f32
+{
+	using real = float;
+	using reg = __m512;
+	static constexpr size_t	lanes = 16;
+
+	static reg set1(double x) { return _mm512_set1_ps(float(x)); }
+	static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+	static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+	static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+	static reg fmsub(reg a, reg b, reg c) { return _mm512_fmsub_ps(a, b, c); }
+	static reg load_real(const real *p) { return _mm512_loadu_ps(p); }
+	static void store_real(real *p, reg x) { _mm512_storeu_ps(p, x); }
+
+	static void load_complex(const real *p, reg &re, reg &im)
+	{
+		const __m512i	even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+		const __m512i	odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+		reg	a = _mm512_loadu_ps(p), b = _mm512_loadu_ps(p + 16);
+		re = _mm512_permutex2var_ps(a, even, b);
+		im = _mm512_permutex2var_ps(a, odd, b);
+	}
+
+	static void store_complex(real *p, reg re, reg im)
+	{
+		const __m512i	low = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+		const __m512i	high = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+		_mm512_storeu_ps(p, _mm512_permutex2var_ps(re, low, im));
+		_mm512_storeu_ps(p + 16, _mm512_permutex2var_ps(re, high, im));
+	}
+};
+
+//--------------------------------------------------------------
+
+//! \brief Регистр из 8 чисел double. Порядок отсчетов сохраняется
+struct avx512_f64
+{
+	using real = double;
+	using reg = __m512d;
+	static constexpr size_t	lanes = 8;
+
+	static reg set1(double x) { return _mm512_set1_pd(x); }
+	static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+	static reg fmsub(reg a, reg b, reg c) { return _mm512_fmsub_pd(a, b, c); }
+	static reg load_real(const real *p) { return _mm512_loadu_pd(p); }
+	static void store_real(real *p, reg x) { _mm512_storeu_pd(p, x); }
+
+	static void load_complex(const real *p, reg &re, reg &im)
+	{
+		const __m512i	even = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+		const __m512i	odd = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+		reg	a = _mm512_loadu_pd(p), b = _mm512_loadu_pd(p + 8);
+		re = _mm512_permutex2var_pd(a, even, b);
+		im = _mm512_permutex2var_pd(a, odd, b);
+	}
+
+	static void store_complex(real *p, reg re, reg im)
+	{
+		const __m512i	low = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+		const __m512i	high = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+		_mm512_storeu_pd(p, _mm512_permutex2var_pd(re, low, im));
+		_mm512_storeu_pd(p + 8, _mm512_permutex2var_pd(re, high, im));
+	}
+};
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels<float> &KernelsF32_AVX512()
+{
+	static const Kernels<float>	kernels = make_kernels<avx512_f32>(e_simd_avx512);
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+const Kernels<double> &KernelsF64_AVX512()
+{
+	static const Kernels<double>	kernels = make_kernels<avx512_f64>(e_simd_avx512);
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace FFTSIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
@@ -0,0 +1,110 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file FFTSIMD_SSE2.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "FFTSIMD.h"
+
+#ifdef XRAD_CPU_X86
+
+#include <emmintrin.h>
+#include "FFTSIMDKernels.hh"
+
+XRAD_BEGIN
+
+namespace FFTSIMD
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+struct sse2_f32
+{
+	using real = float;
+	using reg = __m128;
+	static constexpr size_t	lanes = 4;
+
+	static reg set1(double x) { return _mm_set1_ps(float(x)); }
+	static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+	static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+	static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	static reg fmsub(reg a, reg b, reg c) { return _mm_sub_ps(_mm_mul_ps(a, b), c); }
+	static reg load_real(const real *p) { return _mm_loadu_ps(p); }
+	static void store_real(real *p, reg x) { _mm_storeu_ps(p, x); }
+
+	static void load_complex(const real *p, reg &re, reg &im)
+	{
+		reg	a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+		re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	static void store_complex(real *p, reg re, reg im)
+	{
+		_mm_storeu_ps(p, _mm_unpacklo_ps(re, im));
+		_mm_storeu_ps(p + 4, _mm_unpackhi_ps(re, im));
+	}
+};
+
+//--------------------------------------------------------------
+
+struct sse2_f64
+{
+	using real = double;
+	using reg = __m128d;
+	static constexpr size_t	lanes = 2;
+
+	static reg set1(double x) { return _mm_set1_pd(x); }
+	static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+	static reg fmsub(reg a, reg b, reg c) { return _mm_sub_pd(_mm_mul_pd(a, b), c); }
+	static reg load_real(const real *p) { return _mm_loadu_pd(p); }
+	static void store_real(real *p, reg x) { _mm_storeu_pd(p, x); }
+
+	static void load_complex(const real *p, reg &re, reg &im)
+	{
+		reg	a = _mm_loadu_pd(p), b = _mm_loadu_pd(p + 2);
+		re = _mm_unpacklo_pd(a, b);
+		im = _mm_unpackhi_pd(a, b);
+	}
+
+	static void store_complex(real *p, reg re, reg im)
+	{
+		_mm_storeu_pd(p, _mm_unpacklo_pd(re, im));
+		_mm_storeu_pd(p + 2, _mm_unpackhi_pd(re, im));
+	}
+};
+
+} // namespace
+
+//--------------------------------------------------------------
+
+const Kernels<float> &KernelsF32_SSE2()
+{
+	static const Kernels<float>	kernels = make_kernels<sse2_f32>(e_simd_sse2);
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+const Kernels<double> &KernelsF64_SSE2()
+{
+	static const Kernels<double>	kernels = make_kernels<sse2_f64>(e_simd_sse2);
+	return kernels;
+}
+
+//--------------------------------------------------------------
+
+} // namespace FFTSIMD
+
+XRAD_END
+
+#endif // XRAD_CPU_X86
@@ -18,7 +18,11 @@
 	#error Unknown FFT algorithm.
 #endif
 
+#include "MixedRadixFFT.h"
+#include <XRADBasic/Sources/Core/CPUFeatures.h>
 #include <XRADBasic/Sources/Containers/ComplexFunction.h>
+#include <map>
+#include <mutex>
 
 XRAD_BEGIN
 
@@ -26,18 +30,7 @@ XRAD_BEGIN
 
 size_t ceil_fft_length(size_t n)
 {
-#ifdef XRAD_FFT_CooleyTukey
-	auto result = CooleyTukeyFFT::fft_phasors.ceil_fft_length(n);
-	if (result < n)
-	{
-		throw length_error(ssprintf("FFT length is too large: %zu.", EnsureType<size_t>(n)));
-	}
-	return result;
-#elif defined (XRAD_FFT_Decomposition)
-	return DecompositionFFT::ceil_fft_length(n);
-#else
-	#error Unknown FFT algorithm.
-#endif
+	return MixedRadixFFT::ceil_fft_length(n);
 }
 
 //--------------------------------------------------------------
@@ -45,11 +38,7 @@ size_t ceil_fft_length(size_t n)
 void InitFourierTransform(size_t maximum_allowed_fft_length)
 {
 #ifdef XRAD_FFT_CooleyTukey
-	size_t	base = 2;
-	size_t	order = logn(maximum_allowed_fft_length, base);
-	if(pow(base, order) < maximum_allowed_fft_length)
-		++order;
-	CooleyTukeyFFT::fft_phasors.Initialize(base, order);
+	CooleyTukeyFFT::GetPhasors(maximum_allowed_fft_length);
 #elif defined (XRAD_FFT_Decomposition)
 	DecompositionFFT::InitializeFFT(maximum_allowed_fft_length);
 #else
@@ -59,6 +48,33 @@ void InitFourierTransform(size_t maximum_allowed_fft_length)
 
 //--------------------------------------------------------------
 
+namespace
+{
+
+//! \brief Длины 2^n вычисляются основным алгоритмом (см. XRAD_FFT_CooleyTukey, XRAD_FFT_Decomposition)
+//! только при отсутствии векторизованных ядер. Остальные длины, а при наличии SIMD и все длины,
+//! вычисляются MixedRadixFFT
+inline bool	use_mixed_radix_fft(size_t size)
+{
+	return (size & (size - 1)) || ActiveSIMDInstructionSet() != e_simd_none;
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+void PrepareFFT(size_t size)
+{
+	if(size <= 1)
+		return;
+	if(use_mixed_radix_fft(size))
+		MixedRadixFFT::Prepare(size);
+	else
+		InitFourierTransform(size);
+}
+
+//--------------------------------------------------------------
+
 namespace FFTPrimitives
 {
 
@@ -107,6 +123,11 @@ void	FFT_ptr(complexF32 *array, size_t size, ftDirection direction)
 {
 	if (size == 1)
 		return; // корректно: для функции из одного отсчета дпф ничего не меняет
+	if (use_mixed_radix_fft(size))
+	{
+		MixedRadixFFT::FFT(array, size, direction);
+		return;
+	}
 #ifdef XRAD_FFT_CooleyTukey
 	CooleyTukeyFFT::FTCT_F32.FFT(array, size, direction);
 #elif defined (XRAD_FFT_Decomposition)
@@ -120,6 +141,11 @@ void	FFT_ptr(complexF64 *array, size_t size, ftDirection direction)
 {
 	if (size == 1)
 		return; // корректно: для функции из одного отсчета дпф ничего не меняет
+	if (use_mixed_radix_fft(size))
+	{
+		MixedRadixFFT::FFT(array, size, direction);
+		return;
+	}
 #ifdef XRAD_FFT_CooleyTukey
 	CooleyTukeyFFT::FTCT_F64.FFT(array, size, direction);
 #elif defined (XRAD_FFT_Decomposition)
@@ -194,6 +220,268 @@ void	FFTf_ptr(complexF64 *array, size_t size, ft_flags flags)
 
 //--------------------------------------------------------------
 
+namespace
+{
+
+template<class T>
+void	FFTf_batch_template(T *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ft_flags flags)
+{
+	if(!size || !array || ((flags & fftFwd) && (flags & fftRev)))
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("FFTf_batch<%s>, size = %zu, flags=%X", typeid(T).name(),
+				EnsureType<size_t>(size), int(flags)));
+	}
+	const int	direction_flags = flags & fftDirectionMask;
+	if(direction_flags != fftNone && use_mixed_radix_fft(size))
+	{
+		// Сдвиги половины диапазона как в FFTf_template: roll_half(false) до и roll_half(true) после
+		const size_t	input_shift = (flags & fftRollBefore) ? (size + 1)/2 : 0;
+		const size_t	output_shift = (flags & fftRollAfter) ? size/2 : 0;
+		MixedRadixFFT::FFT_batch(array, size, count, stride, dist,
+				direction_flags == fftFwd ? ftForward : ftReverse, input_shift, output_shift);
+		return;
+	}
+	// Основной алгоритм длин 2^n: каждый сигнал отдельно
+	if(stride == 1)
+	{
+		for(size_t s = 0; s < count; ++s)
+			FFTf_template(array + ptrdiff_t(s)*dist, size, flags);
+		return;
+	}
+	// Сигналы с шагом переносятся в буфер группами: отсчеты с одним номером всех сигналов
+	// группы читаются подряд, если сигналы соседние (столбцы матрицы)
+	constexpr size_t	group_size = 16;
+	DataArray<T>	buffer(size*min(count, group_size));
+	T	*b = buffer.data();
+	for(size_t s0 = 0; s0 < count; s0 += group_size)
+	{
+		const size_t	n = min(group_size, count - s0);
+		T	*first = array + ptrdiff_t(s0)*dist;
+		for(size_t i = 0; i < size; ++i)
+		{
+			const T	*x = first + ptrdiff_t(i)*stride;
+			for(size_t s = 0; s < n; ++s)
+				b[s*size + i] = x[ptrdiff_t(s)*dist];
+		}
+		for(size_t s = 0; s < n; ++s)
+			FFTf_template(b + s*size, size, flags);
+		for(size_t i = 0; i < size; ++i)
+		{
+			T	*x = first + ptrdiff_t(i)*stride;
+			for(size_t s = 0; s < n; ++s)
+				x[ptrdiff_t(s)*dist] = b[s*size + i];
+		}
+	}
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+void	FFTf_batch(complexF32 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ft_flags flags)
+{
+	FFTf_batch_template(array, size, count, stride, dist, flags);
+}
+
+void	FFTf_batch(complexF64 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ft_flags flags)
+{
+	FFTf_batch_template(array, size, count, stride, dist, flags);
+}
+
+void	FFT_batch(complexF32 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ftDirection direction)
+{
+	FFTf_batch_template(array, size, count, stride, dist, direction == ftForward ? fftFwd : fftRev);
+}
+
+void	FFT_batch(complexF64 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ftDirection direction)
+{
+	FFTf_batch_template(array, size, count, stride, dist, direction == ftForward ? fftFwd : fftRev);
+}
+
+bool	FFTf_batch_vectorized(size_t size)
+{
+	// Условие векторизации по сигналам в MixedRadixFFT::FFT_batch(): есть ядра SIMD,
+	// длина раскладывается на множители 2, 3, 5, 7
+	return size > 1 && ActiveSIMDInstructionSet() != e_simd_none && ceil_fft_length(size) == size;
+}
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Множители exp(-2*pi*i*k/size), k = 0..size/2-1, для разделения спектров в FFTf_r2c_ptr, FFTf_c2r_ptr
+//!
+//! Таблицы вычисляются один раз для каждой длины. Последняя использованная таблица запоминается
+//! в каждом потоке, поэтому при повторных вызовах с той же длиной блокировка не требуется.
+template<class complex_t>
+const complex_t *real_fft_phasors(size_t size)
+{
+	using table_t = vector<complex_t>;
+	thread_local size_t last_size = 0;
+	thread_local shared_ptr<const table_t> last_table;
+	if(size == last_size)
+		return last_table->data();
+
+	static std::mutex mx;
+	static std::map<size_t, shared_ptr<const table_t>> tables;
+	std::lock_guard<std::mutex> lock(mx);
+	auto	&table = tables[size];
+	if(!table)
+	{
+		auto	new_table = make_shared<table_t>(size/2);
+		for(size_t k = 0; k < size/2; ++k)
+		{
+			(*new_table)[k] = polar(1., -two_pi()*double(k)/double(size));
+		}
+		table = new_table;
+	}
+	last_table = table;
+	last_size = size;
+	return table->data();
+}
+
+//! \brief Проверка аргументов и направление преобразования для FFTf_r2c_ptr, FFTf_c2r_ptr
+//!
+//! В отличие от FFTf_ptr() флаг направления обязателен: без преобразования половина спектра
+//! не описывает вещественный массив.
+ftDirection	real_fft_direction(const void *real, const void *spectrum, size_t size, ft_flags flags)
+{
+	switch(flags & fftDirectionMask)
+	{
+		case fftFwd:
+			if(real && spectrum && size && !(size%2))
+				return ftForward;
+			break;
+		case fftRev:
+			if(real && spectrum && size && !(size%2))
+				return ftReverse;
+			break;
+	}
+	ForceDebugBreak();
+	throw invalid_argument(ssprintf("Real FFT: invalid arguments, size = %zu, flags=%X",
+			EnsureType<size_t>(size), int(flags)));
+}
+
+//--------------------------------------------------------------
+
+template<class T, class ST>
+void	FFTf_r2c_template(const T *real, ComplexSample<T, ST> *spectrum, size_t size, ft_flags flags)
+{
+	using complex_t = ComplexSample<T, ST>;
+	const ftDirection	direction = real_fft_direction(real, spectrum, size, flags);
+	const size_t	half_size = size/2;
+
+	// Упаковка в комплексный массив половинной длины. Сдвиг исходных данных на половину диапазона
+	// выполняется здесь же выбором индексов. Сдвиг спектра на половину диапазона равносилен
+	// умножению исходных данных на (-1)^n, т.е. смене знака нечетных отсчетов.
+	const size_t	shift = (flags & fftRollBefore) ? half_size : 0;
+	const T	odd_sign = (flags & fftRollAfter) ? -1 : 1;
+	for(size_t m = 0; m < half_size; ++m)
+	{
+		size_t	n = (2*m + shift) % size;
+		spectrum[m] = complex_t(real[n], odd_sign*real[n + 1 < size ? n + 1 : 0]);
+	}
+
+	FFT_ptr(spectrum, half_size, direction);
+
+	// Разделение спектров четных (E) и нечетных (O) отсчетов:
+	// X[k] = (E[k] + w^k*O[k])/sqrt(2), X[N/2-k] = conj(E[k] - w^k*O[k])/sqrt(2),
+	// E[k] = (Z[k] + conj(Z[N/2-k]))/2, O[k] = (Z[k] - conj(Z[N/2-k]))/2i.
+	// Множитель 1/sqrt(2) согласует нормировку БПФ длины N/2 и N.
+	const complex_t	*phasors = real_fft_phasors<complex_t>(size);
+	const T	factor = T(sqrt(0.5));
+	const T	half_factor = T(0.5*sqrt(0.5));
+	const T	w_im_sign = direction == ftForward ? 1 : -1;
+
+	T	z0_re = spectrum[0].re, z0_im = spectrum[0].im;
+	spectrum[0] = complex_t(factor*(z0_re + z0_im));
+	spectrum[half_size] = complex_t(factor*(z0_re - z0_im));
+
+	for(size_t k = 1, k2 = half_size - 1; k <= k2; ++k, --k2)
+	{
+		const complex_t	a = spectrum[k], b = spectrum[k2];
+		// 2E = a + conj(b), 2O = (a - conj(b))/i
+		T	e_re = a.re + b.re, e_im = a.im - b.im;
+		T	o_re = a.im + b.im, o_im = b.re - a.re;
+		T	w_re = phasors[k].re, w_im = w_im_sign*phasors[k].im;
+		T	wo_re = w_re*o_re - w_im*o_im;
+		T	wo_im = w_re*o_im + w_im*o_re;
+		spectrum[k2] = complex_t(half_factor*(e_re - wo_re), -half_factor*(e_im - wo_im));
+		spectrum[k] = complex_t(half_factor*(e_re + wo_re), half_factor*(e_im + wo_im));
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class T, class ST>
+void	FFTf_c2r_template(const ComplexSample<T, ST> *spectrum, T *real, size_t size, ft_flags flags)
+{
+	using complex_t = ComplexSample<T, ST>;
+	const ftDirection	direction = real_fft_direction(real, spectrum, size, flags);
+	const size_t	half_size = size/2;
+
+	// Вещественный массив длины size используется как рабочий комплексный массив длины size/2:
+	// после обратной упаковки z[m] = real[2m] + i*real[2m+1] данные оказываются на своих местах.
+	complex_t	*buffer = reinterpret_cast<complex_t*>(real);
+	static_assert(sizeof(complex_t) == 2*sizeof(T), "Unexpected ComplexSample layout.");
+
+	// Z[k] = ((X[k] + conj(X[N/2-k])) + i*w^k*(X[k] - conj(X[N/2-k])))/sqrt(2)
+	const complex_t	*phasors = real_fft_phasors<complex_t>(size);
+	const T	factor = T(sqrt(0.5));
+	const T	w_im_sign = direction == ftForward ? 1 : -1;
+	for(size_t k = 0; k < half_size; ++k)
+	{
+		const complex_t	&a = spectrum[k], &b = spectrum[half_size - k];
+		T	e_re = a.re + b.re, e_im = a.im - b.im;
+		T	d_re = a.re - b.re, d_im = a.im + b.im;
+		T	w_re = phasors[k].re, w_im = w_im_sign*phasors[k].im;
+		// i*w^k*d
+		T	iwd_re = -(w_re*d_im + w_im*d_re);
+		T	iwd_im = w_re*d_re - w_im*d_im;
+		buffer[k] = complex_t(factor*(e_re + iwd_re), factor*(e_im + iwd_im));
+	}
+	FFT_ptr(buffer, half_size, direction);
+
+	// Сдвиг спектра на половину диапазона до преобразования равносилен умножению результата на (-1)^n
+	if(flags & fftRollBefore)
+	{
+		for(size_t n = 1; n < size; n += 2)
+			real[n] = -real[n];
+	}
+	if(flags & fftRollAfter)
+	{
+		std::swap_ranges(real, real + half_size, real + half_size);
+	}
+}
+
+} // namespace
+
+//--------------------------------------------------------------
+
+void	FFTf_r2c_ptr(const float *real, complexF32 *spectrum, size_t size, ft_flags flags)
+{
+	FFTf_r2c_template(real, spectrum, size, flags);
+}
+
+void	FFTf_r2c_ptr(const double *real, complexF64 *spectrum, size_t size, ft_flags flags)
+{
+	FFTf_r2c_template(real, spectrum, size, flags);
+}
+
+void	FFTf_c2r_ptr(const complexF32 *spectrum, float *real, size_t size, ft_flags flags)
+{
+	FFTf_c2r_template(spectrum, real, size, flags);
+}
+
+void	FFTf_c2r_ptr(const complexF64 *spectrum, double *real, size_t size, ft_flags flags)
+{
+	FFTf_c2r_template(spectrum, real, size, flags);
+}
+
+//--------------------------------------------------------------
+
 }//namespace FFTPrimitives
 
 //--------------------------------------------------------------
@@ -42,21 +42,33 @@ XRAD_BEGIN
 
 //--------------------------------------------------------------
 
-//! \brief Ближайшая длина FFT, >= n
+//! \brief Ближайшая длина FFT, >= n, для которой преобразование выполняется наиболее эффективно
 //!
+//! FFT_ptr() принимает любую длину, но длины вида 2^a*3^b*5^c*7^d вычисляются быстрее
+//! (см. MixedRadixFFT). Результат может быть нечетным.
 //! Кидает исключение, если подобрать такую длину невозможно (слишком большая длина).
 size_t ceil_fft_length(size_t n);
 
 //--------------------------------------------------------------
 
 /*!
-	\brief Инициализировать структуры данных FFT для длин <= maximum_allowed_fft_length
+	\brief Заранее создать таблицы основного алгоритма FFT для длин 2^n <= maximum_allowed_fft_length
 
-	Эту функцию следует вызывать только в том случае, если понадобится
-	максимальная длина преобразования, превышающая 64k отсчетов.
+	Вызывать эту функцию необязательно: таблицы для каждой длины создаются при первом
+	преобразовании этой длины, ограничения на максимальную длину нет. При запуске программы
+	модуль FFT ничего не вычисляет. Функция позволяет перенести создание таблиц из первого
+	вызова FFT (например, из цикла обработки) на этап подготовки.
 */
 void InitFourierTransform(size_t maximum_allowed_fft_length);
 
+/*!
+	\brief Заранее создать все таблицы, используемые FFTPrimitives::FFT_ptr() для длины size
+
+	Вызов необязателен, см. InitFourierTransform(). Учитывает выбор алгоритма для длины
+	(основной алгоритм или MixedRadixFFT), таблицы создаются для complexF32 и complexF64.
+*/
+void PrepareFFT(size_t size);
+
 
 
 //--------------------------------------------------------------
@@ -68,7 +80,11 @@ namespace FFTPrimitives
 
 //--------------------------------------------------------------
 //
-// быстрое фурье-преобразование длины 2^n
+// быстрое фурье-преобразование произвольной длины.
+// длины 2^n вычисляются основным алгоритмом,
+// остальные длины -- разложением на множители 2, 3, 5, 7 и алгоритмом Блюстейна (см. MixedRadixFFT.h).
+// если процессор поддерживает SSE2/AVX2/AVX-512 (см. ActiveSIMDInstructionSet()), все длины
+// вычисляются векторизованной реализацией MixedRadixFFT
 //
 void FFT_ptr(complexF32 *array, size_t size, ftDirection direction);
 void FFT_ptr(complexF64 *array, size_t size, ftDirection direction);
@@ -86,6 +102,68 @@ void FT_ptr(complexF64 *array, size_t size, ftDirection direction);
 void FFTf_ptr(complexF32 *array, size_t size, ft_flags flags);
 void FFTf_ptr(complexF64 *array, size_t size, ft_flags flags);
 
+//--------------------------------------------------------------
+/*!
+	\brief Пакетное быстрое фурье-преобразование count сигналов длины size
+
+	Результат совпадает с вызовом FFTf_ptr() для каждого сигнала. Отсчет i сигнала s
+	находится в array[s*dist + i*stride], шаги могут быть отрицательными. Таблицы и буферы
+	общие для всех сигналов, сдвиги половины диапазона выполняются при переносе данных.
+	Если отсчеты сигнала идут с шагом (например, столбцы матрицы), при наличии SIMD
+	несколько сигналов вычисляются одновременно (см. MixedRadixFFT::FFT_batch()).
+
+	Функция однопоточная: распределение пакетов по потокам выполняет вызывающий код
+	(см. FFT2D.h, FFTMD.h).
+*/
+void FFTf_batch(complexF32 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ft_flags flags);
+void FFTf_batch(complexF64 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ft_flags flags);
+
+//! \brief Пакетное FFT без сдвигов половины диапазона, см. FFTf_batch()
+void FFT_batch(complexF32 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ftDirection direction);
+void FFT_batch(complexF64 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist, ftDirection direction);
+
+/*!
+	\brief Преобразует ли FFTf_batch() сигналы длины size с шагом stride != 1 на месте,
+	группами в векторных регистрах
+
+	Если нет, каждый сигнал с шагом копируется в буфер и обратно. Вызывающий код может
+	собрать сигналы в непрерывный буфер сам, если это удобнее (см. FFTMD.h).
+*/
+bool FFTf_batch_vectorized(size_t size);
+
+//--------------------------------------------------------------
+/*!
+	\brief Быстрое фурье-преобразование вещественного массива (real-to-complex)
+
+	Результат совпадает с первыми size/2+1 отсчетами FFTf_ptr() от комплексного массива
+	с мнимой частью, равной нулю. Остальные отсчеты спектра комплексно сопряжены им
+	и не вычисляются: spectrum[size-k] == ~spectrum[k].
+
+	Преобразование сводится к комплексному БПФ длины size/2 от массива
+	z[m] = real[2m] + i*real[2m+1] с последующим разделением четной и нечетной частей,
+	поэтому требует вдвое меньше вычислений и памяти, чем комплексное БПФ длины size.
+
+	\param real Вещественный массив длины size. Не изменяется
+	\param spectrum Массив длины size/2+1 для результата
+	\param size Четная длина, size/2 должна быть допустимой длиной FFT_ptr()
+	\param flags Флаги направления и сдвигов половины диапазона (см. FFTf_ptr())
+*/
+void FFTf_r2c_ptr(const float *real, complexF32 *spectrum, size_t size, ft_flags flags);
+void FFTf_r2c_ptr(const double *real, complexF64 *spectrum, size_t size, ft_flags flags);
+
+/*!
+	\brief Быстрое фурье-преобразование эрмитова спектра в вещественный массив (complex-to-real)
+
+	Преобразование, обратное FFTf_r2c_ptr(). Результат совпадает с вещественной частью
+	FFTf_ptr() от полного спектра длины size, восстановленного по первым size/2+1 отсчетам
+	из условия эрмитовости.
+
+	\param spectrum Массив длины size/2+1. Не изменяется
+	\param real Вещественный массив длины size для результата
+*/
+void FFTf_c2r_ptr(const complexF32 *spectrum, float *real, size_t size, ft_flags flags);
+void FFTf_c2r_ptr(const complexF64 *spectrum, double *real, size_t size, ft_flags flags);
+
 //--------------------------------------------------------------
 
 }//namespace FFTPrimitives
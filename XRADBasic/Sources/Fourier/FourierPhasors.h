@@ -35,7 +35,7 @@ public:
 	Phasors(size_t base, size_t max_order);
 
 	void	Initialize(size_t base, size_t max_order);
-	size_t	max_FFT_size(size_t FT_base);
+	static size_t	max_FFT_size(size_t FT_base);
 	size_t	ceil_fft_length(size_t) const;
 	size_t	max_fft_length() const { return m_max_fft_length; };
 	bool	is_allowed_fft_length(size_t size) const { return !(size % fft_base); }
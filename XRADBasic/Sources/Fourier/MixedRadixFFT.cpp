@@ -0,0 +1,673 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MixedRadixFFT.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+
+#include "MixedRadixFFT.h"
+#include "WinogradShortFFT.h"
+#include "FFTSIMD.h"
+#include <map>
+#include <mutex>
+
+XRAD_BEGIN
+
+namespace MixedRadixFFT
+{
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+//! \brief Наибольший простой множитель длины, для которого используется прямое ДПФ.
+//! Длины с большими простыми множителями вычисляются алгоритмом Блюстейна
+constexpr size_t max_generic_radix = 31;
+
+//--------------------------------------------------------------
+
+//! \brief Один проход схемы Стокхэма: radix преобразований длины radix с шагом входных данных size/radix
+struct Stage
+{
+	//! \brief Длина ядра
+	size_t	radix;
+	//! \brief Произведение длин ядер предыдущих проходов
+	size_t	span;
+	//! \brief Смещение множителей прохода в общей таблице: (radix-1)*span значений,
+	//! множитель для отсчета r и индекса k имеет номер (r-1)*span + k
+	size_t	twiddles_offset;
+	//! \brief Смещение корней exp(-2*pi*i*k/radix) для прямого ДПФ (только для radix без специального ядра)
+	size_t	roots_offset;
+};
+
+//--------------------------------------------------------------
+
+// Векторизованные ядра (FFTSIMD.h) работают с отсчетами как с парами вещественных чисел
+static_assert(sizeof(complexF32) == 2*sizeof(float), "complexF32 layout");
+static_assert(sizeof(complexF64) == 2*sizeof(double), "complexF64 layout");
+
+template<class complex_t>
+inline typename complex_t::part_type *parts(complex_t *x)
+{
+	return reinterpret_cast<typename complex_t::part_type*>(x);
+}
+
+template<class complex_t>
+inline const typename complex_t::part_type *parts(const complex_t *x)
+{
+	return reinterpret_cast<const typename complex_t::part_type*>(x);
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t, bool forward>
+inline complex_t multiply_phasor(const complex_t &x, const complex_t &w)
+{
+	if(forward)
+		return complex_t(x.re*w.re - x.im*w.im, x.re*w.im + x.im*w.re);
+	else
+		return complex_t(x.re*w.re + x.im*w.im, x.im*w.re - x.re*w.im);
+}
+
+//--------------------------------------------------------------
+
+//! \brief Ядро для radix без специальной реализации: прямое ДПФ, O(radix^2)
+template<class complex_t, bool forward>
+inline void generic_dft(complex_t *v, size_t radix, const complex_t *roots)
+{
+	complex_t	result[max_generic_radix];
+	for(size_t k = 0; k < radix; ++k)
+	{
+		complex_t	sum = v[0];
+		for(size_t r = 1, kr = k; r < radix; ++r, kr = (kr + k)%radix)
+		{
+			sum += multiply_phasor<complex_t, forward>(v[r], roots[kr]);
+		}
+		result[k] = sum;
+	}
+	std::copy(result, result + radix, v);
+}
+
+//--------------------------------------------------------------
+
+template<size_t radix, class complex_t>
+inline void short_fft(complex_t *v, ftDirection direction)
+{
+	switch(radix)
+	{
+		case 2: WinogradFFT::fft_2(v, direction); break;
+		case 3: WinogradFFT::fft_3(v, direction); break;
+		case 4: WinogradFFT::fft_4(v, direction); break;
+		case 5: WinogradFFT::fft_5(v, direction); break;
+		case 7: WinogradFFT::fft_7(v, direction); break;
+		case 8: WinogradFFT::fft_8(v, direction); break;
+	}
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Проход схемы Стокхэма
+
+	Для j = q*span + k (k < span) читаются отсчеты in[j + r*size/radix], r = 0..radix-1,
+	умножаются на exp(-2*pi*i*r*k/(span*radix)), преобразуются ядром длины radix
+	и записываются в out[q*span*radix + k + r*span].
+*/
+template<size_t radix, bool forward, class complex_t>
+void stockham_stage(const complex_t *in, complex_t *out, size_t size, size_t span,
+		const complex_t *twiddles, const complex_t *roots, size_t runtime_radix)
+{
+	const size_t	n_radix = radix ? radix : runtime_radix;
+	const size_t	stride = size/n_radix;
+	const ftDirection	direction = forward ? ftForward : ftReverse;
+	complex_t	v[radix ? radix : max_generic_radix];
+
+	for(size_t j0 = 0; j0 < stride; j0 += span)
+	{
+		const complex_t	*src = in + j0;
+		complex_t	*dst = out + j0*n_radix;
+		for(size_t k = 0; k < span; ++k)
+		{
+			v[0] = src[k];
+			for(size_t r = 1; r < n_radix; ++r)
+			{
+				v[r] = multiply_phasor<complex_t, forward>(src[k + r*stride], twiddles[(r - 1)*span + k]);
+			}
+			if(radix)
+				short_fft<radix>(v, direction);
+			else
+				generic_dft<complex_t, forward>(v, n_radix, roots);
+			for(size_t r = 0; r < n_radix; ++r)
+			{
+				dst[k + r*span] = v[r];
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+template<bool forward, class complex_t>
+void stockham_stage(const complex_t *in, complex_t *out, size_t size, const Stage &stage,
+		const complex_t *twiddles, const complex_t *roots)
+{
+	const complex_t	*stage_twiddles = twiddles + stage.twiddles_offset;
+	const complex_t	*stage_roots = roots + stage.roots_offset;
+	switch(stage.radix)
+	{
+		case 2: stockham_stage<2, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, 2); break;
+		case 3: stockham_stage<3, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, 3); break;
+		case 4: stockham_stage<4, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, 4); break;
+		case 5: stockham_stage<5, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, 5); break;
+		case 7: stockham_stage<7, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, 7); break;
+		case 8: stockham_stage<8, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, 8); break;
+		default: stockham_stage<0, forward>(in, out, size, stage.span, stage_twiddles, stage_roots, stage.radix); break;
+	}
+}
+
+//--------------------------------------------------------------
+
+bool	has_special_kernel(size_t radix)
+{
+	switch(radix)
+	{
+		case 2: case 3: case 4: case 5: case 7: case 8:
+			return true;
+	}
+	return false;
+}
+
+//--------------------------------------------------------------
+
+//! \brief Разложить длину на множители схемы Стокхэма.
+//! \return false, если есть простой множитель больше max_generic_radix
+bool	factorize(size_t size, vector<size_t> &radices)
+{
+	radices.clear();
+	for(size_t radix: {8, 4, 2, 3, 5, 7})
+	{
+		while(size%radix == 0)
+		{
+			radices.push_back(radix);
+			size /= radix;
+		}
+	}
+	for(size_t radix = 11; size > 1 && radix <= max_generic_radix; radix += 2)
+	{
+		while(size%radix == 0)
+		{
+			radices.push_back(radix);
+			size /= radix;
+		}
+	}
+	return size == 1;
+}
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Таблицы для БПФ заданной длины
+
+	Для длин, раскладывающихся на множители не больше max_generic_radix, хранит проходы схемы
+	Стокхэма и их множители. Для остальных длин хранит данные алгоритма Блюстейна:
+	X[k] = c[k] * sum_n (x[n]*c[n]) * conj(c[k-n]), c[n] = exp(-pi*i*n^2/size).
+	Свертка вычисляется через БПФ длины convolution_size >= 2*size-1.
+*/
+template<class complex_t>
+class Plan
+{
+	public:
+		Plan(size_t size);
+
+		size_t	scratch_size() const { return is_bluestein() ? 2*convolution_size : size; }
+
+		//! \brief Преобразование на месте. Буфер scratch должен иметь длину не меньше scratch_size()
+		void	FFT(complex_t *data, complex_t *scratch, ftDirection direction) const;
+
+		//! \brief Все проходы имеют векторизованные ядра (длина вида 2^a*3^b*5^c*7^d)
+		bool	has_only_special_kernels() const;
+
+		/*!
+			\brief Преобразование блока сигналов без нормировки (см. FFTSIMD::Kernels::load_block)
+
+			Блок и буфер block_scratch имеют длину size*kernels.lanes комплексных отсчетов.
+			Требуется has_only_special_kernels().
+
+			\return Указатель на результат: block или block_scratch
+		*/
+		complex_t	*FFT_block(complex_t *block, complex_t *block_scratch,
+				const FFTSIMD::Kernels<typename complex_t::part_type> &kernels, bool forward) const;
+
+	private:
+		bool	is_bluestein() const { return convolution_size != 0; }
+
+		template<bool forward>
+		void	stockham_fft(complex_t *data, complex_t *scratch) const;
+
+		void	bluestein_fft(complex_t *data, complex_t *scratch, ftDirection direction) const;
+
+	private:
+		size_t	size;
+		vector<Stage>	stages;
+		vector<complex_t>	twiddles;
+		vector<complex_t>	roots;
+
+		size_t	convolution_size = 0;
+		shared_ptr<const Plan>	convolution_plan;
+		vector<complex_t>	chirp;
+		vector<complex_t>	chirp_spectrum;
+};
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+shared_ptr<const Plan<complex_t>> GetPlan(size_t size)
+{
+	thread_local size_t	last_size = 0;
+	thread_local shared_ptr<const Plan<complex_t>>	last_plan;
+	if(size == last_size)
+		return last_plan;
+
+	static std::mutex	mx;
+	static std::map<size_t, shared_ptr<const Plan<complex_t>>>	plans;
+	shared_ptr<const Plan<complex_t>>	plan;
+	{
+		std::lock_guard<std::mutex>	lock(mx);
+		auto	it = plans.find(size);
+		if(it != plans.end())
+			plan = it->second;
+	}
+	if(!plan)
+	{
+		// Создание таблиц выполняется без блокировки: таблицы Блюстейна запрашивают план другой длины
+		auto	new_plan = make_shared<const Plan<complex_t>>(size);
+		std::lock_guard<std::mutex>	lock(mx);
+		plan = plans.emplace(size, new_plan).first->second;
+	}
+	last_plan = plan;
+	last_size = size;
+	return plan;
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+complex_t	*GetScratch(size_t scratch_size)
+{
+	thread_local vector<complex_t>	scratch;
+	if(scratch.size() < scratch_size)
+	{
+		scratch.clear();
+		scratch.shrink_to_fit();
+		scratch.resize(scratch_size);
+	}
+	return scratch.data();
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+Plan<complex_t>::Plan(size_t in_size):
+	size(in_size)
+{
+	vector<size_t>	radices;
+	if(factorize(size, radices))
+	{
+		size_t	span = 1;
+		for(size_t radix: radices)
+		{
+			Stage	stage = {radix, span, twiddles.size(), roots.size()};
+			for(size_t r = 1; r < radix; ++r)
+			{
+				for(size_t k = 0; k < span; ++k)
+				{
+					twiddles.push_back(polar(1., -two_pi()*double(r*k)/double(span*radix)));
+				}
+			}
+			if(!has_special_kernel(radix))
+			{
+				for(size_t k = 0; k < radix; ++k)
+				{
+					roots.push_back(polar(1., -two_pi()*double(k)/double(radix)));
+				}
+			}
+			stages.push_back(stage);
+			span *= radix;
+		}
+		return;
+	}
+
+	// Алгоритм Блюстейна
+	if(size > (numeric_limits<size_t>::max() >> 2))
+		throw length_error(ssprintf("FFT length is too large: %zu.", EnsureType<size_t>(size)));
+	convolution_size = ceil_fft_length(2*size - 1);
+	convolution_plan = GetPlan<complex_t>(convolution_size);
+
+	// c[n] = exp(-pi*i*n^2/size), n^2 вычисляется по модулю 2*size без переполнения
+	chirp.resize(size);
+	const size_t	period = 2*size;
+	for(size_t n = 0, n2 = 0; n < size; ++n)
+	{
+		chirp[n] = polar(1., -pi()*double(n2)/double(size));
+		n2 = (n2 + 2*n + 1)%period;
+	}
+
+	// Спектр ядра свертки conj(c[m]), m = -(size-1)..size-1, с учетом нормировки:
+	// свертка равна sqrt(convolution_size)*IFFT(FFT(a)*FFT(b)), результат умножается на 1/sqrt(size)
+	chirp_spectrum.assign(convolution_size, complex_t(0));
+	chirp_spectrum[0] = ~chirp[0];
+	for(size_t m = 1; m < size; ++m)
+	{
+		chirp_spectrum[m] = chirp_spectrum[convolution_size - m] = ~chirp[m];
+	}
+	vector<complex_t>	scratch(convolution_plan->scratch_size());
+	convolution_plan->FFT(chirp_spectrum.data(), scratch.data(), ftForward);
+	const double	factor = sqrt(double(convolution_size)/double(size));
+	for(auto &c: chirp_spectrum)
+	{
+		c *= factor;
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+template<bool forward>
+void	Plan<complex_t>::stockham_fft(complex_t *data, complex_t *scratch) const
+{
+	const auto	*kernels = FFTSIMD::ActiveKernels<typename complex_t::part_type>();
+	complex_t	*in = data, *out = scratch;
+	for(auto &stage: stages)
+	{
+		if(!kernels || !kernels->stockham_stage(parts(in), parts(out), size, stage.radix, stage.span,
+				parts(twiddles.data() + stage.twiddles_offset), forward))
+		{
+			stockham_stage<forward>(in, out, size, stage, twiddles.data(), roots.data());
+		}
+		std::swap(in, out);
+	}
+	const double	factor = 1./sqrt(double(size));
+	if(kernels)
+	{
+		kernels->scale(parts(in), parts(data), size, typename complex_t::part_type(factor));
+	}
+	else if(in == data)
+	{
+		for(size_t i = 0; i < size; ++i)
+			data[i] *= factor;
+	}
+	else
+	{
+		for(size_t i = 0; i < size; ++i)
+			data[i] = in[i]*factor;
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+void	Plan<complex_t>::bluestein_fft(complex_t *data, complex_t *scratch, ftDirection direction) const
+{
+	// Обратное преобразование выражается через прямое: IFFT(x) = conj(FFT(conj(x)))
+	const auto	*kernels = FFTSIMD::ActiveKernels<typename complex_t::part_type>();
+	complex_t	*convolution = scratch;
+	complex_t	*convolution_scratch = scratch + convolution_size;
+	if(direction == ftForward && kernels)
+	{
+		kernels->multiply(parts(data), parts(chirp.data()), parts(convolution), size);
+	}
+	else if(direction == ftForward)
+	{
+		for(size_t n = 0; n < size; ++n)
+			convolution[n] = multiply_phasor<complex_t, true>(data[n], chirp[n]);
+	}
+	else
+	{
+		for(size_t n = 0; n < size; ++n)
+			convolution[n] = multiply_phasor<complex_t, true>(~data[n], chirp[n]);
+	}
+	std::fill(convolution + size, convolution + convolution_size, complex_t(0));
+
+	convolution_plan->FFT(convolution, convolution_scratch, ftForward);
+	if(kernels)
+	{
+		kernels->multiply(parts(convolution), parts(chirp_spectrum.data()), parts(convolution),
+				convolution_size);
+	}
+	else
+	{
+		for(size_t m = 0; m < convolution_size; ++m)
+		{
+			convolution[m] = multiply_phasor<complex_t, true>(convolution[m], chirp_spectrum[m]);
+		}
+	}
+	convolution_plan->FFT(convolution, convolution_scratch, ftReverse);
+
+	if(direction == ftForward && kernels)
+	{
+		kernels->multiply(parts(convolution), parts(chirp.data()), parts(data), size);
+	}
+	else if(direction == ftForward)
+	{
+		for(size_t k = 0; k < size; ++k)
+			data[k] = multiply_phasor<complex_t, true>(convolution[k], chirp[k]);
+	}
+	else
+	{
+		for(size_t k = 0; k < size; ++k)
+			data[k] = ~multiply_phasor<complex_t, true>(convolution[k], chirp[k]);
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+void	Plan<complex_t>::FFT(complex_t *data, complex_t *scratch, ftDirection direction) const
+{
+	if(is_bluestein())
+		bluestein_fft(data, scratch, direction);
+	else if(direction == ftForward)
+		stockham_fft<true>(data, scratch);
+	else
+		stockham_fft<false>(data, scratch);
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+bool	Plan<complex_t>::has_only_special_kernels() const
+{
+	if(is_bluestein())
+		return false;
+	for(auto &stage: stages)
+	{
+		if(!has_special_kernel(stage.radix))
+			return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+complex_t	*Plan<complex_t>::FFT_block(complex_t *block, complex_t *block_scratch,
+		const FFTSIMD::Kernels<typename complex_t::part_type> &kernels, bool forward) const
+{
+	complex_t	*in = block, *out = block_scratch;
+	for(auto &stage: stages)
+	{
+		kernels.stockham_block_stage(parts(in), parts(out), size, stage.radix, stage.span,
+				parts(twiddles.data() + stage.twiddles_offset), forward);
+		std::swap(in, out);
+	}
+	return in;
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+void	FFT_template(complex_t *array, size_t size, ftDirection direction)
+{
+	if(!array || !size)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("MixedRadixFFT::FFT: invalid arguments, size = %zu.",
+				EnsureType<size_t>(size)));
+	}
+	if(size == 1)
+		return;
+	auto	plan = GetPlan<complex_t>(size);
+	plan->FFT(array, GetScratch<complex_t>(plan->scratch_size()), direction);
+}
+
+//--------------------------------------------------------------
+
+template<class complex_t>
+void	FFT_batch_template(complex_t *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist,
+		ftDirection direction, size_t input_shift, size_t output_shift)
+{
+	if(!array || !size)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("MixedRadixFFT::FFT_batch: invalid arguments, size = %zu.",
+				EnsureType<size_t>(size)));
+	}
+	if(size == 1 || !count)
+		return;
+	input_shift %= size;
+	output_shift %= size;
+
+	using part_t = typename complex_t::part_type;
+	auto	plan = GetPlan<complex_t>(size);
+	const auto	*kernels = FFTSIMD::ActiveKernels<part_t>();
+	// Сигналы, отсчеты которых идут подряд, выгоднее преобразовывать по одному (векторизация
+	// внутри сигнала). Для остальных данные одного отсчета нескольких сигналов собираются
+	// в регистр, и все сигналы группы преобразуются одновременно
+	const size_t	lanes = kernels && stride != 1 && plan->has_only_special_kernels() ? kernels->lanes : 0;
+	const size_t	block_size = lanes*size;
+
+	complex_t	*block = GetScratch<complex_t>(2*block_size + size + plan->scratch_size());
+	complex_t	*block_scratch = block + block_size;
+	complex_t	*signal = block_scratch + block_size;
+	complex_t	*scratch = signal + size;
+
+	size_t	s = 0;
+	if(lanes)
+	{
+		// Неполную группу имеет смысл обрабатывать вместе, если она заполнена хотя бы наполовину
+		const part_t	factor = part_t(1./sqrt(double(size)));
+		for(; s < count && 2*(count - s) >= lanes; s += lanes)
+		{
+			const size_t	n = min(lanes, count - s);
+			complex_t	*first = array + ptrdiff_t(s)*dist;
+			kernels->load_block(parts(first), size, n, stride, dist, input_shift, parts(block));
+			const complex_t	*result = plan->FFT_block(block, block_scratch, *kernels, direction == ftForward);
+			kernels->store_block(parts(result), parts(first), size, n, stride, dist, output_shift, factor);
+		}
+	}
+	const bool	in_place = stride == 1 && !input_shift && !output_shift;
+	for(; s < count; ++s)
+	{
+		complex_t	*x = array + ptrdiff_t(s)*dist;
+		if(in_place)
+		{
+			plan->FFT(x, scratch, direction);
+			continue;
+		}
+		for(size_t i = 0, j = input_shift ? size - input_shift : 0; i < size; ++i)
+		{
+			signal[i] = x[ptrdiff_t(j)*stride];
+			if(++j == size)
+				j = 0;
+		}
+		plan->FFT(signal, scratch, direction);
+		for(size_t i = 0, j = output_shift; i < size; ++i)
+		{
+			x[ptrdiff_t(j)*stride] = signal[i];
+			if(++j == size)
+				j = 0;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+
+} // namespace
+
+//--------------------------------------------------------------
+
+size_t ceil_fft_length(size_t length)
+{
+	if(length <= 1)
+		return 1;
+	if(length > (numeric_limits<size_t>::max() >> 1))
+		throw length_error(ssprintf("FFT length is too large: %zu.", EnsureType<size_t>(length)));
+	// Перебираем 3^b*5^c*7^d, меньшие ближайшей степени 2, и домножаем на минимальную
+	// подходящую степень 2. Сама степень 2 не меньше length всегда подходит.
+	const size_t	power_of_2 = ceil_power_of_2(length);
+	size_t	best = power_of_2;
+	for(size_t p7 = 1; p7 < power_of_2; p7 = p7 <= power_of_2/7 ? p7*7 : power_of_2)
+	{
+		for(size_t p75 = p7; p75 < power_of_2; p75 = p75 <= power_of_2/5 ? p75*5 : power_of_2)
+		{
+			for(size_t p753 = p75; p753 < power_of_2; p753 = p753 <= power_of_2/3 ? p753*3 : power_of_2)
+			{
+				size_t	candidate = p753;
+				while(candidate < length)
+					candidate <<= 1;
+				if(candidate < best)
+					best = candidate;
+			}
+		}
+	}
+	return best;
+}
+
+//--------------------------------------------------------------
+
+void Prepare(size_t size)
+{
+	if(size <= 1)
+		return;
+	GetPlan<complexF32>(size);
+	GetPlan<complexF64>(size);
+}
+
+//--------------------------------------------------------------
+
+void FFT(complexF32 *array, size_t size, ftDirection direction)
+{
+	FFT_template(array, size, direction);
+}
+
+//--------------------------------------------------------------
+
+void FFT(complexF64 *array, size_t size, ftDirection direction)
+{
+	FFT_template(array, size, direction);
+}
+
+//--------------------------------------------------------------
+
+void FFT_batch(complexF32 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist,
+		ftDirection direction, size_t input_shift, size_t output_shift)
+{
+	FFT_batch_template(array, size, count, stride, dist, direction, input_shift, output_shift);
+}
+
+//--------------------------------------------------------------
+
+void FFT_batch(complexF64 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist,
+		ftDirection direction, size_t input_shift, size_t output_shift)
+{
+	FFT_batch_template(array, size, count, stride, dist, direction, input_shift, output_shift);
+}
+
+//--------------------------------------------------------------
+
+} // namespace MixedRadixFFT
+
+XRAD_END
@@ -0,0 +1,87 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MixedRadixFFT.h
+//--------------------------------------------------------------
+#ifndef XRAD__MixedRadixFFT_h
+#define XRAD__MixedRadixFFT_h
+//--------------------------------------------------------------
+
+#include "FourierDefs.h"
+#include <XRADBasic/Sources/SampleTypes/ComplexSample.h>
+
+XRAD_BEGIN
+
+/*!
+	\brief БПФ произвольной длины
+
+	Длина раскладывается на множители 8, 4, 2, 3, 5, 7 (ядра из WinogradShortFFT.h)
+	и небольшие простые множители (прямое ДПФ соответствующей длины). Преобразование выполняется
+	по схеме Стокхэма: каждый проход читает и пишет данные последовательно, перестановка
+	отсчетов не требуется. Если в разложении длины есть большой простой множитель, преобразование
+	сводится к свертке длины вида 2^a*3^b*5^c*7^d (алгоритм Блюстейна).
+
+	Сложность O(n log n) для любой длины. Нормировка такая же, как у FFTPrimitives::FFT_ptr():
+	множитель 1/sqrt(size) при прямом и обратном преобразовании.
+
+	Таблицы множителей для каждой длины рассчитываются при первом обращении и сохраняются.
+	Множители хранятся в точности данных (complexF32 для complexF32).
+
+	Проходы с ядрами 2, 3, 4, 5, 7, 8 векторизованы (SSE2, AVX2, AVX-512, см. FFTSIMD.h);
+	набор инструкций выбирается во время выполнения по ActiveSIMDInstructionSet().
+*/
+namespace MixedRadixFFT
+{
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Получить ближайшую длину вида 2^a*3^b*5^c*7^d, большую или равную заданной
+
+	Для таких длин преобразование выполняется без алгоритма Блюстейна и наиболее эффективно.
+
+	\return
+		- Длина, если она укладывается в size_t.
+		- Исключение, если при вычислении происходит переполнение size_t.
+*/
+size_t ceil_fft_length(size_t length);
+
+//! \brief Заранее создать таблицы для длины size (complexF32 и complexF64).
+//! Вызов необязателен: таблицы создаются при первом преобразовании длины size
+void Prepare(size_t size);
+
+//! \brief FFT, size >= 1
+void FFT(complexF32 *array, size_t size, ftDirection direction);
+
+//! \brief FFT, size >= 1
+void FFT(complexF64 *array, size_t size, ftDirection direction);
+
+/*!
+	\brief Пакетное FFT: count сигналов длины size >= 1 с общими таблицами
+
+	Отсчет i сигнала s находится в array[s*dist + i*stride]; шаги могут быть отрицательными,
+	сигналы не должны пересекаться. Перед преобразованием сигнал циклически сдвигается
+	на input_shift отсчетов вперед (x'[i] = x[(i - input_shift) mod size]), результат --
+	на output_shift.
+
+	Сигналы с stride == 1 преобразуются по одному. Сигналы с stride != 1 при длине вида
+	2^a*3^b*5^c*7^d обрабатываются группами по числу комплексных отсчетов в векторном регистре:
+	один регистр содержит один и тот же отсчет всех сигналов группы (векторизация по сигналам).
+*/
+void FFT_batch(complexF32 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist,
+		ftDirection direction, size_t input_shift = 0, size_t output_shift = 0);
+
+//! \brief Пакетное FFT, см. FFT_batch(complexF32*, ...)
+void FFT_batch(complexF64 *array, size_t size, size_t count, ptrdiff_t stride, ptrdiff_t dist,
+		ftDirection direction, size_t input_shift = 0, size_t output_shift = 0);
+
+//--------------------------------------------------------------
+
+} // namespace MixedRadixFFT
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__MixedRadixFFT_h
@@ -47,6 +47,25 @@ inline void fft_4(COMPLEX_T *v, ftDirection dir);
 
 //--------------------------------------------------------------
 
+//! \brief FFT длины 5
+template<class COMPLEX_T>
+inline void fft_5(COMPLEX_T *v, ptrdiff_t step, ftDirection dir);
+
+//! \brief FFT длины 5
+template<class COMPLEX_T>
+inline void fft_5(COMPLEX_T *v, ftDirection dir);
+
+//--------------------------------------------------------------
+
+//! \brief FFT длины 7
+template<class COMPLEX_T>
+inline void fft_7(COMPLEX_T *v, ptrdiff_t step, ftDirection dir);
+
+//! \brief FFT длины 7
+template<class COMPLEX_T>
+inline void fft_7(COMPLEX_T *v, ftDirection dir);
+//--------------------------------------------------------------
+
 //! \brief FFT длины 8
 template<class COMPLEX_T>
 inline void fft_8(COMPLEX_T *v, ptrdiff_t step, ftDirection direction);
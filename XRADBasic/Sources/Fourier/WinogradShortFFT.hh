@@ -161,6 +161,116 @@ inline void fft_4(COMPLEX_T *v, ftDirection dir)
 	}
 }
 
+//--------------------------------------------------------------
+//	преобразование длины 5
+//	Отсчеты объединяются в пары (v[k], v[5-k]): суммы умножаются на косинусы,
+//	разности на синусы, что вдвое сокращает число умножений по сравнению с ДПФ.
+
+const double C_2pi5 = cos(two_pi()/5.);
+const double C_4pi5 = cos(2.*two_pi()/5.);
+const double S_2pi5 = sin(two_pi()/5.);
+const double S_4pi5 = sin(2.*two_pi()/5.);
+
+//--------------------------------------------------------------
+
+template<class COMPLEX_T>
+inline void fft_5(COMPLEX_T *v, ptrdiff_t step, ftDirection dir)
+{
+	auto a1 = v[step] + v[4*step];
+	auto b1 = v[step] - v[4*step];
+	auto a2 = v[2*step] + v[3*step];
+	auto b2 = v[2*step] - v[3*step];
+
+	auto T1 = *v + a1*C_2pi5 + a2*C_4pi5;
+	auto T2 = *v + a1*C_4pi5 + a2*C_2pi5;
+	auto S1 = b1*S_2pi5 + b2*S_4pi5;
+	auto S2 = b1*S_4pi5 - b2*S_2pi5;
+
+	*v += a1 + a2;
+
+	if(dir == ftForward)
+	{
+		v[step] = subtract_i(T1, S1);
+		v[4*step] = add_i(T1, S1);
+		v[2*step] = subtract_i(T2, S2);
+		v[3*step] = add_i(T2, S2);
+	}
+	else
+	{
+		v[step] = add_i(T1, S1);
+		v[4*step] = subtract_i(T1, S1);
+		v[2*step] = add_i(T2, S2);
+		v[3*step] = subtract_i(T2, S2);
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class COMPLEX_T>
+inline void fft_5(COMPLEX_T *v, ftDirection dir)
+{
+	fft_5(v, 1, dir);
+}
+
+//--------------------------------------------------------------
+//	преобразование длины 7 (аналогично длине 5)
+
+const double C_2pi7 = cos(two_pi()/7.);
+const double C_4pi7 = cos(2.*two_pi()/7.);
+const double C_6pi7 = cos(3.*two_pi()/7.);
+const double S_2pi7 = sin(two_pi()/7.);
+const double S_4pi7 = sin(2.*two_pi()/7.);
+const double S_6pi7 = sin(3.*two_pi()/7.);
+
+//--------------------------------------------------------------
+
+template<class COMPLEX_T>
+inline void fft_7(COMPLEX_T *v, ptrdiff_t step, ftDirection dir)
+{
+	auto a1 = v[step] + v[6*step];
+	auto b1 = v[step] - v[6*step];
+	auto a2 = v[2*step] + v[5*step];
+	auto b2 = v[2*step] - v[5*step];
+	auto a3 = v[3*step] + v[4*step];
+	auto b3 = v[3*step] - v[4*step];
+
+	auto T1 = *v + a1*C_2pi7 + a2*C_4pi7 + a3*C_6pi7;
+	auto T2 = *v + a1*C_4pi7 + a2*C_6pi7 + a3*C_2pi7;
+	auto T3 = *v + a1*C_6pi7 + a2*C_2pi7 + a3*C_4pi7;
+	auto S1 = b1*S_2pi7 + b2*S_4pi7 + b3*S_6pi7;
+	auto S2 = b1*S_4pi7 - b2*S_6pi7 - b3*S_2pi7;
+	auto S3 = b1*S_6pi7 - b2*S_2pi7 + b3*S_4pi7;
+
+	*v += a1 + a2 + a3;
+
+	if(dir == ftForward)
+	{
+		v[step] = subtract_i(T1, S1);
+		v[6*step] = add_i(T1, S1);
+		v[2*step] = subtract_i(T2, S2);
+		v[5*step] = add_i(T2, S2);
+		v[3*step] = subtract_i(T3, S3);
+		v[4*step] = add_i(T3, S3);
+	}
+	else
+	{
+		v[step] = add_i(T1, S1);
+		v[6*step] = subtract_i(T1, S1);
+		v[2*step] = add_i(T2, S2);
+		v[5*step] = subtract_i(T2, S2);
+		v[3*step] = add_i(T3, S3);
+		v[4*step] = subtract_i(T3, S3);
+	}
+}
+
+//--------------------------------------------------------------
+
+template<class COMPLEX_T>
+inline void fft_7(COMPLEX_T *v, ftDirection dir)
+{
+	fft_7(v, 1, dir);
+}
+
 //--------------------------------------------------------------
 //	преобразование длины 8
 
@@ -9,6 +9,7 @@
 #include <XRADBasic/Sources/Containers/SpaceCoordinates.h>
 #include <XRADBasic/Sources/Algebra/FieldTraits.h>
 #include <XRADBasic/Sources/Containers/DataArrayMD.h>
+#include <XRADBasic/Sources/Containers/StridedView.h>
 
 XRAD_BEGIN
 
@@ -61,6 +62,16 @@ void	BiexpBlur2D(AR2D &data, double radius_v, double radius_h);
 template<class AR2D>
 void	BiexpBlur2D(AR2D &data, point2_F64 &radius);
 
+/*!
+	\brief Двумерный биэкспоненциальный фильтр для представления данных (см. StridedView.h)
+
+	Для отсчетов с плавающей точкой (вещественных, комплексных, цветовых).
+	Строки и столбцы не создаются как объекты; проход по столбцам выполняется
+	построчно, одновременно для всех столбцов.
+*/
+template<class T>
+void	BiexpBlur2D(StridedView2D<T> data, double radius_v, double radius_h);
+
 template<class AR2D>
 void	ExponentialBlur2D(AR2D &data, const point2_F64 &radius, const blur_directions_2 &directions);
 
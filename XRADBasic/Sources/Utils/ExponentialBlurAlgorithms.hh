@@ -320,6 +320,50 @@ inline void	blur_1d_bidirectional(sample_t *pdata,
 	blur_1d_bidirectional(pdata, data_size, data_step, af);
 }
 
+/*!
+	\brief Двусторонний фильтр вдоль столбцов двумерных данных
+
+	Результат тот же, что у blur_1d_bidirectional() для каждого столбца, но рекурсия
+	выполняется сразу по всем столбцам: внутренний цикл идет вдоль строки, и данные
+	читаются строками, а не с шагом в строку.
+*/
+template<class sample_t>
+inline void	blur_columns_bidirectional(sample_t *pdata,
+		size_t vsize, size_t hsize, ptrdiff_t vstep, ptrdiff_t hstep,
+		float af)
+{
+	for(size_t i=1; i<vsize; ++i)
+	{
+		sample_t	*row = pdata + ptrdiff_t(i)*vstep;
+		const sample_t	*previous = row - vstep;
+		if(hstep==1)
+		{
+			for(size_t j=0; j<hsize; ++j)
+				filter_action(row[j], previous[j], af);
+		}
+		else
+		{
+			for(size_t j=0; j<hsize; ++j)
+				filter_action(row[ptrdiff_t(j)*hstep], previous[ptrdiff_t(j)*hstep], af);
+		}
+	}
+	for(size_t i=vsize; i-- > 1;)
+	{
+		sample_t	*row = pdata + ptrdiff_t(i-1)*vstep;
+		const sample_t	*next = row + vstep;
+		if(hstep==1)
+		{
+			for(size_t j=0; j<hsize; ++j)
+				filter_action(row[j], next[j], af);
+		}
+		else
+		{
+			for(size_t j=0; j<hsize; ++j)
+				filter_action(row[ptrdiff_t(j)*hstep], next[ptrdiff_t(j)*hstep], af);
+		}
+	}
+}
+
 
 } //namespace exponential_blur_algorithms
 
@@ -344,6 +388,13 @@ inline void	BiexpBlur1D(ARR &f, ST a)
 	exponential_blur_algorithms::blur_1d_bidirectional(&f[0], f.size(), f.step(), a);
 }
 
+template<class T, class ST>
+inline void	BiexpBlur1D(StridedView1D<T> f, ST a)
+{
+	if (f.empty()) return;
+	exponential_blur_algorithms::blur_1d_bidirectional(f.data(), f.size(), f.step(), a);
+}
+
 template<class ARR, class ST>
 inline void	BiexpSharpen1D(ARR &f, ST a, double strength)
 {
@@ -418,6 +469,23 @@ inline void BiexpBlur2D(AR2D &data, double radius_v, double radius_h)
 	BiexpBlur2D_cpu(data, radius_v, radius_h);
 }
 
+template<class T>
+void	BiexpBlur2D(StridedView2D<T> data, double radius_v, double radius_h)
+{
+	if (data.empty()) return;
+	if(radius_v)
+	{
+		exponential_blur_algorithms::blur_columns_bidirectional(data.data(), data.vsize(), data.hsize(),
+				data.vstep(), data.hstep(), float(ExponentialFlterCoefficient(radius_v)));
+	}
+	if(radius_h)
+	{
+		float	ah = float(ExponentialFlterCoefficient(radius_h));
+		for(auto row: data)
+			exponential_blur_algorithms::blur_1d_bidirectional(row.data(), row.size(), row.step(), ah);
+	}
+}
+
 template<class AR2D>
 void	BiexpSharpen2D(AR2D &data, double radius_v, double radius_h, double strength)
 {
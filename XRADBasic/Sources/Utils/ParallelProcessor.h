@@ -19,9 +19,112 @@
 #include <omp.h>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
 
 XRAD_BEGIN
 
+namespace ParallelProcessorAuxiliaries
+{
+
+/*!
+	\brief Диапазон номеров порций [begin, end), принадлежащий одному рабочему потоку
+
+	Владелец забирает порции с начала диапазона (pop_front), потоки, исчерпавшие свою работу,
+	отнимают вторую половину оставшихся порций с конца (steal_back). Обе границы упакованы
+	в одно 64-битное слово, поэтому все операции выполняются одним compare_exchange без блокировок.
+
+	Выравнивание на строку кэша исключает ложное разделение между диапазонами соседних потоков.
+*/
+class alignas(64) work_range
+{
+	public:
+		//! \brief Наибольший номер порции, который можно упаковать (границы хранятся в 32 битах)
+		static constexpr size_t	max_chunk = 0xFFFFFFFF;
+
+		work_range() : m_range(0) {}
+
+		void	assign(size_t begin, size_t end)
+		{
+			XRAD_ASSERT_THROW(begin <= max_chunk && end <= max_chunk);
+			m_range.store(pack(begin, end), std::memory_order_release);
+		}
+
+		size_t	size() const
+		{
+			uint64_t	r = m_range.load(std::memory_order_relaxed);
+			return range_end(r) > range_begin(r) ? range_end(r) - range_begin(r) : 0;
+		}
+
+		bool	pop_front(size_t &chunk)
+		{
+			uint64_t	r = m_range.load(std::memory_order_acquire);
+			for(;;)
+			{
+				size_t	b = range_begin(r), e = range_end(r);
+				if(b >= e)
+					return false;
+				if(m_range.compare_exchange_weak(r, pack(b + 1, e), std::memory_order_acq_rel))
+				{
+					chunk = b;
+					return true;
+				}
+			}
+		}
+
+		//! \brief Отнять вторую половину оставшихся порций (последнюю порцию отнимает целиком)
+		bool	steal_back(size_t &stolen_begin, size_t &stolen_end)
+		{
+			uint64_t	r = m_range.load(std::memory_order_acquire);
+			for(;;)
+			{
+				size_t	b = range_begin(r), e = range_end(r);
+				if(b >= e)
+					return false;
+				size_t	middle = b + (e - b)/2;
+				if(m_range.compare_exchange_weak(r, pack(b, middle), std::memory_order_acq_rel))
+				{
+					stolen_begin = middle;
+					stolen_end = e;
+					return true;
+				}
+			}
+		}
+
+	private:
+		static uint64_t	pack(size_t begin, size_t end){ return (uint64_t(begin) << 32) | uint64_t(uint32_t(end)); }
+		static size_t	range_begin(uint64_t r){ return size_t(r >> 32); }
+		static size_t	range_end(uint64_t r){ return size_t(uint32_t(r)); }
+
+		std::atomic<uint64_t>	m_range;
+};
+
+//! \brief Привязка текущего потока к рабочему потоку процессора, см. ParallelProcessor::thread_no()
+struct worker_binding
+{
+	const void	*processor = nullptr;
+	size_t	worker_no = 0;
+};
+
+//! \brief Частичный результат свертки (reduce), занимающий целое число строк кэша
+template<class A>
+struct alignas(64) padded_accumulator
+{
+	A	value;
+	padded_accumulator(const A &v) : value(v) {}
+};
+
+inline worker_binding &current_worker_binding()
+{
+	static thread_local worker_binding	binding;
+	return binding;
+}
+
+} // namespace ParallelProcessorAuxiliaries
+
 /*!
 	\brief  Класс, обеспечивающий разбиение больших циклов на порции для многопроцессорной обработки с индикатором прогресса
 
@@ -61,9 +164,18 @@ XRAD_BEGIN
 
 	Таким образом, весь код с индикаторами прогресса либо выполняется в один поток, либо требует переписывания
 	с разбиением на порции вручную.
-	В предлагаемом решении большие циклы автоматически делятся на блоки, каждый из которых может безопасно обрабатываться
-	в многопоточном режиме. Индикатор прогресса меняется только из одного потока после того, как работа всех потоков для одного
-	блока завершена.
+	В предлагаемом решении большие циклы автоматически делятся на порции, каждая из которых может безопасно обрабатываться
+	в многопоточном режиме. Индикатор прогресса меняется только из одного потока (того, который вызвал perform).
+
+	Многопоточная обработка выполняется в одной параллельной области omp без барьеров между порциями.
+	Каждый рабочий поток получает свою очередь порций; поток, завершивший свою очередь, отнимает половину
+	оставшихся порций у наиболее загруженного потока (work stealing). Поэтому один медленный шаг
+	не заставляет простаивать остальные ядра. Число выполненных шагов накапливается в атомарном счетчике,
+	по которому вызывающий поток двигает индикатор прогресса.
+
+	Если для шага нужен ресурс, принадлежащий отдельному потоку (буфер, объект-обработчик),
+	его номер следует получать через thread_no(): два шага с одинаковым номером потока
+	никогда не выполняются одновременно.
 
 	Пример использования:
 
@@ -105,6 +217,18 @@ public:
 		skip_nothing
 	};
 
+	//! \brief Способы распределения шагов по потокам
+	enum index_mapping_t
+	{
+		//! \brief Соседние шаги выполняются разными потоками: шаг i относится к потоку i%n_threads().
+		//! Обеспечивает равномерную загрузку, когда трудоемкость шагов меняется плавно вдоль массива
+		e_interleaved,
+		//! \brief Каждый поток обрабатывает непрерывный диапазон шагов.
+		//! Следует выбирать, когда шаг — элемент или строка массива: потоки не обращаются
+		//! к соседним элементам памяти (нет ложного разделения строк кэша), работает предвыборка
+		e_blocked
+	};
+
 private:
 
 	//! \brief Общее число шагов обработки (например, размер обрабатываемого массива).
@@ -131,6 +255,8 @@ private:
 
 	error_process_mode_t	m_error_process_mode = skip_rest;
 
+	index_mapping_t	m_index_mapping = e_interleaved;
+
 	//! \brief Вспомогательная величина, позволяет избежать обращений к макро в теле функции
 	#if defined(XRAD_DEBUG)
 		const	bool	debug = true;
@@ -138,20 +264,39 @@ private:
 		const	bool	debug = false;
 	#endif
 
+	//! \brief Линейный номер шага. Если шага с такими номерами нет, возвращает значение не меньше m_n_total_steps
 	size_t	absolute_index(size_t piece_no, size_t thread_no, size_t subthread_no) const
 	{
 		//	изменения в этой функции должны быть симметрично учтены в функции thread_no
+		if(m_index_mapping==e_blocked)
+		{
+			size_t	begin, end;
+			block_bounds(piece_no, thread_no, begin, end);
+			return begin + subthread_no < end ? begin + subthread_no : m_n_total_steps;
+		}
 		// Этот вариант обеспечивает более равномерную загрузку потоков:
 		return (piece_no*m_n_actions_per_thread + subthread_no)*m_n_threads + thread_no;
 		// Такой вариант использовался ранее (ср. комментарий в thread_no):
 		//return (piece_no*m_n_threads + thread_no)*m_n_actions_per_thread + subthread_no;
 	}
 
+	//! \brief Границы непрерывного диапазона шагов [begin, end) порции piece_no потока thread_no
+	//! при блочном распределении. Поток thread_no получает шаги
+	//! [thread_no*m_n_total_actions_per_thread, (thread_no+1)*m_n_total_actions_per_thread)
+	void	block_bounds(size_t piece_no, size_t thread_no, size_t &begin, size_t &end) const
+	{
+		size_t	thread_begin = thread_no*m_n_total_actions_per_thread;
+		size_t	thread_end = min(thread_begin + m_n_total_actions_per_thread, m_n_total_steps);
+		begin = min(thread_begin + piece_no*m_n_actions_per_thread, thread_end);
+		end = min(begin + m_n_actions_per_thread, thread_end);
+	}
+
 	void	select_indices_util(size_t in_n_actions_per_thread, size_t in_n_threads)
 	{
 		if (m_n_total_steps <= in_n_threads)
 		{
 			m_n_threads = m_n_total_steps;
+			m_n_total_actions_per_thread = 1;
 			m_n_actions_per_thread = 1;
 			m_n_pieces = 1;
 			return;
@@ -203,10 +348,19 @@ private:
 	}
 
 
+	//! \brief Номер потока для порции с линейным номером chunk.
+	//! Порции нумеруются по потокам: chunk = thread_no*m_n_pieces + piece, поэтому исходная очередь
+	//! каждого потока образует непрерывный диапазон номеров
+	size_t	chunk_thread_no(size_t chunk) const { return chunk / m_n_pieces; }
+	size_t	chunk_piece_no(size_t chunk) const { return chunk % m_n_pieces; }
+	size_t	n_chunks() const { return m_n_pieces*m_n_threads; }
+
+	//! \brief Выполнить одну порцию. Возвращает число шагов в пределах m_n_total_steps, к которым было применено действие
 	template<class T>
-	void	perform_one_thread(T &one_step_action, size_t piece, size_t thread_no, error_list_t &err) const
+	size_t	perform_one_thread(T &one_step_action, size_t piece, size_t thread_no, error_list_t &err) const
 	{
 		size_t	i(0);
+		size_t	n_done(0);
 		try
 		{
 			for (size_t subthread_no = 0; subthread_no < m_n_actions_per_thread; ++subthread_no)
@@ -216,7 +370,11 @@ private:
 				// В случае не skip_nothing цикл будет прерван исключением.
 				if(m_error_process_mode==skip_nothing && err.HasSpecialErrors())
 					break;
-				i = absolute_index(piece, thread_no, subthread_no);
+				size_t	index = absolute_index(piece, thread_no, subthread_no);
+				if(index >= m_n_total_steps)
+					break;
+				i = index;
+				++n_done;
 				perform_one_action(one_step_action, i, err);
 			}
 		}
@@ -224,6 +382,26 @@ private:
 		{
 			err.CatchException(i);
 		}
+		return n_done;
+	}
+
+	//! \brief Выполнить одну порцию как непрерывный диапазон шагов (блочное распределение)
+	template<class T>
+	size_t	perform_one_range(T &range_action, size_t piece, size_t thread_no, error_list_t &err) const
+	{
+		size_t	begin, end;
+		block_bounds(piece, thread_no, begin, end);
+		if(begin >= end)
+			return 0;
+		try
+		{
+			range_action(begin, end);
+		}
+		catch (...)
+		{
+			err.CatchException(begin);
+		}
+		return end - begin;
 	}
 
 	bool need_break(const error_list_t &err) const
@@ -233,6 +411,124 @@ private:
 		return err.HasErrors();
 	}
 
+	//! \brief Найти работу для потока worker_no: сначала в собственной очереди, затем у других потоков
+	bool	acquire_chunk(vector<ParallelProcessorAuxiliaries::work_range> &queues, size_t worker_no, size_t &chunk) const
+	{
+		auto	&own = queues[worker_no];
+		for(;;)
+		{
+			if(own.pop_front(chunk))
+				return true;
+			// Отнимаем работу у потока с самой длинной очередью. Пока поток с непустой очередью
+			// существует, поиск повторяется: чужая очередь могла опустеть между оценкой размера и попыткой
+			size_t	victim = worker_no, victim_size = 0;
+			for(size_t j = 0; j < queues.size(); ++j)
+			{
+				size_t	sz = queues[j].size();
+				if(j != worker_no && sz > victim_size)
+				{
+					victim = j;
+					victim_size = sz;
+				}
+			}
+			if(!victim_size)
+				return false;
+			size_t	stolen_begin, stolen_end;
+			if(queues[victim].steal_back(stolen_begin, stolen_end))
+			{
+				// Собственная очередь пуста, чужие потоки могут лишь безуспешно пытаться ее разделить
+				chunk = stolen_begin;
+				own.assign(stolen_begin + 1, stolen_end);
+				return true;
+			}
+		}
+	}
+
+	//! \param chunk_action Функция size_t chunk_action(size_t piece, size_t thread_no), выполняющая одну порцию
+	//! и возвращающая число выполненных шагов
+	template<class ChunkAction>
+	void	perform_parallel(ChunkAction &chunk_action, error_list_t &err, RandomProgressBar &progress) const
+	{
+		using namespace ParallelProcessorAuxiliaries;
+		vector<work_range>	queues(m_n_threads);
+		std::atomic<size_t>	n_completed_steps(0);
+
+		#pragma omp parallel num_threads(int(m_n_threads))
+		{
+			ThreadSetup ts; (void)ts;
+			size_t	n_workers = omp_get_num_threads();
+			size_t	worker_no = omp_get_thread_num();
+
+			// Исходное распределение совпадает с прежним: каждый поток получает порции своего номера.
+			// Если omp выделил меньше потоков (например, при вложенном вызове), очереди лишних потоков
+			// распределяются между имеющимися непрерывными блоками.
+			size_t	first_lane = worker_no*m_n_threads/n_workers;
+			size_t	last_lane = (worker_no + 1)*m_n_threads/n_workers;
+			queues[worker_no].assign(first_lane*m_n_pieces, last_lane*m_n_pieces);
+			#pragma omp barrier
+
+			worker_binding	saved_binding = current_worker_binding();
+			current_worker_binding() = worker_binding{this, worker_no};
+
+			bool	publisher = worker_no == 0;
+			size_t	published_steps = 0;
+			auto	publish_progress = [&]()
+			{
+				size_t	n = n_completed_steps.load(std::memory_order_relaxed);
+				if(n == published_steps)
+					return;
+				published_steps = n;
+				try
+				{
+					progress.set_position(double(n)*m_n_pieces/m_n_total_steps);
+				}
+				catch(...)
+				{
+					// Прерывание операции пользователем: остальные потоки остановятся по need_break()
+					err.CatchException(size_t(-1));
+				}
+			};
+
+			size_t	chunk;
+			while(!need_break(err) && acquire_chunk(queues, worker_no, chunk))
+			{
+				size_t	n_done = chunk_action(chunk_piece_no(chunk), chunk_thread_no(chunk));
+				n_completed_steps.fetch_add(n_done, std::memory_order_relaxed);
+				if(publisher)
+					publish_progress();
+			}
+
+			if(publisher)
+			{
+				// Работы для вызывающего потока больше нет. Он продолжает обновлять индикатор,
+				// пока остальные потоки дорабатывают свои порции
+				while(!need_break(err) && n_completed_steps.load(std::memory_order_relaxed) < m_n_total_steps)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					publish_progress();
+				}
+			}
+			current_worker_binding() = saved_binding;
+		}
+	}
+
+	template<class ChunkAction>
+	void	perform_plain(ChunkAction &chunk_action, error_list_t &err, RandomProgressBar &progress) const
+	{
+		for(size_t piece = 0; piece < m_n_pieces; ++piece)
+		{
+			if (need_break(err))
+				break;
+			for(size_t thread_no = 0; thread_no < m_n_threads; ++thread_no)
+			{
+				if (need_break(err))
+					break;
+				chunk_action(piece, thread_no);
+			}
+			progress.set_position(piece + 1);
+		}
+	}
+
 public:
 	//! \name Инициализация
 	//! @{
@@ -255,6 +551,7 @@ public:
 		{
 			// в этом случае все аргументы, определяющие многопоточную обработку, игнорируются
 			m_n_threads = 1;
+			m_n_total_actions_per_thread = m_n_total_steps;
 			m_n_actions_per_thread = 1;
 			m_n_pieces = m_n_total_steps;
 		}
@@ -267,6 +564,13 @@ public:
 				// увеличиваем нагрузку на поток, пока число шагов прогресса не опустится до 8 и ниже
 				select_indices_util(++in_n_actions_per_thread, in_n_threads);
 			} while(m_n_pieces > 8);
+			// Очереди порций рабочих потоков хранят номера порций в 32 битах, см. work_range
+			if(n_chunks() > ParallelProcessorAuxiliaries::work_range::max_chunk)
+			{
+				throw invalid_argument(ssprintf("ParallelProcessor::init: too many portions (%zu), "
+						"increase the number of actions per thread",
+						EnsureType<size_t>(n_chunks())));
+			}
 		}
 	}
 
@@ -276,9 +580,19 @@ public:
 	//! @}
 
 
+	//! \brief Номер рабочего потока (от 0 до n_threads()-1), выполняющего шаг absolute_step_no
+	//!
+	//! При вызове из perform() возвращает номер текущего рабочего потока: из-за перераспределения
+	//! порций между потоками он не определяется номером шага однозначно. Вне perform() и в однопоточном
+	//! режиме используется исходное распределение шагов по потокам.
 	size_t	thread_no(size_t absolute_step_no) const
 	{
+		auto	&binding = ParallelProcessorAuxiliaries::current_worker_binding();
+		if(binding.processor == this)
+			return binding.worker_no;
 	//	изменения в этой функции должны быть симметрично учтены в функции absolute_index
+		if(m_index_mapping==e_blocked)
+			return absolute_step_no / m_n_total_actions_per_thread;
 		return absolute_step_no % m_n_threads;
 	//	Такой вариант использовался ранее (ср. комментарий в absolute_index):
 	// 	return (absolute_step_no/m_n_actions_per_thread)%m_n_threads;
@@ -289,6 +603,9 @@ public:
 
 	void	set_error_process_mode(error_process_mode_t epm){m_error_process_mode = epm;}
 
+	void	set_index_mapping(index_mapping_t im){m_index_mapping = im;}
+	index_mapping_t	index_mapping() const { return m_index_mapping; }
+
 	//! \brief Основной цикл обработки
 	//!
 	//! \param one_cycle_action функция, описывающая один шаг обработки. Единственным параметром является номер шага.
@@ -301,23 +618,7 @@ public:
 	{
 		map<size_t, wstring> errors;
 		auto result = perform(one_step_action, message, pproxy, errors);
-		if(!errors.empty() && m_error_process_mode!=skip_nothing)
-		{
-			// Записываем сообщения об ошибках в порядке возрастания номера шага.
-			wstring err_message(message);
-			for(auto &e: errors)
-			{
-				wstring step_name;
-				if (e.first != (size_t)-1)
-					step_name = ssprintf(L"step %zu", EnsureType<size_t>(e.first));
-				else
-					step_name = L"[...]";
-				err_message += ssprintf(L"\n%ls: %ls",
-						EnsureType<const wchar_t*>(step_name.c_str()),
-						EnsureType<const wchar_t*>(e.second.c_str()));
-			}
-			throw runtime_error(convert_to_string(err_message).c_str());
-		}
+		throw_errors(message, errors);
 		return result;
 	}
 
@@ -325,53 +626,139 @@ public:
 			const ProgressProxy &pproxy,
 			map<size_t, wstring> &errors) const
 	{
-		// Пустой набор данных возможен.
-		if(!m_n_pieces)
-			return performance_time_t(0);
+		error_list_t	err(convert_to_string(message));
+		auto	chunk_action = [this, &one_step_action, &err](size_t piece, size_t thread_no)
+		{
+			return perform_one_thread(one_step_action, piece, thread_no, err);
+		};
+		return perform_chunks(chunk_action, message, pproxy, err, errors);
+	}
+
+	/*!
+		\brief Основной цикл обработки непрерывными диапазонами шагов
+
+		\param range_action функция range_action(size_t begin, size_t end), обрабатывающая шаги [begin, end).
+		Позволяет выполнять обработку плотным внутренним циклом вместо вызова функции на каждый шаг:
 
+		\code
+		proc.init(array.size());
+		auto	range_action = [&array](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; ++i)
+				array[i] = f(array[i]);
+		};
+		proc.perform_range(range_action, L"processing", pproxy);
+		\endcode
+
+		Шаги всегда распределяются по потокам блоками (как при e_blocked) независимо от index_mapping().
+		Ошибка относится к первому шагу диапазона; при skip_nothing отменяется только диапазон,
+		в котором она возникла.
+	*/
+	template<class T> performance_time_t perform_range(T &range_action, const wstring &message,
+			const ProgressProxy &pproxy) const
+	{
+		map<size_t, wstring> errors;
+		auto result = perform_range(range_action, message, pproxy, errors);
+		throw_errors(message, errors);
+		return result;
+	}
+
+	template<class T> performance_time_t perform_range(T &range_action, const wstring &message,
+			const ProgressProxy &pproxy,
+			map<size_t, wstring> &errors) const
+	{
 		error_list_t	err(convert_to_string(message));
+		auto	chunk_action = [this, &range_action, &err](size_t piece, size_t thread_no)
+		{
+			return perform_one_range(range_action, piece, thread_no, err);
+		};
+		return perform_chunks(chunk_action, message, pproxy, err, errors);
+	}
 
-		RandomProgressBar	progress(pproxy);
-		progress.start(message, m_n_pieces);
+	/*!
+		\brief Параллельная свертка (reduce) по всем шагам
+
+		\param identity Начальное значение накопителя (нейтральный элемент операции merge)
+		\param range_reduce Функция range_reduce(A &accumulator, size_t begin, size_t end), добавляющая
+			в накопитель шаги [begin, end)
+		\param merge Функция merge(A &accumulator, const A &partial), добавляющая частичный результат
+		\return Результат свертки
+
+		Каждая порция накапливает результат в собственном накопителе, выровненном на строку кэша,
+		поэтому потоки не разделяют данные и не требуют синхронизации. После обработки частичные результаты
+		объединяются в порядке возрастания номеров шагов. Границы порций не зависят от того,
+		какой поток их выполнил, поэтому результат (в т.ч. округление чисел с плавающей точкой)
+		воспроизводим от запуска к запуску при одинаковом числе потоков.
+
+		При однопоточном последовательном выполнении (в т.ч. e_force_plain, где порций столько же,
+		сколько шагов) порции обрабатываются по возрастанию номеров шагов, поэтому все они
+		накапливаются в одном накопителе, и память не зависит от числа шагов.
+
+		\code
+		proc.init(array.size());
+		auto	sum_range = [&array](double &sum, size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; ++i)
+				sum += array[i];
+		};
+		double	sum = proc.reduce(0., sum_range, [](double &a, double b){ a += b; }, L"sum", pproxy);
+		\endcode
+
+		Частичный результат порции с ошибкой не имеет смысла, поэтому при любой ошибке
+		выбрасывается исключение независимо от error_process_mode.
+	*/
+	template<class A, class T, class M> A reduce(const A &identity, T &range_reduce, M merge,
+			const wstring &message,
+			const ProgressProxy &pproxy) const
+	{
+		using namespace ParallelProcessorAuxiliaries;
+		const bool	sequential = !use_parallel() && m_n_threads == 1;
+		vector<padded_accumulator<A>>	accumulators(sequential? 1: n_chunks(), padded_accumulator<A>(identity));
+		error_list_t	err(convert_to_string(message));
+		auto	chunk_action = [this, sequential, &range_reduce, &accumulators, &err](size_t piece, size_t thread_no)
+		{
+			const size_t	chunk = sequential? 0: thread_no*m_n_pieces + piece;
+			auto	accumulate = [&range_reduce, &accumulators, chunk](size_t begin, size_t end)
+			{
+				range_reduce(accumulators[chunk].value, begin, end);
+			};
+			return perform_one_range(accumulate, piece, thread_no, err);
+		};
+		map<size_t, wstring> errors;
+		perform_chunks(chunk_action, message, pproxy, err, errors);
+		throw_errors(message, errors, true);
+		// Номера порций возрастают вместе с номерами шагов (см. chunk_thread_no), объединяем по порядку
+		A	result(identity);
+		for(auto &acc: accumulators)
+			merge(result, acc.value);
+		return result;
+	}
 
-		bool	parallel =
-			(m_mode==e_force_parallel) ? true :
+private:
+	bool	use_parallel() const
+	{
+		return (m_mode==e_force_parallel) ? true :
 			(m_mode==e_force_plain || m_mode==e_force_plain_portions || m_n_threads==1) ? false :
 			(debug==true) ? false:
 			true;
+	}
 
-		for(size_t piece = 0; piece < m_n_pieces; ++piece)
-		{
-			if (need_break(err))
-				break;
-			if(parallel)
-			{
-				#pragma omp parallel for schedule (guided)
-				for(ptrdiff_t thread_no = 0; thread_no < ptrdiff_t(m_n_threads); ++thread_no)
-				{
-					if (need_break(err))
-					{
-#ifdef XRAD_COMPILER_MSC
-						break;
-#else
-						continue; // Реализация OMP в GCC 9.2.1 не поддерживает break.
-#endif
-					}
-					ThreadSetup ts; (void)ts;
-					perform_one_thread(one_step_action, piece, thread_no, err);
-				}
-			}
-			else
-			{
-				for(ptrdiff_t thread_no = 0; thread_no < ptrdiff_t(m_n_threads); ++thread_no)
-				{
-					if (need_break(err))
-						break;
-					perform_one_thread(one_step_action, piece, thread_no, err);
-				}
-			}
-			progress.set_position(piece);
-		}
+	template<class ChunkAction> performance_time_t perform_chunks(ChunkAction &chunk_action, const wstring &message,
+			const ProgressProxy &pproxy,
+			error_list_t &err,
+			map<size_t, wstring> &errors) const
+	{
+		// Пустой набор данных возможен.
+		if(!m_n_pieces)
+			return performance_time_t(0);
+
+		RandomProgressBar	progress(pproxy);
+		progress.start(message, m_n_pieces);
+
+		if(use_parallel())
+			perform_parallel(chunk_action, err, progress);
+		else
+			perform_plain(chunk_action, err, progress);
 
 		err.ThrowIfSpecialExceptions();
 		err.ProcessErrors([&errors](const string &message, size_t step)
@@ -385,6 +772,27 @@ public:
 		}
 		return progress.end();
 	}
+
+	void	throw_errors(const wstring &message, const map<size_t, wstring> &errors, bool force = false) const
+	{
+		if(!errors.empty() && (force || m_error_process_mode!=skip_nothing))
+		{
+			// Записываем сообщения об ошибках в порядке возрастания номера шага.
+			wstring err_message(message);
+			for(auto &e: errors)
+			{
+				wstring step_name;
+				if (e.first != (size_t)-1)
+					step_name = ssprintf(L"step %zu", EnsureType<size_t>(e.first));
+				else
+					step_name = L"[...]";
+				err_message += ssprintf(L"\n%ls: %ls",
+						EnsureType<const wchar_t*>(step_name.c_str()),
+						EnsureType<const wchar_t*>(e.second.c_str()));
+			}
+			throw runtime_error(convert_to_string(err_message).c_str());
+		}
+	}
 };
 
 
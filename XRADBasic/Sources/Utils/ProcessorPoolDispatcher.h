@@ -10,11 +10,12 @@
 //--------------------------------------------------------------
 
 #include <XRADBasic/Core.h>
-#include <list>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#include <vector>
 
 XRAD_BEGIN
 
@@ -31,8 +32,17 @@ using namespace std;
 	с аргументами вызова Perform().
 	В текущей реализации поддерживаются только методы без возвращаемого значения (void).
 
-	Недостаток: Выбор свободного обработчика производится в однопоточном режиме.
-	Это плохо с точки зрения масштабируемости по количеству потоков.
+	Реализация. Номера свободных обработчиков хранятся в кольцевом буфере, доступ к которому
+	организован по билетам (ticket):
+	- запрос получает билет атомарным увеличением счетчика acquire_ticket и забирает из ячейки
+		буфера с этим номером обработчик, освобожденный по счету этим билетом;
+	- освобождающийся обработчик получает номер release_ticket и помещается в свою ячейку.
+
+	Поэтому запросы обслуживаются строго в порядке получения билетов (FIFO): запрос ждет только
+	запросы, получившие билеты раньше него, и не может быть обойден более поздними.
+	Если свободный обработчик есть, захват и освобождение выполняются без блокировок за O(1).
+	Блокировка (мьютекс и condition_variable ячейки) используется только для засыпания запроса,
+	которому пока не досталось обработчика.
 */
 template <class Processor>
 class ProcessorPoolDispatcher
@@ -55,27 +65,35 @@ class ProcessorPoolDispatcher
 		void Perform(Args&&... args);
 
 	private:
-		using processor_list = list<pair<Processor, size_t>>;
-		using processor_list_iterator = typename processor_list::iterator;
+		//! \brief Ячейка кольцевого буфера свободных обработчиков.
+		//!
+		//! Значение sequence определяет состояние ячейки с номером ticket (ticket%размер буфера == номер ячейки):
+		//! - sequence == ticket: ячейка свободна, в нее может быть помещен обработчик с номером освобождения ticket;
+		//! - sequence == ticket + 1: ячейка содержит обработчик processor_index для запроса с билетом ticket.
+		struct alignas(64) Cell
+		{
+			atomic<size_t> sequence;
+			size_t processor_index;
+			atomic<size_t> n_waiters;
+			mutex mx;
+			condition_variable cv;
+		};
 
 	private:
-		processor_list_iterator GetProcessorItem();
+		size_t AcquireProcessor();
+		void ReleaseProcessor(size_t processor_index);
 
-	private:
-		processor_list free_items;
-		processor_list busy_items;
-		mutex mx;
-		struct CVItem
-		{
-			condition_variable* pcv;
-			processor_list_iterator *pit;
-			std::thread::id debug_thread_id;
+		void PutToCell(size_t ticket, size_t processor_index);
 
-			CVItem(condition_variable* pcv, processor_list_iterator *pit,
-					std::thread::id debug_thread_id):
-				pcv(pcv), pit(pit), debug_thread_id(debug_thread_id) {}
-		};
-		list<CVItem> cvs;
+		//! \brief Ожидание, пока ячейка не перейдет в состояние sequence == expected_sequence
+		void WaitCell(Cell &cell, size_t expected_sequence, bool blocking);
+
+	private:
+		vector<Processor> processors;
+		unique_ptr<Cell[]> cells;
+		size_t cells_mask = 0;
+		alignas(64) atomic<size_t> acquire_ticket;
+		alignas(64) atomic<size_t> release_ticket;
 		shared_ptr<Log> log;
 };
 
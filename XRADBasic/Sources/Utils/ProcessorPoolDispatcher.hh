@@ -16,11 +16,30 @@ template <class Processor>
 template <class ProcessorCreator>
 ProcessorPoolDispatcher<Processor>::ProcessorPoolDispatcher(size_t processor_count,
 		ProcessorCreator processor_creator, shared_ptr<Log> log):
+	acquire_ticket(0),
+	release_ticket(0),
 	log(std::move(log))
 {
+	processors.reserve(processor_count);
 	for (size_t i = 0; i < processor_count; ++i)
 	{
-		free_items.emplace_back(processor_creator(i), i);
+		processors.emplace_back(processor_creator(i));
+	}
+	// Размер буфера берется с запасом, чтобы освобождающему потоку практически не приходилось ждать,
+	// пока медленный запрос заберет обработчик, помещенный в ту же ячейку на предыдущем круге.
+	size_t cell_count = 1;
+	while (cell_count < 2*processor_count)
+		cell_count <<= 1;
+	cells.reset(new Cell[cell_count]);
+	cells_mask = cell_count - 1;
+	for (size_t i = 0; i < cell_count; ++i)
+	{
+		cells[i].sequence = i;
+		cells[i].n_waiters = 0;
+	}
+	for (size_t i = 0; i < processor_count; ++i)
+	{
+		PutToCell(release_ticket++, i);
 	}
 }
 
@@ -30,111 +49,134 @@ template <class Processor>
 template <class... Args>
 void ProcessorPoolDispatcher<Processor>::Perform(Args&&... args)
 {
-	auto item_it = GetProcessorItem();
+	if (processors.empty())
+		throw runtime_error("ProcessorPoolDispatcher::Perform(): Perform item array is empty.");
+	size_t processor_index = AcquireProcessor();
 
-	class free_busy_unlocker
+	class processor_releaser
 	{
 		public:
-			free_busy_unlocker(processor_list_iterator item_it, processor_list *free_items,
-					processor_list *busy_items,
-					mutex *mx, list<CVItem> *cvs,
-					Log *log):
-				item_it(item_it), free_items(free_items), busy_items(busy_items), mx(mx), cvs(cvs),
-				log(log) {}
-			free_busy_unlocker(const free_busy_unlocker &) = delete;
-			free_busy_unlocker &operator= (const free_busy_unlocker &) = delete;
-			~free_busy_unlocker()
+			processor_releaser(ProcessorPoolDispatcher *dispatcher, size_t processor_index):
+				dispatcher(dispatcher), processor_index(processor_index) {}
+			processor_releaser(const processor_releaser &) = delete;
+			processor_releaser &operator= (const processor_releaser &) = delete;
+			~processor_releaser()
 			{
-				unique_lock<mutex> lock(*mx);
-				if (cvs->empty())
-				{
-					if (log)
-					{
-						(*log)(ssprintf("ProcessorPoolDispatcher unlocker: [%zu] id = %s -> free\n",
-								EnsureType<size_t>(item_it->second),
-								EnsureType<const char*>(DebugThreadIdStr().c_str())));
-					}
-					free_items->splice(free_items->begin(), *busy_items, item_it);
-				}
-				else
-				{
-					auto &cv_item = cvs->front();
-					if (log)
-					{
-						(*log)(ssprintf("ProcessorPoolDispatcher unlocker: [%zu] id = %s -> id = %s\n",
-								EnsureType<size_t>(item_it->second),
-								EnsureType<const char*>(DebugThreadIdStr().c_str()),
-								EnsureType<const char*>(ToString(cv_item.debug_thread_id).c_str())));
-					}
-					*cv_item.pit = item_it;
-					auto *cv = cv_item.pcv;
-					cvs->pop_front(); // cv_item становится недействительным после этого вызова.
-					lock.unlock();
-					// Последовательность unlock(); notify_one(); предпочтительнее с точки зрения производительности
-					// чем обратная последовательность.
-					cv->notify_one();
-				}
+				dispatcher->ReleaseProcessor(processor_index);
 			}
 		private:
-			processor_list_iterator item_it;
-			processor_list *free_items, *busy_items;
-			mutex *mx;
-			list<CVItem> *cvs;
-			Log *log;
+			ProcessorPoolDispatcher *dispatcher;
+			size_t processor_index;
 	};
 
-	free_busy_unlocker bl(item_it, &free_items, &busy_items, &mx, &cvs, log.get());
-	item_it->first(std::forward<Args>(args)...);
+	processor_releaser releaser(this, processor_index);
+	processors[processor_index](std::forward<Args>(args)...);
 }
 
 //--------------------------------------------------------------
 
 template <class Processor>
-auto ProcessorPoolDispatcher<Processor>::GetProcessorItem() -> processor_list_iterator
+size_t ProcessorPoolDispatcher<Processor>::AcquireProcessor()
 {
-	unique_lock<mutex> lock(mx);
-	if (!free_items.empty())
+	size_t ticket = acquire_ticket.fetch_add(1);
+	Cell &cell = cells[ticket & cells_mask];
+	if (cell.sequence.load(std::memory_order_acquire) == ticket + 1)
+	{
+		if (log)
+		{
+			(*log)(ssprintf("ProcessorPoolDispatcher::AcquireProcessor(): id = %s. Found free.\n",
+					EnsureType<const char*>(DebugThreadIdStr().c_str())));
+		}
+	}
+	else
 	{
-		auto item_it = free_items.begin();
-		busy_items.splice(busy_items.begin(), free_items, item_it);
 		if (log)
 		{
-			(*log)(ssprintf("ProcessorPoolDispatcher::GetProcessorItem(): id = %s. Found free.\n",
+			(*log)(ssprintf("ProcessorPoolDispatcher::AcquireProcessor(): id = %s. Waiting...\n",
+					EnsureType<const char*>(DebugThreadIdStr().c_str())));
+		}
+		WaitCell(cell, ticket + 1, true);
+		if (log)
+		{
+			(*log)(ssprintf("ProcessorPoolDispatcher::AcquireProcessor(): id = %s. Found from queue.\n",
 					EnsureType<const char*>(DebugThreadIdStr().c_str())));
 		}
-		return item_it;
-		// При возврате выполняется lock.unlock().
 	}
-	if (busy_items.empty())
-		throw runtime_error("ProcessorPoolDispatcher::GetProcessorItem(): Perform item array is empty.");
+	size_t processor_index = cell.processor_index;
+	// Освобождаем ячейку для обработчика, который будет освобожден на следующем круге.
+	cell.sequence.store(ticket + cells_mask + 1, std::memory_order_release);
+	return processor_index;
+}
+
+//--------------------------------------------------------------
+
+template <class Processor>
+void ProcessorPoolDispatcher<Processor>::ReleaseProcessor(size_t processor_index)
+{
 	if (log)
 	{
-		(*log)(ssprintf("ProcessorPoolDispatcher::GetProcessorItem(): id = %s. Waiting...\n",
+		(*log)(ssprintf("ProcessorPoolDispatcher::ReleaseProcessor(): [%zu] id = %s -> free\n",
+				EnsureType<size_t>(processor_index),
 				EnsureType<const char*>(DebugThreadIdStr().c_str())));
 	}
+	PutToCell(release_ticket.fetch_add(1), processor_index);
+}
 
-	condition_variable local_cv;
-	auto item_it = busy_items.end();
-	cvs.push_back(CVItem(&local_cv, &item_it, std::this_thread::get_id()));
-	for (;;)
+//--------------------------------------------------------------
+
+template <class Processor>
+void ProcessorPoolDispatcher<Processor>::PutToCell(size_t ticket, size_t processor_index)
+{
+	Cell &cell = cells[ticket & cells_mask];
+	if (cell.sequence.load(std::memory_order_acquire) != ticket)
+		WaitCell(cell, ticket, false);
+	cell.processor_index = processor_index;
+	// Здесь и в WaitCell() используется упорядочение seq_cst: запись sequence и чтение n_waiters
+	// не должны переставляться, иначе возможна потеря пробуждения ожидающего потока.
+	cell.sequence.store(ticket + 1);
+	if (cell.n_waiters.load())
 	{
-		local_cv.wait(lock);
-		if (item_it != busy_items.end()) // Проверка на spurious wakeup.
 		{
-			// item_it уже находится в списке busy_items.
-			if (log)
-			{
-				(*log)(ssprintf("ProcessorPoolDispatcher::GetProcessorItem(): id = %s. Found from queue.\n",
-						EnsureType<const char*>(DebugThreadIdStr().c_str())));
-			}
-			return item_it;
-			// При возврате выполняется lock.unlock().
+			lock_guard<mutex> lock(cell.mx);
 		}
+		// Последовательность unlock(); notify_all(); предпочтительнее с точки зрения производительности
+		// чем обратная последовательность.
+		cell.cv.notify_all();
 	}
 }
 
 //--------------------------------------------------------------
 
+template <class Processor>
+void ProcessorPoolDispatcher<Processor>::WaitCell(Cell &cell, size_t expected_sequence, bool blocking)
+{
+	// Сначала короткое ожидание без блокировки: обработчик часто освобождается почти сразу.
+	const size_t spin_count = 16;
+	for (size_t i = 0; i < spin_count; ++i)
+	{
+		if (cell.sequence.load(std::memory_order_acquire) == expected_sequence)
+			return;
+		std::this_thread::yield();
+	}
+	if (!blocking)
+	{
+		// Ожидание освобождения ячейки запросом, который уже получил в ней обработчик,
+		// занимает время порядка нескольких инструкций.
+		while (cell.sequence.load(std::memory_order_acquire) != expected_sequence)
+			std::this_thread::yield();
+		return;
+	}
+	unique_lock<mutex> lock(cell.mx);
+	++cell.n_waiters;
+	cell.cv.wait(lock, [&cell, expected_sequence]()
+			{
+				return cell.sequence.load() == expected_sequence;
+			});
+	--cell.n_waiters;
+}
+
+//--------------------------------------------------------------
+
 XRAD_END
 
 //--------------------------------------------------------------
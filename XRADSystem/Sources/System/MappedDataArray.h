@@ -0,0 +1,135 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MappedDataArray.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_MappedDataArray_h
+#define XRAD__File_MappedDataArray_h
+/*!
+	\file
+	\brief Двумерные и многомерные массивы, данные которых находятся в отображенном в память файле
+
+	Данные в файле хранятся плотно, в порядке индексов DataArrayMD (последний индекс меняется
+	быстрее всего). Массив ссылается на отображение через UseData() и владеет им совместно
+	с другими массивами, созданными для того же отображения.
+
+	~~~~
+	auto	volume = MapRawFile<RealFunctionMD_F32>(L"perfusion.raw", {n_phases, n_slices, ny, nx},
+			mapped_file_mode::read_only);
+	volume.Advise(mapped_access_hint::sequential);
+	for(size_t t = 0; t < n_phases; ++t)
+		...
+	~~~~
+
+	Ограничения:
+	- в режиме mapped_file_mode::read_only запись в элементы массива приводит к ошибке доступа;
+	- realloc() и MakeCopy() отвязывают массив от файла (данные размещаются в куче);
+	- порядок байтов в файле должен совпадать с порядком байтов платформы.
+*/
+//--------------------------------------------------------------
+
+#include "MappedFile.h"
+#include <XRADBasic/Sources/Containers/DataArrayMD.h>
+#include <memory>
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace MappedDataArrayAux
+{
+
+template<class A2DT>
+void	use_data(DataArrayMD<A2DT> &array, typename A2DT::value_type *data, const index_vector &sizes)
+{
+	array.UseData(data, sizes, 1);
+}
+
+template<class RT>
+void	use_data(DataArray2D<RT> &array, typename RT::value_type *data, const index_vector &sizes)
+{
+	XRAD_ASSERT_THROW(sizes.size() == 2);
+	array.UseData(data, sizes[0], sizes[1]);
+}
+
+} // namespace MappedDataArrayAux
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Массив типа ARR (DataArray2D, DataArrayMD или их наследник), данные которого
+	находятся в отображенном в память файле
+
+	Объект перемещаем, но не копируем. Для копии данных в памяти следует использовать
+	конструктор ARR от этого объекта.
+*/
+template<class ARR>
+class MappedDataArray: public ARR
+{
+	public:
+		PARENT(ARR);
+		typedef typename parent::value_type value_type;
+
+	public:
+		MappedDataArray(): m_n_slices(0), m_slice_size(0) {}
+
+		/*!
+			\brief Массив размеров sizes, данные которого начинаются с начала отображения file
+
+			Размер отображения должен быть не меньше размера данных массива.
+		*/
+		MappedDataArray(std::shared_ptr<MappedFile> file, const index_vector &sizes);
+
+		MappedDataArray(MappedDataArray &&) = default;
+		MappedDataArray &operator=(MappedDataArray &&) = default;
+
+		MappedDataArray(const MappedDataArray &) = delete;
+		MappedDataArray &operator=(const MappedDataArray &) = delete;
+
+	public:
+		const std::shared_ptr<MappedFile> &file() const { return m_file; }
+
+		//! \brief Подсказка о порядке доступа ко всем данным массива
+		void	Advise(mapped_access_hint hint);
+
+		/*!
+			\brief Подсказка о порядке доступа к срезам first, ..., first+count-1 по первому индексу
+			(кадрам 2D массива, срезам или фазам многомерного массива)
+
+			Например, перед обработкой среза: AdviseSlices(will_need, i, 1), после нее:
+			AdviseSlices(dont_need, i, 1).
+		*/
+		void	AdviseSlices(mapped_access_hint hint, size_t first, size_t count);
+
+		//! \brief Записать изменения в файл (для mapped_file_mode::read_write и create)
+		void	Flush();
+
+	private:
+		std::shared_ptr<MappedFile>	m_file;
+		//! \brief Число срезов по первому индексу и размер среза в байтах
+		size_t	m_n_slices;
+		size_t	m_slice_size;
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Отобразить в память массив размеров sizes из файла без заголовка
+
+	Данные начинаются со смещения offset в файле, которое должно быть кратно выравниванию
+	типа элемента. Для mapped_file_mode::create файл создается.
+*/
+template<class ARR>
+MappedDataArray<ARR>	MapRawFile(const wstring &filename, const index_vector &sizes,
+		mapped_file_mode mode, file_size_t offset = 0);
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+#include "MappedDataArray.hh"
+
+//--------------------------------------------------------------
+#endif // XRAD__File_MappedDataArray_h
@@ -0,0 +1,85 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MappedDataArray.hh
+//--------------------------------------------------------------
+#ifndef XRAD__File_MappedDataArray_hh
+#define XRAD__File_MappedDataArray_hh
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+template<class ARR>
+MappedDataArray<ARR>::MappedDataArray(std::shared_ptr<MappedFile> file, const index_vector &sizes):
+	m_file(std::move(file)),
+	m_n_slices(0),
+	m_slice_size(0)
+{
+	size_t	element_count = 1;
+	for(auto s: sizes)
+		element_count *= s;
+	if(!sizes.size() || !element_count || m_file->size()/sizeof(value_type) < element_count)
+	{
+		ForceDebugBreak();
+		throw invalid_argument(ssprintf("MappedDataArray: mapping of %zu bytes is too small for array of %zu elements.",
+				EnsureType<size_t>(m_file->size()),
+				EnsureType<size_t>(element_count)));
+	}
+	if(reinterpret_cast<uintptr_t>(m_file->data()) % alignof(value_type))
+	{
+		throw invalid_argument(ssprintf("MappedDataArray: data offset is not aligned for element type %s.",
+				EnsureType<const char*>(typeid(value_type).name())));
+	}
+	MappedDataArrayAux::use_data(*this, static_cast<value_type*>(m_file->data()), sizes);
+	m_n_slices = sizes[0];
+	m_slice_size = element_count/m_n_slices*sizeof(value_type);
+}
+
+//--------------------------------------------------------------
+
+template<class ARR>
+void	MappedDataArray<ARR>::Advise(mapped_access_hint hint)
+{
+	if(m_file)
+		m_file->Advise(hint);
+}
+
+template<class ARR>
+void	MappedDataArray<ARR>::AdviseSlices(mapped_access_hint hint, size_t first, size_t count)
+{
+	if(!m_file || first >= m_n_slices)
+		return;
+	count = min(count, m_n_slices - first);
+	// Данные массива плотные и начинаются с начала отображения
+	m_file->Advise(hint, static_cast<const char*>(m_file->data()) + first*m_slice_size, count*m_slice_size);
+}
+
+template<class ARR>
+void	MappedDataArray<ARR>::Flush()
+{
+	if(m_file)
+		m_file->Flush();
+}
+
+//--------------------------------------------------------------
+
+template<class ARR>
+MappedDataArray<ARR>	MapRawFile(const wstring &filename, const index_vector &sizes,
+		mapped_file_mode mode, file_size_t offset)
+{
+	typedef typename ARR::value_type value_type;
+	size_t	size = sizeof(value_type);
+	for(auto s: sizes)
+		size *= s;
+	return MappedDataArray<ARR>(std::make_shared<MappedFile>(filename, mode, offset, size), sizes);
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_MappedDataArray_hh
@@ -0,0 +1,319 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MappedFile.cpp
+//--------------------------------------------------------------
+#include "pre.h"
+#include "MappedFile.h"
+#include "FileNameOperations.h"
+#include "SystemConfig.h"
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	#include <windows.h>
+#elif defined(XRAD_USE_CFILE_UNIX_VERSION)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <cerrno>
+	#include <cstring>
+#else
+	#error Unknown platform.
+#endif
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+namespace
+{
+
+string mapped_file_error(const wstring &filename, const char *operation, const string &reason)
+{
+	return convert_to_string(ssprintf(L"MappedFile: %s failed for file \"%ls\": %s",
+			EnsureType<const char*>(operation),
+			EnsureType<const wchar_t*>(GetPathNativeFromAutodetect(filename).c_str()),
+			EnsureType<const char*>(reason.c_str())));
+}
+
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+
+string system_error_string()
+{
+	return ssprintf("error code %lu", EnsureType<unsigned long>(GetLastError()));
+}
+
+//! \brief Закрывает HANDLE при выходе из области видимости
+struct handle_guard
+{
+	HANDLE	handle;
+	~handle_guard()
+	{
+		if(handle && handle != INVALID_HANDLE_VALUE)
+			CloseHandle(handle);
+	}
+};
+
+#else
+
+string system_error_string()
+{
+	return strerror(errno);
+}
+
+//! \brief Закрывает дескриптор файла при выходе из области видимости
+struct fd_guard
+{
+	int	fd;
+	~fd_guard()
+	{
+		if(fd >= 0)
+			close(fd);
+	}
+};
+
+#endif
+
+} // namespace
+
+//--------------------------------------------------------------
+
+size_t MappedFile::Granularity()
+{
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	SYSTEM_INFO	info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+#else
+	return size_t(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+MappedFile::MappedFile(const wstring &filename, mapped_file_mode mode, file_size_t offset, size_t size):
+	m_view(nullptr),
+	m_view_size(0),
+	m_data(nullptr),
+	m_size(0),
+	m_mode(mode)
+{
+	if(mode == mapped_file_mode::create && !size)
+		throw invalid_argument(mapped_file_error(filename, "create", "zero size"));
+
+	const file_size_t	granularity = Granularity();
+	const file_size_t	view_offset = offset - offset%granularity;
+	const size_t	head = size_t(offset - view_offset);
+
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	const wstring	path = GetPathSystemRawFromAutodetect(filename);
+	DWORD	access = GENERIC_READ, creation = OPEN_EXISTING, protection = PAGE_READONLY,
+			view_access = FILE_MAP_READ;
+	switch(mode)
+	{
+		case mapped_file_mode::read_only:
+			break;
+		case mapped_file_mode::read_write:
+			access |= GENERIC_WRITE;
+			protection = PAGE_READWRITE;
+			view_access = FILE_MAP_WRITE;
+			break;
+		case mapped_file_mode::copy_on_write:
+			protection = PAGE_WRITECOPY;
+			view_access = FILE_MAP_COPY;
+			break;
+		case mapped_file_mode::create:
+			access |= GENERIC_WRITE;
+			creation = CREATE_ALWAYS;
+			protection = PAGE_READWRITE;
+			view_access = FILE_MAP_WRITE;
+			break;
+	}
+	handle_guard	file{CreateFileW(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+			creation, FILE_ATTRIBUTE_NORMAL, nullptr)};
+	if(file.handle == INVALID_HANDLE_VALUE)
+		throw runtime_error(mapped_file_error(filename, "open", system_error_string()));
+
+	file_size_t	file_size = 0;
+	if(mode == mapped_file_mode::create)
+	{
+		file_size = offset + size;
+	}
+	else
+	{
+		LARGE_INTEGER	li;
+		if(!GetFileSizeEx(file.handle, &li))
+			throw runtime_error(mapped_file_error(filename, "GetFileSizeEx", system_error_string()));
+		file_size = file_size_t(li.QuadPart);
+	}
+#else
+	const string	path = convert_to_string(GetPathSystemRawFromAutodetect(filename));
+	int	flags = O_RDONLY, protection = PROT_READ, view_flags = MAP_SHARED;
+	switch(mode)
+	{
+		case mapped_file_mode::read_only:
+			break;
+		case mapped_file_mode::read_write:
+			flags = O_RDWR;
+			protection |= PROT_WRITE;
+			break;
+		case mapped_file_mode::copy_on_write:
+			protection |= PROT_WRITE;
+			view_flags = MAP_PRIVATE;
+			break;
+		case mapped_file_mode::create:
+			flags = O_RDWR | O_CREAT | O_TRUNC;
+			protection |= PROT_WRITE;
+			break;
+	}
+	fd_guard	file{open(path.c_str(), flags, 0666)};
+	if(file.fd < 0)
+		throw runtime_error(mapped_file_error(filename, "open", system_error_string()));
+
+	file_size_t	file_size = 0;
+	if(mode == mapped_file_mode::create)
+	{
+		file_size = offset + size;
+		if(ftruncate(file.fd, off_t(file_size)))
+			throw runtime_error(mapped_file_error(filename, "ftruncate", system_error_string()));
+	}
+	else
+	{
+		struct stat	st;
+		if(fstat(file.fd, &st))
+			throw runtime_error(mapped_file_error(filename, "fstat", system_error_string()));
+		file_size = file_size_t(st.st_size);
+	}
+#endif
+
+	if(offset > file_size || (size && file_size - offset < size))
+	{
+		throw runtime_error(mapped_file_error(filename, "map",
+				ssprintf("region [%llu, %llu) is out of file size %llu",
+						static_cast<unsigned long long>(offset),
+						static_cast<unsigned long long>(offset + size),
+						static_cast<unsigned long long>(file_size))));
+	}
+	if(!size)
+	{
+		if(file_size - offset > std::numeric_limits<size_t>::max() - head)
+			throw runtime_error(mapped_file_error(filename, "map", "file is too large for address space"));
+		size = size_t(file_size - offset);
+	}
+	if(!size)
+		throw runtime_error(mapped_file_error(filename, "map", "empty region"));
+
+	const size_t	view_size = head + size;
+
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	const file_size_t	mapping_size = mode == mapped_file_mode::create? file_size: 0;
+	handle_guard	mapping{CreateFileMappingW(file.handle, nullptr, protection,
+			DWORD(mapping_size >> 32), DWORD(mapping_size & 0xFFFFFFFF), nullptr)};
+	if(!mapping.handle)
+		throw runtime_error(mapped_file_error(filename, "CreateFileMapping", system_error_string()));
+	void	*view = MapViewOfFile(mapping.handle, view_access,
+			DWORD(view_offset >> 32), DWORD(view_offset & 0xFFFFFFFF), view_size);
+	if(!view)
+		throw runtime_error(mapped_file_error(filename, "MapViewOfFile", system_error_string()));
+	// Отображение удерживает файл открытым, дескрипторы закрываются handle_guard
+#else
+	void	*view = mmap(nullptr, view_size, protection, view_flags, file.fd, off_t(view_offset));
+	if(view == MAP_FAILED)
+		throw runtime_error(mapped_file_error(filename, "mmap", system_error_string()));
+	// Отображение удерживает файл открытым, дескриптор закрывается fd_guard
+#endif
+
+	m_view = view;
+	m_view_size = view_size;
+	m_data = static_cast<char*>(view) + head;
+	m_size = size;
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	UnmapViewOfFile(m_view);
+#else
+	munmap(m_view, m_view_size);
+#endif
+}
+
+//--------------------------------------------------------------
+
+void MappedFile::Advise(mapped_access_hint hint)
+{
+	Advise(hint, m_data, m_size);
+}
+
+void MappedFile::Advise(mapped_access_hint hint, const void *p, size_t size)
+{
+	uintptr_t	view_begin = reinterpret_cast<uintptr_t>(m_view);
+	uintptr_t	view_end = view_begin + m_view_size;
+	uintptr_t	begin = reinterpret_cast<uintptr_t>(p);
+	uintptr_t	end = begin + size;
+	if(begin < view_begin)
+		begin = view_begin;
+	if(end > view_end)
+		end = view_end;
+	if(begin >= end)
+		return;
+	// Начало отображения выровнено на Granularity(), что кратно размеру страницы
+	const uintptr_t	page = Granularity();
+	begin -= (begin - view_begin)%page;
+
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	#if _WIN32_WINNT >= 0x0602
+	if(hint == mapped_access_hint::will_need)
+	{
+		WIN32_MEMORY_RANGE_ENTRY	range = {reinterpret_cast<void*>(begin), end - begin};
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+	#endif
+	// Для остальных подсказок аналога madvise в Win32 нет
+#else
+	int	advice = MADV_NORMAL;
+	switch(hint)
+	{
+		case mapped_access_hint::normal:
+			advice = MADV_NORMAL;
+			break;
+		case mapped_access_hint::sequential:
+			advice = MADV_SEQUENTIAL;
+			break;
+		case mapped_access_hint::random:
+			advice = MADV_RANDOM;
+			break;
+		case mapped_access_hint::will_need:
+			advice = MADV_WILLNEED;
+			break;
+		case mapped_access_hint::dont_need:
+			// Для copy_on_write MADV_DONTNEED отбросил бы измененные страницы
+			if(m_mode == mapped_file_mode::copy_on_write)
+				return;
+			advice = MADV_DONTNEED;
+			break;
+	}
+	// Ошибка madvise не влияет на корректность доступа к данным
+	madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+#endif
+}
+
+void MappedFile::Flush()
+{
+	if(m_mode != mapped_file_mode::read_write && m_mode != mapped_file_mode::create)
+		return;
+#if defined(XRAD_USE_CFILE_WIN32_VERSION)
+	if(!FlushViewOfFile(m_view, m_view_size))
+		throw runtime_error(ssprintf("MappedFile::Flush: %s", system_error_string().c_str()));
+#else
+	if(msync(m_view, m_view_size, MS_SYNC))
+		throw runtime_error(ssprintf("MappedFile::Flush: %s", system_error_string().c_str()));
+#endif
+}
+
+//--------------------------------------------------------------
+
+XRAD_END
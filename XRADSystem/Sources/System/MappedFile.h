@@ -0,0 +1,125 @@
+﻿/*
+	Copyright (c) 2021, Moscow Center for Diagnostics & Telemedicine
+	All rights reserved.
+	This file is licensed under BSD-3-Clause license. See LICENSE file for details.
+*/
+// file MappedFile.h
+//--------------------------------------------------------------
+#ifndef XRAD__File_MappedFile_h
+#define XRAD__File_MappedFile_h
+/*!
+	\file
+	\brief Отображение файла в память (mmap, CreateFileMapping)
+
+	Используется для обработки данных, не помещающихся в оперативную память:
+	страницы файла подгружаются системой при обращении и вытесняются при нехватке памяти.
+	Для доступа к данным отображенного файла как к контейнеру см. MappedDataArray.h.
+*/
+//--------------------------------------------------------------
+
+#include <XRADBasic/Core.h>
+#include "FileSystemDefs.h"
+
+XRAD_BEGIN
+
+//--------------------------------------------------------------
+
+//! \brief Режим отображения файла
+enum class mapped_file_mode
+{
+	//! \brief Только чтение. Запись в отображенную память приводит к ошибке доступа
+	read_only,
+	//! \brief Чтение и запись. Изменения записываются в файл
+	read_write,
+	//! \brief Чтение и запись. Изменения видны только этому отображению, файл не изменяется
+	copy_on_write,
+	//! \brief Создать новый файл (или перезаписать существующий) заданного размера,
+	//! далее как read_write
+	create
+};
+
+//! \brief Ожидаемый порядок доступа к отображенной памяти (подсказка системе)
+enum class mapped_access_hint
+{
+	//! \brief Порядок доступа по умолчанию
+	normal,
+	//! \brief Последовательный доступ: агрессивное упреждающее чтение, прочитанные страницы
+	//! вытесняются в первую очередь
+	sequential,
+	//! \brief Произвольный доступ: упреждающее чтение отключено
+	random,
+	//! \brief Данные скоро понадобятся: начать чтение заранее
+	will_need,
+	//! \brief Данные в ближайшее время не понадобятся: страницы можно вытеснить
+	dont_need
+};
+
+//--------------------------------------------------------------
+
+/*!
+	\brief Отображение участка файла в память
+
+	Память доступна, пока существует объект. Начало участка (offset) может быть произвольным:
+	выравнивание на границу, требуемую системой, выполняется внутри.
+
+	Ошибки (файл не найден, участок выходит за границы файла, нехватка адресного пространства)
+	приводят к исключению runtime_error.
+*/
+class MappedFile
+{
+	public:
+		/*!
+			\brief Отобразить size байт файла filename, начиная с offset
+
+			Если size == 0, отображается участок от offset до конца файла.
+			В режиме mapped_file_mode::create файл создается размером offset + size байт,
+			size должен быть ненулевым.
+		*/
+		MappedFile(const wstring &filename, mapped_file_mode mode, file_size_t offset = 0, size_t size = 0);
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+	public:
+		//! \brief Начало отображенного участка (соответствует offset)
+		void *data() const { return m_data; }
+		//! \brief Размер отображенного участка, байт
+		size_t size() const { return m_size; }
+		mapped_file_mode mode() const { return m_mode; }
+		//! \brief Допускает ли отображение запись
+		bool writable() const { return m_mode != mapped_file_mode::read_only; }
+
+		//! \brief Подсказка о порядке доступа ко всему участку
+		void Advise(mapped_access_hint hint);
+
+		/*!
+			\brief Подсказка о порядке доступа к size байтам, начиная с адреса p
+
+			Участок расширяется до границ страниц и обрезается до границ отображения.
+			На платформах, где подсказка не поддерживается, вызов ничего не делает.
+		*/
+		void Advise(mapped_access_hint hint, const void *p, size_t size);
+
+		//! \brief Записать измененные страницы в файл (для read_write и create)
+		void Flush();
+
+		//! \brief Гранулярность смещения отображения в системе, байт
+		static size_t Granularity();
+
+	private:
+		//! \brief Начало и размер отображения, выровненного на Granularity()
+		void	*m_view;
+		size_t	m_view_size;
+
+		void	*m_data;
+		size_t	m_size;
+		mapped_file_mode	m_mode;
+};
+
+//--------------------------------------------------------------
+
+XRAD_END
+
+//--------------------------------------------------------------
+#endif // XRAD__File_MappedFile_h
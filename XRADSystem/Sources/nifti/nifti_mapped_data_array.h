@@ -0,0 +1,92 @@
+﻿#ifndef nifti_mapped_data_array_h__
+#define nifti_mapped_data_array_h__
+
+/*!
+	\file
+	\brief Отображение данных файла NIfTI-1 (.nii или пара .hdr/.img) в память без чтения
+
+	В отличие от load_nifti() данные не копируются: массив ссылается на отображенный файл
+	(см. MappedDataArray.h). Поддерживаются файлы с порядком байтов платформы; тип элемента
+	массива должен совпадать с типом данных файла. Поля scl_slope, scl_inter не учитываются
+	(как и в load_nifti()).
+
+	~~~~
+	RealFunctionF64	scales;
+	auto	volume = map_nifti<RealFunctionMD_I16>(L"ct.nii", mapped_file_mode::read_only, scales);
+	volume.AdviseSlices(mapped_access_hint::will_need, z, 1);
+	~~~~
+*/
+
+#include <XRADSystem/Sources/nifti/nifti_datatypes.h>
+#include <XRADSystem/Sources/System/MappedDataArray.h>
+#include <XRADSystem/Sources/System/FileNameOperations.h>
+#include <XRADSystem/Sources/System/xrad_fopen.h>
+#include <XRADBasic/MathFunctionTypes.h>
+#include <cstring>
+
+XRAD_BEGIN
+
+namespace nifti_aux
+{
+
+inline nifti_1_header	read_nifti_header(const wstring &filename)
+{
+	nifti_1_header	hdr;
+	std::FILE	*file = xrad_fopen(convert_to_string(filename).c_str(), "rb");
+	if(!file)
+	{
+		throw runtime_error(convert_to_string(ssprintf(L"map_nifti: file \"%ls\" could not be opened.",
+				EnsureType<const wchar_t*>(GetPathNativeFromAutodetect(filename).c_str()))));
+	}
+	size_t	n_read = fread(&hdr, sizeof(hdr), 1, file);
+	fclose(file);
+	XRAD_ASSERT_THROW(n_read == 1);
+	return hdr;
+}
+
+} // namespace nifti_aux
+
+/*!
+	\brief Отобразить в память данные файла NIfTI-1
+
+	Размеры массива берутся из hdr.dim в обратном порядке (как в load_nifti()),
+	в scales записываются шаги сетки hdr.pixdim в том же порядке.
+	Режим mapped_file_mode::create не допускается.
+*/
+template<class ARR>
+MappedDataArray<ARR>	map_nifti(const wstring &filename, mapped_file_mode mode, RealFunctionF64 &scales)
+{
+	typedef typename ARR::value_type value_type;
+	XRAD_ASSERT_THROW(mode != mapped_file_mode::create);
+
+	nifti_1_header	hdr = nifti_aux::read_nifti_header(filename);
+	if(hdr.sizeof_hdr != sizeof(nifti_1_header))
+	{
+		// Заголовок с другим порядком байтов: данные нельзя использовать без перестановки байтов
+		throw invalid_argument("map_nifti: invalid header or byte order differs from the platform byte order");
+	}
+	XRAD_ASSERT_THROW(hdr.dim[0] > 0 && hdr.dim[0] < 8);
+	if(hdr.datatype != nifti_datatype<value_type>() || size_t(hdr.bitpix) != sizeof(value_type)*CHAR_BIT)
+	{
+		throw invalid_argument(ssprintf("map_nifti: file data type %d (%d bits) does not match array element type %s",
+				int(hdr.datatype), int(hdr.bitpix),
+				EnsureType<const char*>(typeid(value_type).name())));
+	}
+
+	index_vector	sizes(hdr.dim[0]);
+	scales.realloc(hdr.dim[0]);
+	std::copy(hdr.dim + 1, hdr.dim + sizes.size() + 1, sizes.rbegin());
+	std::copy(hdr.pixdim + 1, hdr.pixdim + scales.size() + 1, scales.rbegin());
+
+	wstring	data_filename = filename;
+	if(!strcmp(hdr.magic, "ni1"))
+		data_filename = file_path(filename) + wpath_separator() + filename_without_extension(filename) + L".img";
+	else
+		XRAD_ASSERT_THROW(!strcmp(hdr.magic, "n+1"));
+
+	return MapRawFile<ARR>(data_filename, sizes, mode, file_size_t(hdr.vox_offset));
+}
+
+XRAD_END
+
+#endif // nifti_mapped_data_array_h__
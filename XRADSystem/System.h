@@ -10,6 +10,7 @@
 #include "Sources/System/FileNameOperations.h"
 #include "Sources/System/FileNamePatternMatch.h"
 #include "Sources/System/FileSystem.h"
+#include "Sources/System/MappedFile.h"
 #include "Sources/System/xrad_fopen.h"
 
 //--------------------------------------------------------------